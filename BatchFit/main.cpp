@@ -0,0 +1,479 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Batch diode fitter. Fit every run in a set of sweep
+ *               files, directories of sweep files, or ROOT archives
+ *               of many runs and record the results in the run 
+ *               index. The files are read on the main thread, ROOT
+ *               I/O is not thread safe, and the fits are farmed out
+ *               to a work stealing thread pool with one DiodeFit per
+ *               worker.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <csignal>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/// Root includes http://root.cern.ch
+#include <TApplication.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "UserSignals.hh"
+#include "DiodeFit.hh"
+#include "SweepFile.hh"
+#include "RunIndex.hh"
+#include "RegionDetect.hh"
+#include "ThreadPool.hh"
+
+// UserSignals cleans this up, there is none here.
+TApplication *theApp = NULL;
+
+// My variables. 
+const  double        Version   = 1.0;
+static CLogger*      LogPtr;
+
+extern char         *optarg;
+extern int          optind;
+static Int_t        verbose     = 0;
+static uint32_t     NThreads    = 0;
+static int          Model       = DiodeFit::kShockley;
+static double       Temperature = 293.15;
+static bool         SkipFitted  = false;
+static bool         AutoWindow  = true;
+static std::string  IndexFile;
+
+/// Per thread fitter and scratch.
+struct Worker {
+    DiodeFit            *Fit;
+    RegionDetect        *Regions;
+    std::vector<double> v, i;     // Points inside the fit window
+};
+
+/*
+ * Runs are read and fit this many at a time so that a large archive
+ * does not have to fit in memory.
+ */
+const size_t kBatchRuns = 256;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Help
+ *
+ * Description : provides user with help if needed.
+ *
+ * Inputs : none
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Help(void)
+{
+    SET_DEBUG_STACK;
+    cout << "********************************************" << endl;
+    cout << "* Batch fit of IV sweeps.                  *" << endl;
+    cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
+    cout << "* BatchFit [options] file|dir ...          *" << endl;
+    cout << "* Available options are :                  *" << endl;
+    cout << "*     -h Help                              *" << endl;
+    cout << "*     -v verbose level (integer)           *" << endl;
+    cout << "*     -j threads, default one per core     *" << endl;
+    cout << "*     -m model 0 Shockley, 1 Is,n,Rs,Rsh   *" << endl;
+    cout << "*     -T junction temperature, K           *" << endl;
+    cout << "*     -i index file, default index.csv in  *" << endl;
+    cout << "*        the first directory given         *" << endl;
+    cout << "*     -s skip runs already fit with model  *" << endl;
+    cout << "*     -w fit the whole curve, no windowing *" << endl;
+    cout << "*                                          *" << endl;
+    cout << "********************************************" << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name :  ProcessCommandLineArgs
+ *
+ * Description : Loop over all command line arguments
+ *               and parse them into useful data.
+ *
+ * Inputs : command line arguments.
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static void ProcessCommandLineArgs(int argc, char **argv)
+{
+    int option;
+    SET_DEBUG_STACK;
+    do
+    {
+        option = getopt(argc, argv, "hHv:V:j:m:T:i:sw");
+        switch(option)
+        {
+        case 'h':
+        case 'H':
+            Help();
+            exit(0);
+            break;
+	case 'v':
+        case 'V':
+            verbose = atoi(optarg);
+            break;
+	case 'j':
+	    NThreads = atoi(optarg);
+	    break;
+	case 'm':
+	    Model = atoi(optarg);
+	    break;
+	case 'T':
+	    Temperature = atof(optarg);
+	    break;
+	case 'i':
+	    IndexFile = optarg;
+	    break;
+	case 's':
+	    SkipFitted = true;
+	    break;
+	case 'w':
+	    AutoWindow = false;
+	    break;
+        }
+    } while(option != -1);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : IsSweep
+ *
+ * Description : Does the file name look like something IVCurve
+ *               would have saved?
+ *
+ * Inputs : name - file name
+ *
+ * Returns : true if so
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static bool IsSweep(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (ext == NULL) return false;
+    return ((strcmp(ext, ".csv") == 0) || (strcmp(ext, ".tsv") == 0) ||
+	    (strcmp(ext, ".txt") == 0) || (strcmp(ext, ".dat") == 0) ||
+	    (strcmp(ext, ".root") == 0));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FindRuns
+ *
+ * Description : Expand a command line argument into run names. A
+ *               directory gives every sweep file in it, in name 
+ *               order, a ROOT archive every graph in it.
+ *
+ * Inputs : path - file or directory
+ *          Runs - names appended
+ *
+ * Returns : true if path could be read
+ *
+ * Error Conditions : path does not exist
+ *
+ *******************************************************************
+ */
+static bool FindRuns(const char *path, std::vector<std::string> &Runs)
+{
+    SET_DEBUG_STACK;
+    struct stat              st;
+    DIR                      *dir;
+    struct dirent            *de;
+    std::vector<std::string> files;
+    std::string              name;
+
+    if (stat(path, &st) != 0)
+    {
+	LogPtr->Log("# BatchFit: %s does not exist.\n", path);
+	return false;
+    }
+    if (!S_ISDIR(st.st_mode))
+    {
+	return SweepFile::List(path, Runs);
+    }
+    if ((dir = opendir(path)) == NULL)
+    {
+	LogPtr->Log("# BatchFit: can not open %s.\n", path);
+	return false;
+    }
+    while ((de = readdir(dir)) != NULL)
+    {
+	if (IsSweep(de->d_name) && (strcmp(de->d_name, "index.csv") != 0))
+	{
+	    name = path;
+	    name += "/";
+	    name += de->d_name;
+	    files.push_back(name);
+	}
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    for (size_t i=0; i<files.size(); i++)
+    {
+	SweepFile::List(files[i].c_str(), Runs);
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitOne
+ *
+ * Description : Fit one run on a worker. Unless told otherwise only
+ *               the points in the fit window RegionDetect finds are
+ *               used, the compliance limit is not known here so it
+ *               is found from the curve.
+ *
+ * Inputs : w    - worker
+ *          x, y - run
+ *          p    - result
+ *
+ * Returns : true if the fit converged
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static bool FitOne(Worker &w, const std::vector<double> &x,
+		   const std::vector<double> &y, DiodeParams &p)
+{
+    const double *V = &x[0];
+    const double *I = &y[0];
+    uint32_t     N  = x.size();
+    double       lo, hi;
+
+    if (AutoWindow && w.Regions->Analyze(V, I, N) &&
+	w.Regions->Window(Model == DiodeFit::kFull, lo, hi))
+    {
+	N = RegionDetect::Select(V, I, N, lo, hi, w.v, w.i);
+	V = &w.v[0];
+	I = &w.i[0];
+    }
+    if (Model == DiodeFit::kFull)
+    {
+	return w.Fit->FitFull(V, I, N, p);
+    }
+    return w.Fit->FitShockley(V, I, N, p);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitRuns
+ *
+ * Description : Read a batch of runs then fit them on the pool.
+ *
+ * Inputs : Runs   - run names
+ *          first  - first run of the batch
+ *          last   - one past the last
+ *          Pool   - workers
+ *          Work   - one per pool thread
+ *          Index  - results go here
+ *
+ * Returns : number of fits that converged
+ *
+ * Error Conditions : runs that can not be read are logged and skipped.
+ *
+ *******************************************************************
+ */
+static size_t FitRuns(const std::vector<std::string> &Runs,
+		      size_t first, size_t last, ThreadPool &Pool,
+		      std::vector<Worker> &Work, RunIndex &Index)
+{
+    SET_DEBUG_STACK;
+    const size_t                     n = last - first;
+    std::vector< std::vector<double> > x(n), y(n);
+    std::vector<DiodeParams>         p(n);
+    std::vector<char>                ok(n, 0);
+    std::vector<char>                read(n, 0);
+    size_t                           good = 0;
+
+    for (size_t i=0; i<n; i++)
+    {
+	read[i] = SweepFile::Read(Runs[first+i].c_str(), x[i], y[i]);
+	if (!read[i])
+	{
+	    continue;
+	}
+	Pool.Submit([&, i](uint32_t w) {
+		ok[i] = FitOne(Work[w], x[i], y[i], p[i]);
+	    });
+    }
+    Pool.Wait();
+
+    for (size_t i=0; i<n; i++)
+    {
+	if (!read[i])
+	{
+	    continue;
+	}
+	if (ok[i])
+	{
+	    good++;
+	}
+	else
+	{
+	    LogPtr->Log("# BatchFit: %s did not converge.\n",
+			Runs[first+i].c_str());
+	}
+	if (verbose > 0)
+	{
+	    LogPtr->Log("# %s Is = %g n = %g Rs = %g Rsh = %g chi2/ndf = %g/%d\n",
+			Runs[first+i].c_str(), p[i].Is, p[i].n, p[i].Rs,
+			p[i].Rsh, p[i].Chi2, p[i].NDF);
+	}
+	Index.Update(Runs[first+i].c_str(), Model, p[i]);
+    }
+    return good;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : main
+ *
+ * Description : It all starts here:
+ *               - Process any command line arguments
+ *               - Find the runs
+ *               - Fit them in batches
+ *               - Write the index
+ *
+ * Inputs : command line arguments
+ *
+ * Returns : exit code
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int main(int argc, char **argv)
+{
+    std::vector<std::string> Runs, todo;
+    std::vector<Worker>      Work;
+    struct stat              st;
+    struct timespec          t0, t1;
+    RunIndexEntry            *e;
+    size_t                   good = 0;
+
+    LastFile = (char *) __FILE__;
+    LastLine = __LINE__;
+
+    ProcessCommandLineArgs(argc, argv);
+    if ((optind >= argc) ||
+	((Model != DiodeFit::kShockley) && (Model != DiodeFit::kFull)))
+    {
+	Help();
+	return -1;
+    }
+    SetSignals();
+    LogPtr = new CLogger("BatchFit.log", "BatchFit", Version);
+    LogPtr->SetVerbose(verbose);
+
+    if (IndexFile.empty())
+    {
+	if ((stat(argv[optind], &st) == 0) && S_ISDIR(st.st_mode))
+	{
+	    IndexFile = std::string(argv[optind]) + "/index.csv";
+	}
+	else
+	{
+	    IndexFile = "index.csv";
+	}
+    }
+    for (int i=optind; i<argc; i++)
+    {
+	FindRuns(argv[i], Runs);
+    }
+
+    RunIndex Index(IndexFile.c_str());
+    Index.Read();
+    for (size_t i=0; i<Runs.size(); i++)
+    {
+	e = Index.Find(Runs[i].c_str());
+	if (SkipFitted && e && (e->Model == Model) && e->Fit.Converged)
+	{
+	    continue;
+	}
+	todo.push_back(Runs[i]);
+    }
+
+    ThreadPool Pool(NThreads);
+    Work.resize(Pool.NThreads());
+    for (uint32_t i=0; i<Pool.NThreads(); i++)
+    {
+	Work[i].Fit     = new DiodeFit(Temperature);
+	Work[i].Regions = new RegionDetect(Temperature);
+    }
+    LogPtr->Log("# BatchFit: %d runs to fit, model %d, %d threads, index %s\n",
+		(int) todo.size(), Model, (int) Pool.NThreads(),
+		IndexFile.c_str());
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t i=0; i<todo.size(); i+=kBatchRuns)
+    {
+	good += FitRuns(todo, i, std::min(i + kBatchRuns, todo.size()),
+			Pool, Work, Index);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    Index.Write();
+    LogPtr->Log("# BatchFit: %d of %d converged in %.3f s.\n",
+		(int) good, (int) todo.size(),
+		(t1.tv_sec - t0.tv_sec) + 1.0e-9*(t1.tv_nsec - t0.tv_nsec));
+
+    for (size_t i=0; i<Work.size(); i++)
+    {
+	delete Work[i].Fit;
+	delete Work[i].Regions;
+    }
+    Terminate(0);
+}
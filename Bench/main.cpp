@@ -0,0 +1,763 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Benchmarks for the sweep path, to catch a slow down
+ *               before it reaches the bench. Each stage on its own,
+ *
+ *                 PlanPoints     - sweep plan from the settings
+ *                 Acquire        - step, read and average, per NAVG
+ *                 StoreAdd       - points into the sample store
+ *                 Save/Load      - CSV, ROOT and the binary GPIB trace
+ *                 Fit            - Shockley and full model, the
+ *                                  compiled fitter against TF1
+ *                 Derived        - dI/dV, Rdyn and log|I|
+ *                 Decimate       - min/max pyramid, built at once or
+ *                                  a point at a time as it is live,
+ *                                  and the envelope drawn from it
+ *
+ *               and a whole sweep on the simulated instruments with
+ *               no settle time, reported in points per second with
+ *               the time per point spent in each stage,
+ *
+ *                 acquire_us - Instruments::StepAndAcquire
+ *                 store_us   - SampleStore::Add
+ *                 derived_us - DerivedChannels::Add
+ *                 display_us - graph and pyramid update
+ *
+ *               Google Benchmark runs it, the usual options apply,
+ *               e.g. --benchmark_filter=Fit to run the fits only or
+ *               --benchmark_format=json to keep a baseline.
+ *
+ * Restrictions/Limitations :
+ *               Scratch files are written to /tmp.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               https://github.com/google/benchmark
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+#include <time.h>
+
+/// Google benchmark
+#include <benchmark/benchmark.h>
+
+/// Root includes http://root.cern.ch
+#include <TApplication.h>
+#include <TFile.h>
+#include <TF1.h>
+#include <TGraphErrors.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "UserSignals.hh"
+#include "Instruments.hh"
+#include "SimBackend.hh"
+#include "SampleStore.hh"
+#include "SweepFile.hh"
+#include "TraceRecorder.hh"
+#include "TraceReplay.hh"
+#include "DiodeFit.hh"
+#include "DerivedChannels.hh"
+#include "MinMaxPyramid.hh"
+
+// UserSignals cleans this up, there is none here.
+TApplication *theApp = NULL;
+
+// My variables.
+const  double        Version   = 1.0;
+static CLogger*      LogPtr;
+static std::string   Scratch;
+
+/* Sweep the data is made on, volts. */
+const double kBenchStart = -1.0;
+const double kBenchStop  =  0.8;
+/* Fits look at the forward points above this. */
+const double kFitFrom    =  0.05;
+/* Pixel columns the envelope is drawn for. */
+const uint32_t kPixels   = 1000;
+const double   kTemperature = 293.15;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : MakeCurve
+ *
+ * Description : N points of the simulated diode evenly from
+ *               kBenchStart to kBenchStop, one reading each.
+ *
+ * Inputs : N    - points
+ *          V, I - filled
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void MakeCurve(uint32_t N, std::vector<double> &V,
+		      std::vector<double> &I)
+{
+    SimBackend sim(SimBackend::SmallSignal(), kTemperature);
+
+    sim.MeterFunction(true);
+    sim.SourceLimit(0.1);
+    V.resize(N);
+    I.resize(N);
+    for (uint32_t k=0; k<N; k++)
+    {
+	V[k] = kBenchStart + (kBenchStop - kBenchStart)*k/(N - 1);
+	sim.SourceVoltage(V[k]);
+	I[k] = sim.MeterRead();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Forward
+ *
+ * Description : The points of a curve above kFitFrom.
+ *
+ * Inputs : N    - points in the whole curve
+ *          V, I - filled with the forward part
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Forward(uint32_t N, std::vector<double> &V,
+		    std::vector<double> &I)
+{
+    std::vector<double> v, i;
+
+    MakeCurve(N, v, i);
+    V.clear();
+    I.clear();
+    for (uint32_t k=0; k<N; k++)
+    {
+	if (v[k] < kFitFrom) continue;
+	V.push_back(v[k]);
+	I.push_back(i[k]);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FillStore
+ *
+ * Description : A sample store holding a curve.
+ *
+ * Inputs : N     - points
+ *          Store - filled
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void FillStore(uint32_t N, SampleStore &Store)
+{
+    std::vector<double> V, I;
+
+    MakeCurve(N, V, I);
+    Store.Reserve(N);
+    for (uint32_t k=0; k<N; k++)
+    {
+	Store.Add(V[k], I[k], 1.0e-4*fabs(I[k]), 1, 0.0, 1.0e9 + k,
+		  SampleStore::kFine);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SetSweep
+ *
+ * Description : Settings for a sweep on the simulated instruments,
+ *               coarse steps with fine steps through the knee and
+ *               no settle time.
+ *
+ * Inputs : inst - instruments
+ *          NAVG - readings per point
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void SetSweep(Instruments &inst, uint32_t NAVG)
+{
+    inst.Start(kBenchStart);
+    inst.Stop(kBenchStop);
+    inst.Step(0.01);
+    inst.Fine(0.001);
+    inst.Window(0.3);
+    inst.FineOnly(false);
+    inst.SettleTime(0.0);
+    inst.SetCurrentLimit(0.1);
+    inst.NAVG(NAVG);
+    inst.Policy(Instruments::kComplianceContinue);
+    inst.Direction(Instruments::kSweepUp);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Since
+ *
+ * Description : Time since t0, and t0 moved up to now.
+ *
+ * Inputs : t0 - start
+ *
+ * Returns : seconds
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static inline double Since(struct timespec &t0)
+{
+    struct timespec now;
+    double          dt;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    dt = (double) (now.tv_sec - t0.tv_sec) +
+	1.0e-9 * (double) (now.tv_nsec - t0.tv_nsec);
+    t0 = now;
+    return dt;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FullDiode
+ *
+ * Description : TF1 wrapper around the full diode model, the same
+ *               as the GUI fits with.
+ *
+ * Inputs : x   - voltage
+ *          par - Is, n, Rs, Rsh, T
+ *
+ * Returns : current
+ *
+ * Error Conditions : NONE
+ *
+ *******************************************************************
+ */
+static Double_t FullDiode(Double_t *x, Double_t *par)
+{
+    DiodeFit    fit(par[4]);
+    DiodeParams p;
+
+    p.Is  = par[0];
+    p.n   = par[1];
+    p.Rs  = par[2];
+    p.Rsh = par[3];
+    return fit.Full(x[0], p);
+}
+
+/* *****************************************************
+ * Sweep plan and acquisition
+ * *****************************************************/
+
+/* Plan a fine only sweep, the argument is the step in uV. */
+static void BM_PlanPoints(benchmark::State &state)
+{
+    Instruments inst(new SimBackend(SimBackend::SmallSignal()));
+    uint32_t    n = 0;
+
+    SetSweep(inst, 1);
+    inst.FineOnly(true);
+    inst.Fine(1.0e-6*state.range(0));
+    for (auto _ : state)
+    {
+	n = inst.PlanPoints();
+	benchmark::DoNotOptimize(n);
+    }
+    state.counters["points"] = n;
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_PlanPoints)->Arg(1000)->Arg(100)->Arg(10);
+
+/* One point, set, read NAVG times and average. Items are readings. */
+static void BM_Acquire(benchmark::State &state)
+{
+    const uint32_t navg = state.range(0);
+    Instruments    inst(new SimBackend(SimBackend::SmallSignal()));
+
+    SetSweep(inst, navg);
+    inst.Setup(true);
+    inst.Reset();
+    for (auto _ : state)
+    {
+	inst.StepAndAcquire();
+	benchmark::DoNotOptimize(inst.Result());
+	if (inst.Done())
+	{
+	    state.PauseTiming();
+	    inst.Reset();
+	    state.ResumeTiming();
+	}
+    }
+    state.SetItemsProcessed(state.iterations()*navg);
+}
+BENCHMARK(BM_Acquire)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+/* Points into a store sized from the plan. */
+static void BM_StoreAdd(benchmark::State &state)
+{
+    const uint32_t      n = state.range(0);
+    std::vector<double> V, I;
+    SampleStore         Store;
+
+    MakeCurve(n, V, I);
+    for (auto _ : state)
+    {
+	Store.Reserve(n);
+	for (uint32_t k=0; k<n; k++)
+	{
+	    Store.Add(V[k], I[k], 1.0e-4*fabs(I[k]), 4, 0.0, 1.0e9 + k,
+		      SampleStore::kFine);
+	}
+	benchmark::DoNotOptimize(Store.N());
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_StoreAdd)->RangeMultiplier(8)->Range(1<<10, 1<<16);
+
+/* *****************************************************
+ * Save and load
+ * *****************************************************/
+
+/* Text the way the headless runner streams it. */
+static void BM_SaveCSV(benchmark::State &state)
+{
+    const std::string file = Scratch + ".csv";
+    SampleStore       Store;
+
+    FillStore(state.range(0), Store);
+    for (auto _ : state)
+    {
+	std::ofstream out(file.c_str());
+	for (uint32_t k=0; k<Store.N(); k++)
+	{
+	    Store.Write(out, k);
+	}
+	out.close();
+    }
+    state.SetItemsProcessed(state.iterations()*Store.N());
+}
+BENCHMARK(BM_SaveCSV)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LoadCSV(benchmark::State &state)
+{
+    const std::string   file = Scratch + ".csv";
+    std::vector<double> x, y;
+    SampleStore         Store;
+
+    FillStore(state.range(0), Store);
+    {
+	std::ofstream out(file.c_str());
+	for (uint32_t k=0; k<Store.N(); k++) Store.Write(out, k);
+    }
+    for (auto _ : state)
+    {
+	SweepFile::ReadText(file.c_str(), x, y);
+	benchmark::DoNotOptimize(x.size());
+    }
+    state.SetItemsProcessed(state.iterations()*Store.N());
+}
+BENCHMARK(BM_LoadCSV)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* The IVCurve graph as IVCurve::Save writes it. */
+static void BM_SaveROOT(benchmark::State &state)
+{
+    const std::string file = Scratch + ".root";
+    SampleStore       Store;
+
+    FillStore(state.range(0), Store);
+    for (auto _ : state)
+    {
+	TFile        out(file.c_str(), "RECREATE", "IVCurve Bench");
+	TGraphErrors g;
+	Store.View(&g);
+	g.SetName("IVCurve");
+	g.Write();
+	out.Close();
+    }
+    state.SetItemsProcessed(state.iterations()*Store.N());
+}
+BENCHMARK(BM_SaveROOT)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LoadROOT(benchmark::State &state)
+{
+    const std::string   file = Scratch + ".root";
+    std::vector<double> x, y;
+    SampleStore         Store;
+
+    FillStore(state.range(0), Store);
+    {
+	TFile        out(file.c_str(), "RECREATE", "IVCurve Bench");
+	TGraphErrors g;
+	Store.View(&g);
+	g.SetName("IVCurve");
+	g.Write();
+	out.Close();
+    }
+    for (auto _ : state)
+    {
+	SweepFile::ReadROOT(file.c_str(), x, y);
+	benchmark::DoNotOptimize(x.size());
+    }
+    state.SetItemsProcessed(state.iterations()*Store.N());
+}
+BENCHMARK(BM_LoadROOT)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* A GPIB trace of n points, set and read each. */
+static void BM_SaveBinary(benchmark::State &state)
+{
+    const std::string file = Scratch + ".trc";
+    const uint32_t    n    = state.range(0);
+
+    for (auto _ : state)
+    {
+	TraceRecorder rec(new SimBackend(SimBackend::SmallSignal()),
+			  file.c_str());
+	rec.MeterFunction(true);
+	for (uint32_t k=0; k<n; k++)
+	{
+	    rec.SourceVoltage(kBenchStart + 1.0e-3*k);
+	    benchmark::DoNotOptimize(rec.MeterRead());
+	}
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_SaveBinary)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LoadBinary(benchmark::State &state)
+{
+    const std::string file = Scratch + ".trc";
+    const uint32_t    n    = state.range(0);
+
+    {
+	TraceRecorder rec(new SimBackend(SimBackend::SmallSignal()),
+			  file.c_str());
+	rec.MeterFunction(true);
+	for (uint32_t k=0; k<n; k++)
+	{
+	    rec.SourceVoltage(kBenchStart + 1.0e-3*k);
+	    rec.MeterRead();
+	}
+    }
+    for (auto _ : state)
+    {
+	TraceReplay play(file.c_str(), false);
+	play.MeterFunction(true);
+	for (uint32_t k=0; k<n; k++)
+	{
+	    play.SourceVoltage(kBenchStart + 1.0e-3*k);
+	    benchmark::DoNotOptimize(play.MeterRead());
+	}
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_LoadBinary)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* *****************************************************
+ * Fits, cold start on the forward points.
+ * *****************************************************/
+
+static void BM_FitShockleyNative(benchmark::State &state)
+{
+    std::vector<double> V, I;
+    DiodeFit            fit(kTemperature);
+    DiodeParams         p;
+
+    Forward(state.range(0), V, I);
+    for (auto _ : state)
+    {
+	fit.FitShockley(&V[0], &I[0], V.size(), p);
+	benchmark::DoNotOptimize(p.Is);
+    }
+    state.counters["lm_iterations"] = p.Iterations;
+}
+BENCHMARK(BM_FitShockleyNative)->RangeMultiplier(4)->Range(256, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_FitFullNative(benchmark::State &state)
+{
+    std::vector<double> V, I;
+    DiodeFit            fit(kTemperature);
+    DiodeParams         p;
+
+    Forward(state.range(0), V, I);
+    for (auto _ : state)
+    {
+	fit.FitFull(&V[0], &I[0], V.size(), p);
+	benchmark::DoNotOptimize(p.Is);
+    }
+    state.counters["lm_iterations"] = p.Iterations;
+}
+BENCHMARK(BM_FitFullNative)->RangeMultiplier(4)->Range(256, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+/* The Minuit fit the GUI does with FitEngine 0. */
+static void BM_FitShockleyTF1(benchmark::State &state)
+{
+    std::vector<double> V, I;
+    TF1 f("BenchShockley", "[0]*(exp(x/[1])-1.0)", kFitFrom, kBenchStop);
+
+    Forward(state.range(0), V, I);
+    TGraph g(V.size(), &V[0], &I[0]);
+    for (auto _ : state)
+    {
+	f.SetParameter(0, 1.0e-3);
+	f.SetParameter(1, 0.0253);
+	g.Fit(&f, "QN", "", kFitFrom, kBenchStop);
+	benchmark::DoNotOptimize(f.GetParameter(0));
+    }
+}
+BENCHMARK(BM_FitShockleyTF1)->RangeMultiplier(4)->Range(256, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+/* Minuit on the full model from the GUI's starting point. */
+static void BM_FitFullTF1(benchmark::State &state)
+{
+    std::vector<double> V, I;
+    TF1 f("BenchFull", FullDiode, kFitFrom, kBenchStop, 5);
+
+    Forward(state.range(0), V, I);
+    TGraph g(V.size(), &V[0], &I[0]);
+    f.FixParameter(4, kTemperature);
+    for (auto _ : state)
+    {
+	f.SetParameters(1.0e-12, 1.0, 1.0, 1.0e9, kTemperature);
+	g.Fit(&f, "QN", "", kFitFrom, kBenchStop);
+	benchmark::DoNotOptimize(f.GetParameter(0));
+    }
+}
+BENCHMARK(BM_FitFullTF1)->RangeMultiplier(4)->Range(256, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+/* *****************************************************
+ * Derived channels and the display
+ * *****************************************************/
+
+static void BM_Derived(benchmark::State &state)
+{
+    const uint32_t      n = state.range(0);
+    std::vector<double> V, I, targets;
+    DerivedChannels     d;
+
+    MakeCurve(n, V, I);
+    targets.push_back(1.0e-6);
+    targets.push_back(1.0e-4);
+    targets.push_back(1.0e-3);
+    d.VfTargets(targets);
+    for (auto _ : state)
+    {
+	d.Reset();
+	for (uint32_t k=0; k<n; k++) d.Add(V[k], I[k]);
+	d.End();
+	benchmark::DoNotOptimize(d.NDerived());
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_Derived)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* Whole data set at once, as on a load. */
+static void BM_DecimateBuild(benchmark::State &state)
+{
+    const uint32_t      n = state.range(0);
+    std::vector<double> V, I;
+    std::vector<double> ox(MinMaxPyramid::MaxOut(kPixels));
+    std::vector<double> oy(MinMaxPyramid::MaxOut(kPixels));
+    MinMaxPyramid       pyr;
+
+    MakeCurve(n, V, I);
+    for (auto _ : state)
+    {
+	pyr.Clear();
+	pyr.Update(&V[0], &I[0], n);
+	benchmark::DoNotOptimize(pyr.Envelope(&V[0], &I[0], kBenchStart,
+					      kBenchStop, kPixels,
+					      &ox[0], &oy[0]));
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_DecimateBuild)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* A point at a time, as during a live sweep. */
+static void BM_DecimateLive(benchmark::State &state)
+{
+    const uint32_t      n = state.range(0);
+    std::vector<double> V, I;
+    MinMaxPyramid       pyr;
+
+    MakeCurve(n, V, I);
+    for (auto _ : state)
+    {
+	pyr.Clear();
+	for (uint32_t k=1; k<=n; k++) pyr.Update(&V[0], &I[0], k);
+	benchmark::DoNotOptimize(pyr.Levels());
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+BENCHMARK(BM_DecimateLive)->RangeMultiplier(8)->Range(1<<10, 1<<16)
+    ->Unit(benchmark::kMicrosecond);
+
+/* A redraw zoomed on the knee. */
+static void BM_Envelope(benchmark::State &state)
+{
+    const uint32_t      n = state.range(0);
+    std::vector<double> V, I;
+    std::vector<double> ox(MinMaxPyramid::MaxOut(kPixels));
+    std::vector<double> oy(MinMaxPyramid::MaxOut(kPixels));
+    MinMaxPyramid       pyr;
+
+    MakeCurve(n, V, I);
+    pyr.Update(&V[0], &I[0], n);
+    for (auto _ : state)
+    {
+	benchmark::DoNotOptimize(pyr.Envelope(&V[0], &I[0], 0.3, 0.7,
+					      kPixels, &ox[0], &oy[0]));
+    }
+}
+BENCHMARK(BM_Envelope)->RangeMultiplier(8)->Range(1<<10, 1<<16);
+
+/* *****************************************************
+ * End to end
+ * *****************************************************/
+
+/*
+ * A whole sweep on the simulated instruments, each point through
+ * the store, the derived channels and the display as TimeoutProc
+ * does it. Items are points.
+ */
+static void BM_Sweep(benchmark::State &state)
+{
+    const uint32_t  navg = state.range(0);
+    std::vector<double> targets;
+    Instruments     inst(new SimBackend(SimBackend::SmallSignal()));
+    SampleStore     Store;
+    DerivedChannels d;
+    MinMaxPyramid   pyr;
+    TGraphErrors    g;
+    struct timespec t;
+    double          acquire = 0.0, store = 0.0, derived = 0.0;
+    double          display = 0.0;
+    uint64_t        points  = 0;
+
+    targets.push_back(1.0e-6);
+    targets.push_back(1.0e-3);
+    d.VfTargets(targets);
+    SetSweep(inst, navg);
+    inst.Setup(true);
+    for (auto _ : state)
+    {
+	inst.Reset();
+	Store.Reserve(inst.PlanPoints());
+	d.Reset();
+	pyr.Clear();
+	g.Set(0);
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	do
+	{
+	    inst.StepAndAcquire();
+	    acquire += Since(t);
+	    Store.Add(inst.Voltage(), inst.Result(), inst.StdDev(),
+		      inst.NSamples(), inst.SampleDelay(), inst.TimeStamp(),
+		      inst.PointType(), inst.Branch(), inst.PairIndex());
+	    store   += Since(t);
+	    d.Add(inst.Voltage(), inst.Result());
+	    derived += Since(t);
+	    Store.View(&g, 1.0, SampleStore::kUp);
+	    pyr.Update(g.GetX(), g.GetY(), g.GetN());
+	    display += Since(t);
+	} while (!inst.Done());
+	d.End();
+	points += Store.N();
+    }
+    state.SetItemsProcessed(points);
+    state.counters["points"]     = Store.N();
+    state.counters["acquire_us"] = 1.0e6*acquire/points;
+    state.counters["store_us"]   = 1.0e6*store/points;
+    state.counters["derived_us"] = 1.0e6*derived/points;
+    state.counters["display_us"] = 1.0e6*display/points;
+}
+BENCHMARK(BM_Sweep)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
+
+/**
+ ******************************************************************
+ *
+ * Function Name : main
+ *
+ * Description : Logger for the instruments, then the benchmarks.
+ *
+ * Inputs : command line arguments, see Google Benchmark
+ *
+ * Returns : 0 on success
+ *
+ * Error Conditions : bad arguments
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int main(int argc, char **argv)
+{
+    char name[64];
+
+    LastFile = (char *) __FILE__;
+    LastLine = __LINE__;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+	return 1;
+    }
+    SetSignals();
+    // The instruments log every point, the log is part of the cost.
+    LogPtr = new CLogger("Bench.log", "Bench", Version);
+    LogPtr->SetVerbose(0);
+    snprintf(name, sizeof(name), "/tmp/IVBench_%d", (int) getpid());
+    Scratch = name;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    unlink((Scratch + ".csv").c_str());
+    unlink((Scratch + ".root").c_str());
+    unlink((Scratch + ".trc").c_str());
+    delete LogPtr;
+    return 0;
+}
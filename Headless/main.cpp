@@ -0,0 +1,942 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : main.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Headless sweep runner. Takes one I-V sweep with the
+ *               same Instruments engine as the GUI, set up from the
+ *               .IVCurve resources and an optional recipe file on
+ *               top, with no display. Or a queue of recipes back to
+ *               back, see RecipeQueue, picking up from the queue
+ *               checkpoint if an earlier run was stopped. The
+ *               instruments are opened once for the whole queue.
+ *               Each point is written to the
+ *               output file as it comes in, the finished run can be
+ *               added to a ROOT archive. The exit status tells cron
+ *               or a test executive how it went.
+ *
+ *               0 - sweep complete
+ *               1 - bad command line
+ *               2 - bad configuration or recipe
+ *               3 - instruments would not open or set up
+ *               4 - acquisition or output failed, or a queued
+ *                   sweep failed
+ *               5 - stopped by a signal, the data so far is kept
+ *
+ *               With -s the runner listens on a control socket, see
+ *               ControlServer. Points are streamed to subscribers,
+ *               stop and status work at any time. With -w as well
+ *               it waits for a start command before sweeping, set
+ *               can change the recipe while it waits.
+ *
+ *               With -g all GPIB traffic is recorded to a trace,
+ *               with -x a trace is played back in place of the 
+ *               instruments, in real time or with -f as fast as it
+ *               goes. See TraceRecorder and TraceReplay.
+ *
+ *               With -m a simulated diode stands in for the part and
+ *               the instruments, see SimBackend. It runs on a clock
+ *               of its own, settle and averaging waits take no real
+ *               time, so a recipe that takes half an hour on the
+ *               bench is done in milliseconds. The output is the
+ *               same every run, for regression tests of the recipe
+ *               library.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+/// Root includes http://root.cern.ch
+#include <TApplication.h>
+#include <TEnv.h>
+#include <TFile.h>
+#include <TGraphErrors.h>
+#include <TSystem.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "UserSignals.hh"
+#include "Instruments.hh"
+#include "Recipe.hh"
+#include "SampleStore.hh"
+#include "RecipeQueue.hh"
+#include "ControlServer.hh"
+#include "ProfileStore.hh"
+#include "KeithleyBackend.hh"
+#include "TraceReplay.hh"
+#include "SimBackend.hh"
+
+// UserSignals cleans this up, there is none here.
+TApplication *theApp = NULL;
+
+// My variables. 
+const  double        Version   = 1.0;
+static CLogger*      LogPtr;
+
+extern char         *optarg;
+extern int          optind;
+static Int_t        verbose     = 0;
+static std::string  ConfigFile;
+static std::string  RecipeFile;
+static std::string  OutputFile;
+static std::string  ArchiveFile;
+static std::string  QueueFile;
+static bool         DryRun      = false;
+static std::string  SocketFile;
+static bool         WaitStart   = false;
+static std::string  ProfileFile;
+static bool         AutoTune    = false;
+static std::string  TraceFile;
+static std::string  ReplayFile;
+static bool         ReplayFast  = false;
+static bool         Simulate    = false;
+static ProfileStore *Profiles   = NULL;
+
+/// Exit status
+enum RunStatus {kRunOK=0, kRunUsage, kRunConfig, kRunInstrument,
+		kRunAcquire, kRunInterrupted};
+
+/* Set by SIGINT or SIGTERM, the sweep stops at the next point. */
+static volatile sig_atomic_t StopRequested = 0;
+
+/* Control socket and what it can see, NULL if there is none. */
+static ControlServer     *Control  = NULL;
+static const SampleStore *Active   = NULL;  // Sweep in progress
+static uint32_t          Planned   = 0;
+static Recipe            *Pending  = NULL;  // Waiting for start
+static bool              StartRequested = false;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Help
+ *
+ * Description : provides user with help if needed.
+ *
+ * Inputs : none
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void Help(void)
+{
+    SET_DEBUG_STACK;
+    cout << "********************************************" << endl;
+    cout << "* Headless IV sweep.                       *" << endl;
+    cout << "* Built on "<< __DATE__ << " " << __TIME__ << "*" << endl;
+    cout << "* IVrun [options]                          *" << endl;
+    cout << "* Available options are :                  *" << endl;
+    cout << "*     -h Help                              *" << endl;
+    cout << "*     -v verbose level (integer)           *" << endl;
+    cout << "*     -c resource file, default .IVCurve   *" << endl;
+    cout << "*     -r recipe file, overrides resources  *" << endl;
+    cout << "*     -o output file, default from the     *" << endl;
+    cout << "*        recipe or IV_<date>_<time>.csv    *" << endl;
+    cout << "*     -a ROOT archive to add the run to    *" << endl;
+    cout << "*     -q queue of recipes to run           *" << endl;
+    cout << "*     -n dry run, show the plan and exit   *" << endl;
+    cout << "*     -s control socket                    *" << endl;
+    cout << "*     -w wait for start on the socket      *" << endl;
+    cout << "*     -p part profiles, learn from runs    *" << endl;
+    cout << "*     -t tune each sweep from its profile  *" << endl;
+    cout << "*     -g record GPIB traffic to a trace    *" << endl;
+    cout << "*     -x replay a trace, no instruments    *" << endl;
+    cout << "*     -f replay as fast as possible        *" << endl;
+    cout << "*     -m simulated instruments, no waiting *" << endl;
+    cout << "*                                          *" << endl;
+    cout << "********************************************" << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name :  ProcessCommandLineArgs
+ *
+ * Description : Loop over all command line arguments
+ *               and parse them into useful data.
+ *
+ * Inputs : command line arguments.
+ *
+ * Returns : false on an unknown option
+ *
+ * Error Conditions : none
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static bool ProcessCommandLineArgs(int argc, char **argv)
+{
+    int option;
+    SET_DEBUG_STACK;
+    do
+    {
+        option = getopt(argc, argv, "hHv:V:c:r:o:a:q:ns:wp:tg:x:fm");
+        switch(option)
+        {
+        case 'h':
+        case 'H':
+            Help();
+            exit(kRunOK);
+            break;
+	case 'v':
+        case 'V':
+            verbose = atoi(optarg);
+            break;
+	case 'c':
+	    ConfigFile = optarg;
+	    break;
+	case 'r':
+	    RecipeFile = optarg;
+	    break;
+	case 'o':
+	    OutputFile = optarg;
+	    break;
+	case 'a':
+	    ArchiveFile = optarg;
+	    break;
+	case 'q':
+	    QueueFile = optarg;
+	    break;
+	case 'n':
+	    DryRun = true;
+	    break;
+	case 's':
+	    SocketFile = optarg;
+	    break;
+	case 'w':
+	    WaitStart = true;
+	    break;
+	case 'p':
+	    ProfileFile = optarg;
+	    break;
+	case 't':
+	    AutoTune = true;
+	    break;
+	case 'g':
+	    TraceFile = optarg;
+	    break;
+	case 'x':
+	    ReplayFile = optarg;
+	    break;
+	case 'f':
+	    ReplayFast = true;
+	    break;
+	case 'm':
+	    Simulate = true;
+	    break;
+	case '?':
+	    return false;
+        }
+    } while(option != -1);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : StopSweep
+ *
+ * Description : Signal handler, ask the sweep to stop cleanly so
+ *               the output is closed and the archive written.
+ *
+ * Inputs : sig - signal
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void StopSweep(int sig)
+{
+    StopRequested = 1;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ControlCommand
+ *
+ * Description : Commands from the control socket.
+ *
+ *               stop                  same as a SIGTERM
+ *               status                one line of JSON
+ *               start                 begin, when waiting
+ *               set <key> <value>     change the recipe, when waiting
+ *                                     for start on a single recipe
+ *
+ * Inputs : args  - words of the command
+ *          reply - filled in
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : unknown command, bad setting, wrong state
+ *
+ *******************************************************************
+ */
+static bool ControlCommand(const std::vector<std::string> &args,
+			   std::string &reply)
+{
+    const std::string &cmd = args[0];
+    std::string       value;
+    char              buf[128];
+
+    if (cmd == "stop")
+    {
+	StopRequested = 1;
+	reply = "stopping";
+    }
+    else if (cmd == "status")
+    {
+	snprintf(buf, sizeof(buf), 
+		 "{\"running\":%s,\"points\":%u,\"planned\":%u,"
+		 "\"waiting\":%s}", Active ? "true" : "false",
+		 Active ? Active->N() : 0, Planned,
+		 (WaitStart && !StartRequested) ? "true" : "false");
+	reply = buf;
+    }
+    else if (cmd == "start")
+    {
+	if (!WaitStart || StartRequested)
+	{
+	    reply = "already started";
+	    return false;
+	}
+	StartRequested = true;
+	reply = "started";
+    }
+    else if (cmd == "set")
+    {
+	if (args.size() < 3)
+	{
+	    reply = "set <key> <value>";
+	    return false;
+	}
+	if (!Pending || StartRequested)
+	{
+	    reply = "only before start on a single recipe";
+	    return false;
+	}
+	for (size_t i=2; i<args.size(); i++)
+	{
+	    if (i > 2) value += " ";
+	    value += args[i];
+	}
+	if (!Pending->Set(args[1].c_str(), value.c_str()))
+	{
+	    reply = "bad setting " + args[1];
+	    return false;
+	}
+	reply = args[1] + " " + value;
+    }
+    else
+    {
+	reply = "unknown command " + cmd;
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WaitForStart
+ *
+ * Description : Serve the control socket until a start command, or 
+ *               a stop or a signal.
+ *
+ * Inputs : none
+ *
+ * Returns : true to go ahead
+ *
+ * Error Conditions : stopped while waiting
+ *
+ *******************************************************************
+ */
+static bool WaitForStart(void)
+{
+    const struct timespec nap = {0, 50000000};
+
+    LogPtr->Log("# IVrun: waiting for start on %s\n", SocketFile.c_str());
+    while (!StartRequested && !StopRequested)
+    {
+	Control->Poll();
+	nanosleep(&nap, NULL);
+    }
+    Control->Poll();
+    return !StopRequested;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : RunName
+ *
+ * Description : Name of the run, the output file without directory
+ *               or extension. Used as the key in the archive.
+ *
+ * Inputs : File - output file
+ *
+ * Returns : name
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static std::string RunName(const std::string &File)
+{
+    std::string name = gSystem->BaseName(File.c_str());
+    size_t      dot  = name.rfind('.');
+
+    if (dot != std::string::npos) name.erase(dot);
+    return name;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Archive
+ *
+ * Description : Add the run to a ROOT archive as a graph keyed by
+ *               the run name, the comment as its title. SweepFile
+ *               and BatchFit read these back.
+ *
+ * Inputs : Store  - the data
+ *          r      - recipe
+ *          Name   - key
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : archive could not be opened
+ *
+ *******************************************************************
+ */
+static bool Archive(const SampleStore &Store, const Recipe &r,
+		    const std::string &Name)
+{
+    SET_DEBUG_STACK;
+    TFile        out(ArchiveFile.c_str(), "UPDATE", "IVCurve Archive");
+    TGraphErrors g;
+
+    if (out.IsZombie())
+    {
+	LogPtr->Log("# IVrun: can not open archive %s\n", ArchiveFile.c_str());
+	return false;
+    }
+    Store.View(&g, r.XScale(), SampleStore::kUp);
+    g.SetName(Name.c_str());
+    g.SetTitle(r.Comment.c_str());
+    g.Write(Name.c_str(), TObject::kOverwrite);
+    if (Store.NBranch(SampleStore::kDown) > 0)
+    {
+	TGraphErrors down;
+	std::string  dname = Name + "_down";
+	Store.View(&down, r.XScale(), SampleStore::kDown);
+	down.SetName(dname.c_str());
+	down.SetTitle(r.Comment.c_str());
+	down.Write(dname.c_str(), TObject::kOverwrite);
+	LogPtr->Log("# IVrun: hysteresis area %g over %d pairs.\n",
+		    Store.HysteresisArea(), (int) Store.NPairs());
+    }
+    out.Close();
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Sweep
+ *
+ * Description : Take the sweep. Every point goes to the output as
+ *               soon as it is read and the stream is flushed, so a
+ *               crash loses at most the point in hand. The control
+ *               socket, if any, is served between points.
+ *
+ * Inputs : inst  - instruments, set up
+ *          r     - recipe
+ *          Store - filled
+ *          out   - output
+ *
+ * Returns : exit status
+ *
+ * Error Conditions : acquisition or write failed, signal
+ *
+ *******************************************************************
+ */
+static int Sweep(Instruments &inst, const Recipe &r, SampleStore &Store,
+		 std::ofstream &out)
+{
+    SET_DEBUG_STACK;
+    const double scale = r.XScale();
+    uint32_t     n;
+
+    do
+    {
+	if (StopRequested)
+	{
+	    LogPtr->Log("# IVrun: stopped after %d points.\n",
+			(int) Store.N());
+	    return kRunInterrupted;
+	}
+	if (!inst.StepAndAcquire())
+	{
+	    return kRunAcquire;
+	}
+	n = Store.Add(inst.Voltage(), inst.Result(), inst.StdDev(),
+		      inst.NSamples(), inst.SampleDelay(), inst.TimeStamp(),
+		      inst.PointType(), inst.Branch(), inst.PairIndex());
+	Store.Write(out, n-1, scale);
+	out.flush();
+	if (!out.good())
+	{
+	    LogPtr->Log("# IVrun: write failed.\n");
+	    return kRunAcquire;
+	}
+	if (Control)
+	{
+	    Control->Publish(n-1, scale*Store.SetV()[n-1], 
+			     Store.Mean()[n-1], Store.Sigma()[n-1],
+			     Store.NSamples()[n-1], Store.Time()[n-1],
+			     Store.StepType()[n-1], Store.BranchOf()[n-1]);
+	    Control->Poll();
+	}
+    } while (!inst.Done());
+    return kRunOK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ShowPlan
+ *
+ * Description : Log what a recipe would do.
+ *
+ * Inputs : r - recipe
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void ShowPlan(const Recipe &r)
+{
+    LogPtr->Log("# IVrun: mode %d, %g to %g V, step %g fine %g window %g%s, NAVG %d, settle %g s, limit %g A, compliance policy %d -> %s\n",
+		(int) r.Mode, r.Start, r.Stop, r.Step, r.Fine, r.Window,
+		r.FineOnly ? " fine only" : "", (int) r.NAVG, r.Settle,
+		r.MaxI, (int) r.Compliance, r.Output.c_str());
+    if (r.FineTo > r.FineFrom)
+    {
+	LogPtr->Log("# IVrun: fine steps from %g to %g V\n", r.FineFrom,
+		    r.FineTo);
+    }
+    if (r.Direction != Instruments::kSweepUp)
+    {
+	LogPtr->Log("# IVrun: %s\n",
+		    (r.Direction == Instruments::kSweepUpDown) ?
+		    "up then back down" : "interleaved up and down");
+    }
+    if (r.AutoRange)
+    {
+	LogPtr->Log("# IVrun: meter autoranges\n");
+    }
+    else
+    {
+	LogPtr->Log("# IVrun: meter range locked, resolution %g\n",
+		    r.NoiseTarget);
+    }
+    if (r.Pulsed)
+    {
+	LogPtr->Log("# IVrun: pulsed, %g s on, %g s off at %g V, read at %g s\n",
+		    r.PulseWidth, r.PulseOff, r.PulseBase, r.PulseDelay);
+    }
+    if ((r.DriftPoints > 0) || (r.DriftInterval > 0.0))
+    {
+	LogPtr->Log("# IVrun: drift reference at %g V every %d points or %g s, correction %d\n",
+		    r.DriftReference, (int) r.DriftPoints, r.DriftInterval,
+		    (int) r.DriftCorrect);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Tuned
+ *
+ * Description : The recipe as the part profile would have it, when
+ *               tuning is on. I-V sweeps only.
+ *
+ * Inputs : r - recipe
+ *
+ * Returns : recipe to run
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static Recipe Tuned(const Recipe &r)
+{
+    Recipe t(r);
+
+    if (AutoTune && Profiles && (t.Mode == 3))
+    {
+	Profiles->Tune(t);
+    }
+    return t;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LearnProfile
+ *
+ * Description : Fold a finished I-V sweep into its part profile,
+ *               measuring the settle time while the profile still
+ *               wants it.
+ *
+ * Inputs : inst  - instruments
+ *          Store - sweep
+ *          r     - recipe it was run from
+ *
+ * Returns : none
+ *
+ * Error Conditions : none
+ *
+ *******************************************************************
+ */
+static void LearnProfile(Instruments &inst, const SampleStore &Store,
+			 const Recipe &r)
+{
+    SET_DEBUG_STACK;
+    double From, To, Expected, Settle = NAN;
+
+    if (Profiles->WantsSettle(r.PartKey()) &&
+	ProfileStore::SettleStep(Store, From, To, Expected))
+    {
+	Settle = inst.MeasureSettle(From, To, Expected);
+    }
+    if (Profiles->Learn(r.PartKey(), Store, inst.CurrentLimit(),
+			inst.ComplianceVoltage(), Settle))
+    {
+	Profiles->Save();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : RunRecipe
+ *
+ * Description : One sweep from a recipe on instruments that are
+ *               already open. The instruments are set up again for
+ *               every recipe, the 196 trigger, delay and range come
+ *               from the pulse and range settings as well as the
+ *               mode, and a queue may change any of them.
+ *
+ * Inputs : inst  - instruments
+ *          Given - recipe, tuned from its profile if asked
+ *
+ * Returns : exit status
+ *
+ * Error Conditions : see Sweep
+ *
+ *******************************************************************
+ */
+static int RunRecipe(Instruments &inst, const Recipe &Given)
+{
+    SET_DEBUG_STACK;
+    const Recipe  r(Tuned(Given));
+    SampleStore   Store;
+    std::ofstream out;
+    uint32_t      plan;
+    int           status;
+    double        start;
+
+    if (r.Mode == 0)
+    {
+	// Test mode has nothing to measure.
+	ShowPlan(r);
+	return kRunOK;
+    }
+    r.Apply(&inst);
+    if (!inst.Setup(r.Mode == 3))
+    {
+	LogPtr->Log("# IVrun: instruments did not set up.\n");
+	return kRunInstrument;
+    }
+    inst.Reset();
+    plan = inst.PlanPoints();
+    Store.Reserve(plan);
+    Store.DriftCorrection(r.DriftCorrect);
+
+    out.open(r.Output.c_str());
+    if (!out.is_open())
+    {
+	LogPtr->Log("# IVrun: can not open %s\n", r.Output.c_str());
+	return kRunAcquire;
+    }
+    if (!r.Comment.empty())
+    {
+	out << "# " << r.Comment << endl;
+    }
+    LogPtr->Log("# IVrun: mode %d, %d points planned -> %s\n",
+		(int) r.Mode, (int) plan, r.Output.c_str());
+
+    Active  = &Store;
+    Planned = plan;
+    if (Control) Control->Event("start", r.Output.c_str());
+    start  = inst.Backend()->Elapsed();
+    status = Sweep(inst, r, Store, out);
+    out.close();
+    Active  = NULL;
+    if (Control)
+    {
+	Control->Event((status == kRunOK) ? "done" : "stopped", 
+		       r.Output.c_str());
+	Control->Poll();
+    }
+
+    if (inst.NReference() > 1)
+    {
+	LogPtr->Log("# IVrun: reference drifted %g over %d readings.\n",
+		    Store.ReferenceDrift(), (int) inst.NReference());
+    }
+    if ((Store.N() > 0) && !ArchiveFile.empty() &&
+	!Archive(Store, r, RunName(r.Output)) && (status == kRunOK))
+    {
+	status = kRunAcquire;
+    }
+    if (Profiles && (status == kRunOK) && (r.Mode == 3))
+    {
+	LearnProfile(inst, Store, r);
+    }
+    if (inst.Backend()->Virtual())
+    {
+	LogPtr->Log("# IVrun: %g s on the instrument clock.\n",
+		    inst.Backend()->Elapsed() - start);
+    }
+    LogPtr->Log("# IVrun: %d points, status %d.\n", (int) Store.N(), status);
+    return status;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : OpenBackend
+ *
+ * Description : The instruments on the bus, a trace played back
+ *               in their place or the simulator.
+ *
+ * Inputs : env - resources, for the GPIB addresses and simulator
+ *
+ * Returns : backend, for Instruments to own
+ *
+ * Error Conditions : see Instruments::Error
+ *
+ *******************************************************************
+ */
+static GpibBackend* OpenBackend(TEnv *env)
+{
+    if (!ReplayFile.empty())
+    {
+	return new TraceReplay(ReplayFile.c_str(), !ReplayFast);
+    }
+    if (Simulate)
+    {
+	return SimBackend::Open(env);
+    }
+    return new KeithleyBackend(env->GetValue("Voltmeter.GPIB", 3),
+			       env->GetValue("VoltageSource.GPIB", 14));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : main
+ *
+ * Description : It all starts here:
+ *               - Process any command line arguments
+ *               - Resources, then the recipe
+ *               - Open and set up the instruments
+ *               - Sweep, streaming to the output
+ *               - Archive
+ *
+ * Inputs : command line arguments
+ *
+ * Returns : exit status, see above
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int main(int argc, char **argv)
+{
+    Recipe        r;
+    RecipeQueue   queue;
+    TEnv          *env;
+    int           status;
+    char          stamp[64];
+    time_t        now;
+
+    LastFile = (char *) __FILE__;
+    LastLine = __LINE__;
+
+    if (!ProcessCommandLineArgs(argc, argv) || (optind < argc) ||
+	(WaitStart && SocketFile.empty()) || 
+	(AutoTune && ProfileFile.empty()) || 
+	(ReplayFast && ReplayFile.empty()) ||
+	(Simulate && !ReplayFile.empty()))
+    {
+	Help();
+	return kRunUsage;
+    }
+    SetSignals();
+    signal(SIGINT,  StopSweep);
+    signal(SIGTERM, StopSweep);
+    LogPtr = new CLogger("IVrun.log", "IVrun", Version);
+    LogPtr->SetVerbose(verbose);
+
+    // Same resources as the GUI unless told otherwise.
+    if (ConfigFile.empty())
+    {
+	env = new TEnv(".IVCurve");
+    }
+    else
+    {
+	env = new TEnv("");
+	if (env->ReadFile(ConfigFile.c_str(), kEnvLocal) != 0)
+	{
+	    LogPtr->Log("# IVrun: can not read %s\n", ConfigFile.c_str());
+	    return kRunConfig;
+	}
+    }
+    if (!r.Read(env) || 
+	(!RecipeFile.empty() && !r.Read(RecipeFile.c_str())))
+    {
+	return kRunConfig;
+    }
+    if (!OutputFile.empty())
+    {
+	r.Output = OutputFile;
+    }
+    if (r.Output.empty())
+    {
+	time(&now);
+	strftime(stamp, sizeof(stamp), "IV_%Y%m%d_%H%M%S.csv", 
+		 localtime(&now));
+	r.Output = stamp;
+    }
+    if (!QueueFile.empty() && !queue.Load(QueueFile.c_str(), r))
+    {
+	return kRunConfig;
+    }
+    if (!ProfileFile.empty())
+    {
+	Profiles = new ProfileStore(ProfileFile.c_str());
+	Profiles->Temperature(env->GetValue("IVCurve.Temperature", 293.15));
+    }
+
+    if (DryRun)
+    {
+	if (QueueFile.empty())
+	{
+	    ShowPlan(Tuned(r));
+	}
+	for (uint32_t i=queue.Next(); i<queue.N(); i++)
+	{
+	    ShowPlan(Tuned(queue.Entry(i)));
+	}
+	delete Profiles;
+	delete env;
+	delete LogPtr;
+	return kRunOK;
+    }
+
+    Instruments inst(OpenBackend(env));
+    delete env;
+    if (inst.Error())
+    {
+	LogPtr->Log("# IVrun: instruments did not open.\n");
+	delete LogPtr;
+	return kRunInstrument;
+    }
+    if (!TraceFile.empty() && !inst.Record(TraceFile.c_str()))
+    {
+	delete LogPtr;
+	return kRunConfig;
+    }
+
+    if (!SocketFile.empty())
+    {
+	Control = new ControlServer(SocketFile.c_str(), ControlCommand);
+	if (Control->Error())
+	{
+	    delete Control;
+	    delete LogPtr;
+	    return kRunConfig;
+	}
+	Pending = QueueFile.empty() ? &r : NULL;
+	if (WaitStart && !WaitForStart())
+	{
+	    delete Control;
+	    delete LogPtr;
+	    return kRunInterrupted;
+	}
+	Pending = NULL;
+    }
+
+    if (QueueFile.empty())
+    {
+	status = RunRecipe(inst, r);
+    }
+    else
+    {
+	status = kRunOK;
+	while (!queue.Finished())
+	{
+	    LogPtr->Log("# IVrun: queue %d of %d.\n", (int) queue.Next()+1,
+			(int) queue.N());
+	    status = RunRecipe(inst, queue.Current());
+	    if ((status == kRunInterrupted) || (status == kRunInstrument))
+	    {
+		// Not advanced, the checkpoint reruns this sweep.
+		break;
+	    }
+	    if (!queue.Advance(status == kRunOK))
+	    {
+		status = kRunAcquire;
+		break;
+	    }
+	}
+	if ((status == kRunOK) && (queue.NFailed() > 0))
+	{
+	    status = kRunAcquire;
+	}
+    }
+    delete Control;
+    delete Profiles;
+    delete LogPtr;
+    return status;
+}
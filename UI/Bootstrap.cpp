@@ -0,0 +1,345 @@
+/********************************************************************
+ *
+ * Module Name : Bootstrap.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Bootstrap and jackknife errors for the diode fit.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Local Includes.
+#include "debug.h"
+#include "Bootstrap.hh"
+#include "ThreadPool.hh"
+
+/* Fewest converged replicas worth summarizing. */
+const uint32_t kMinReplicas = 10;
+
+/*
+ * SplitMix64, small, fast and good enough to pick points. One per 
+ * replica, seeded from the replica number.
+ */
+static inline uint64_t SplitMix64(uint64_t &s)
+{
+    uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Bootstrap constructor
+ *
+ * Description : A fitter per pool thread.
+ *
+ * Inputs : Pool        - threads
+ *          Temperature - Kelvin
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+Bootstrap::Bootstrap(ThreadPool *Pool, double Temperature)
+{
+    SET_DEBUG_STACK;
+    fPool = Pool;
+    fScratch.resize(Pool->NThreads());
+    for (size_t k=0; k<fScratch.size(); k++)
+    {
+	fScratch[k].Fit = new DiodeFit(Temperature);
+    }
+    fV = fI = NULL;
+    fN = fNRep = fNGood = 0;
+    memset(fInterval, 0, sizeof(fInterval));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Bootstrap destructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+Bootstrap::~Bootstrap(void)
+{
+    SET_DEBUG_STACK;
+    for (size_t k=0; k<fScratch.size(); k++)
+    {
+	delete fScratch[k].Fit;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Temperature
+ *
+ * Description : Set the junction temperature of every fitter.
+ *
+ * Inputs : K - Kelvin
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Bootstrap::Temperature(double K)
+{
+    for (size_t k=0; k<fScratch.size(); k++)
+    {
+	fScratch[k].Fit->Temperature(K);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Run
+ *
+ * Description : Size the buffers, farm the replicas out in chunks,
+ *               wait and summarize.
+ *
+ * Inputs : see header
+ *
+ * Returns : true if at least kMinReplicas converged
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Bootstrap::Run(const double *V, const double *I, uint32_t N, int Model,
+		    const DiodeParams &Best, Method how, uint32_t NRep,
+		    double CL, uint64_t Seed)
+{
+    SET_DEBUG_STACK;
+    uint32_t chunk, first, last;
+
+    fV      = V;
+    fI      = I;
+    fN      = N;
+    fModel  = Model;
+    fMethod = how;
+    fSeed   = Seed;
+    fBest   = Best;
+    fNRep   = (how == kJackknife) ? N : NRep;
+    fNGood  = 0;
+
+    // Everything the replicas touch is sized here, not in the loop.
+    fResult.assign((size_t) fNRep*kDiodeParameters, 0.0);
+    fOK.assign(fNRep, 0);
+    for (size_t k=0; k<fScratch.size(); k++)
+    {
+	fScratch[k].v.resize(N);
+	fScratch[k].i.resize(N);
+    }
+
+    // A few chunks per thread so stealing can even out the load.
+    chunk = std::max<uint32_t>(1, fNRep/(4*fPool->NThreads()));
+    for (first=0; first<fNRep; first=last)
+    {
+	last = std::min(fNRep, first + chunk);
+	fPool->Submit([this, first, last](uint32_t w) {
+		Replicas(w, first, last);
+	    });
+    }
+    fPool->Wait();
+
+    for (uint32_t r=0; r<fNRep; r++)
+    {
+	if (fOK[r]) fNGood++;
+    }
+    if (fNGood < kMinReplicas)
+    {
+	return false;
+    }
+    Summarize(CL);
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Replicas
+ *
+ * Description : Build and fit replicas [first, last) in worker w's
+ *               buffers.
+ *
+ * Inputs : w           - worker
+ *          first, last - replica numbers
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Bootstrap::Replicas(uint32_t w, uint32_t first, uint32_t last)
+{
+    Scratch     &s = fScratch[w];
+    double      *v = &s.v[0];
+    double      *i = &s.i[0];
+    DiodeParams p;
+    uint32_t    n, k, j;
+    uint64_t    state;
+    bool        ok;
+
+    for (uint32_t r=first; r<last; r++)
+    {
+	if (fMethod == kJackknife)
+	{
+	    for (k=0, n=0; k<fN; k++)
+	    {
+		if (k == r) continue;
+		v[n] = fV[k];
+		i[n] = fI[k];
+		n++;
+	    }
+	}
+	else
+	{
+	    state = fSeed ^ ((uint64_t) r * 0xd1b54a32d192ed03ULL);
+	    for (k=0; k<fN; k++)
+	    {
+		j    = (uint32_t) ((SplitMix64(state) >> 32) * fN >> 32);
+		v[k] = fV[j];
+		i[k] = fI[j];
+	    }
+	    n = fN;
+	}
+	p = fBest;
+	if (fModel == DiodeFit::kFull)
+	    ok = s.Fit->FitFull(v, i, n, p, true);
+	else
+	    ok = s.Fit->FitShockley(v, i, n, p, true);
+
+	fOK[r] = ok;
+	fResult[r*kDiodeParameters + 0] = p.Is;
+	fResult[r*kDiodeParameters + 1] = p.n;
+	fResult[r*kDiodeParameters + 2] = p.Rs;
+	fResult[r*kDiodeParameters + 3] = p.Rsh;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Summarize
+ *
+ * Description : Mean and spread of each parameter over the replicas
+ *               that converged. Bootstrap intervals are percentiles,
+ *               jackknife intervals mean +/- z sigma with z from the
+ *               normal quantile at CL.
+ *
+ * Inputs : CL - confidence level
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Bootstrap::Summarize(double CL)
+{
+    SET_DEBUG_STACK;
+    const double tail = 0.5*(1.0 - CL);
+    double       sum, sum2, x, mean, var, z;
+    uint32_t     m, lo, hi;
+
+    for (uint32_t k=0; k<kDiodeParameters; k++)
+    {
+	fSort.clear();
+	sum = sum2 = 0.0;
+	for (uint32_t r=0; r<fNRep; r++)
+	{
+	    if (!fOK[r]) continue;
+	    x = fResult[r*kDiodeParameters + k];
+	    fSort.push_back(x);
+	    sum  += x;
+	    sum2 += x*x;
+	}
+	m    = fSort.size();
+	mean = sum/m;
+	var  = fmax(sum2/m - mean*mean, 0.0);
+	BootstrapInterval &b = fInterval[k];
+	b.Mean = mean;
+	if (fMethod == kJackknife)
+	{
+	    b.Sigma = sqrt(var*(m - 1));
+	    // Normal quantile by bisection on erfc, only done 4 times.
+	    double zl = 0.0, zh = 10.0;
+	    for (int it=0; it<60; it++)
+	    {
+		z = 0.5*(zl + zh);
+		if (0.5*erfc(z/M_SQRT2) > tail) zl = z; else zh = z;
+	    }
+	    b.Lo = mean - z*b.Sigma;
+	    b.Hi = mean + z*b.Sigma;
+	}
+	else
+	{
+	    b.Sigma = sqrt(var*m/(m - 1));
+	    lo = (uint32_t) floor(tail*(m - 1));
+	    hi = (uint32_t) ceil((1.0 - tail)*(m - 1));
+	    std::nth_element(fSort.begin(), fSort.begin() + lo, fSort.end());
+	    b.Lo = fSort[lo];
+	    std::nth_element(fSort.begin(), fSort.begin() + hi, fSort.end());
+	    b.Hi = fSort[hi];
+	}
+    }
+    SET_DEBUG_STACK;
+}
@@ -0,0 +1,144 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : Bootstrap.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Resampling errors for the diode fit. The errors a
+ *               least squares fit reports assume Gaussian residuals
+ *               of one size everywhere, which small reverse and low
+ *               forward currents do not have. Here the fit is simply
+ *               repeated on resampled data:
+ *
+ *               Bootstrap - N points drawn with replacement, the 
+ *                           interval is read off the percentiles of
+ *                           the replica fits.
+ *               Jackknife - each point left out in turn, the spread
+ *                           is scaled by (N-1)/N, the interval is
+ *                           mean +/- z sigma.
+ *
+ *               Replicas are run on a ThreadPool in chunks. Each pool
+ *               thread owns a DiodeFit and point buffers sized up
+ *               front, and every replica is warm started from the
+ *               fit to all the data, so nothing is allocated inside
+ *               the loop. Each replica draws from its own generator
+ *               seeded by its number, the result does not depend on
+ *               how the work was spread over the threads.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               B. Efron, R. Tibshirani, "An Introduction to the
+ *               Bootstrap", Chapman & Hall 1993.
+ *
+ *******************************************************************
+ */
+#ifndef __BOOTSTRAP_hh_
+#define __BOOTSTRAP_hh_
+#include <stdint.h>
+#include <vector>
+#include "DiodeFit.hh"
+class ThreadPool;
+
+/// Resampled spread of one parameter.
+struct BootstrapInterval {
+    double Mean;
+    double Sigma;
+    double Lo, Hi;     /*! Interval at the confidence level asked */
+};
+
+/// Bootstrap documentation here.
+class Bootstrap {
+public:
+    enum Method {kBootstrap=0, kJackknife};
+
+    /*!
+     * Description:
+     *   Set up on a pool. One fitter and set of buffers per pool
+     *   thread is made here.
+     *
+     * Arguments:
+     *   Pool        - threads to run on, not owned.
+     *   Temperature - junction temperature, Kelvin.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    Bootstrap(ThreadPool *Pool, double Temperature = 293.15);
+    ~Bootstrap(void);
+
+    /*!
+     * Description:
+     *   Resample and refit.
+     *
+     * Arguments:
+     *   V, I    - data, already cut to the fit window.
+     *   N       - number of points
+     *   Model   - DiodeFit::kShockley or DiodeFit::kFull
+     *   Best    - fit to all the data, the replicas start from it.
+     *   how     - bootstrap or jackknife
+     *   NRep    - bootstrap replicas, ignored for jackknife which
+     *             always does N.
+     *   CL      - confidence level of the intervals, 0.95 say.
+     *   Seed    - generator seed.
+     *
+     * Returns:
+     *   true if enough replicas converged to say anything.
+     *
+     * Errors:
+     *   fewer than 10 replicas converged.
+     */
+    bool Run(const double *V, const double *I, uint32_t N, int Model,
+	     const DiodeParams &Best, Method how, uint32_t NRep,
+	     double CL = 0.95, uint64_t Seed = 1);
+
+    /*! Interval for Is, n, Rs, Rsh in that order. */
+    inline const BootstrapInterval& Interval(uint32_t k) const 
+    {return fInterval[k];};
+    /*! Replicas run and replicas that converged. */
+    inline uint32_t NReplicas(void)  const {return fNRep;};
+    inline uint32_t NConverged(void) const {return fNGood;};
+    void            Temperature(double K);
+
+private:
+    /// What each pool thread owns.
+    struct Scratch {
+	DiodeFit            *Fit;
+	std::vector<double> v, i;
+    };
+
+    /*! Run replicas [first, last) on worker w. */
+    void Replicas(uint32_t w, uint32_t first, uint32_t last);
+    /*! Means, spreads and intervals from the replica results. */
+    void Summarize(double CL);
+
+    ThreadPool*           fPool;
+    std::vector<Scratch>  fScratch;
+
+    // The job being run.
+    const double*         fV;
+    const double*         fI;
+    uint32_t              fN;
+    int                   fModel;
+    Method                fMethod;
+    uint64_t              fSeed;
+    DiodeParams           fBest;
+    uint32_t              fNRep;
+    uint32_t              fNGood;
+
+    /*! Replica results, Is n Rs Rsh per replica, and converged flag.*/
+    std::vector<double>   fResult;
+    std::vector<char>     fOK;
+    std::vector<double>   fSort;
+
+    BootstrapInterval     fInterval[kDiodeParameters];
+};
+#endif
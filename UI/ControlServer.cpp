@@ -0,0 +1,612 @@
+/********************************************************************
+ *
+ * Module Name : ControlServer.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Local control and point streaming over a Unix
+ *               domain socket.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               unix(7), the sockets are SOCK_STREAM.
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "ControlServer.hh"
+
+/*! Most a subscriber may fall behind before frames are dropped. */
+const size_t kMaxBacklog    = 1<<20;
+/*! Longest command line, a client that sends more is closed. */
+const size_t kMaxLine       = 4096;
+/*! Connections taken at once. */
+const size_t kMaxClients    = 16;
+
+/* Quote a string for JSON. */
+static std::string Quote(const std::string &s)
+{
+    std::string r("\"");
+    char        hex[8];
+
+    for (size_t i=0; i<s.size(); i++)
+    {
+	unsigned char c = s[i];
+	if ((c == '"') || (c == '\\'))
+	{
+	    r += '\\';
+	    r += c;
+	}
+	else if (c < 0x20)
+	{
+	    sprintf(hex, "\\u%04x", c);
+	    r += hex;
+	}
+	else
+	{
+	    r += c;
+	}
+    }
+    r += '"';
+    return r;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ControlServer constructor
+ *
+ * Description : Make the socket, bind it and listen. If the path is
+ *               already there and nobody answers on it, it was left
+ *               by a process that died and is removed. If someone 
+ *               does answer another program has it and we give up.
+ *
+ * Inputs : Path    - socket file
+ *          Handler - commands the server does not answer itself.
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : socket in use, path too long, could not bind.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ControlServer::ControlServer(const char *Path, CommandHandler Handler) :
+    fPath(Path), fListen(-1), fHandler(Handler)
+{
+    SET_DEBUG_STACK;
+    struct sockaddr_un addr;
+    int                fd;
+    mode_t             mask;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (fPath.empty() || (fPath.size() >= sizeof(addr.sun_path)))
+    {
+	CLogger::GetThis()->Log("# ControlServer: bad socket path %s\n",
+				Path);
+	return;
+    }
+    strcpy(addr.sun_path, Path);
+
+    // Is there a live server on it already?
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+	CLogger::GetThis()->Log("# ControlServer: socket %s\n",
+				strerror(errno));
+	return;
+    }
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+    {
+	close(fd);
+	CLogger::GetThis()->Log("# ControlServer: %s is in use.\n", Path);
+	return;
+    }
+    unlink(Path);
+
+    // Owner only, the socket runs the instruments.
+    mask = umask(0077);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+	umask(mask);
+	CLogger::GetThis()->Log("# ControlServer: bind %s %s\n", Path,
+				strerror(errno));
+	close(fd);
+	return;
+    }
+    umask(mask);
+    if ((listen(fd, 4) < 0) || 
+	(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0))
+    {
+	CLogger::GetThis()->Log("# ControlServer: listen %s %s\n", Path,
+				strerror(errno));
+	close(fd);
+	unlink(Path);
+	return;
+    }
+    fListen = fd;
+    CLogger::GetThis()->Log("# ControlServer: listening on %s\n", Path);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ControlServer destructor
+ *
+ * Description : Close everyone and remove the socket file.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ControlServer::~ControlServer(void)
+{
+    SET_DEBUG_STACK;
+    for (size_t i=0; i<fClients.size(); i++)
+    {
+	close(fClients[i].fd);
+    }
+    fClients.clear();
+    if (fListen >= 0)
+    {
+	close(fListen);
+	unlink(fPath.c_str());
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Poll
+ *
+ * Description : One pass over the sockets. Take new connections, 
+ *               act on any complete command lines, then send what
+ *               each socket will take. Clients that have gone away
+ *               are dropped. Never waits.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Poll(void)
+{
+    SET_DEBUG_STACK;
+    size_t i;
+
+    if (fListen < 0) return;
+    Accept();
+
+    /*
+     * Commands may publish, start a sweep for instance, so all the
+     * reads are done before any of the writes.
+     */
+    i = 0;
+    while (i < fClients.size())
+    {
+	if (Read(fClients[i]))
+	{
+	    i++;
+	}
+	else
+	{
+	    close(fClients[i].fd);
+	    fClients.erase(fClients.begin() + i);
+	}
+    }
+    i = 0;
+    while (i < fClients.size())
+    {
+	if (Flush(fClients[i]))
+	{
+	    i++;
+	}
+	else
+	{
+	    close(fClients[i].fd);
+	    fClients.erase(fClients.begin() + i);
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Accept
+ *
+ * Description : Take any waiting connections.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : Too many clients, the new one is closed.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Accept(void)
+{
+    SET_DEBUG_STACK;
+    Client c;
+    int    fd;
+
+    while ((fd = accept4(fListen, NULL, NULL, 
+			 SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+	if (fClients.size() >= kMaxClients)
+	{
+	    close(fd);
+	    CLogger::GetThis()->Log("# ControlServer: too many clients.\n");
+	    continue;
+	}
+	c.fd         = fd;
+	c.Subscribed = 0;
+	c.Dropped    = 0;
+	fClients.push_back(c);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Read
+ *
+ * Description : Read what has arrived and act on each complete line.
+ *
+ * Inputs : c - client
+ *
+ * Returns : false if the client has closed or misbehaved.
+ *
+ * Error Conditions : line longer than kMaxLine.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ControlServer::Read(Client &c)
+{
+    SET_DEBUG_STACK;
+    char    buf[1024];
+    ssize_t n;
+    size_t  eol;
+
+    while ((n = recv(c.fd, buf, sizeof(buf), 0)) > 0)
+    {
+	c.In.append(buf, n);
+	while ((eol = c.In.find('\n')) != std::string::npos)
+	{
+	    std::string line(c.In, 0, eol);
+	    c.In.erase(0, eol+1);
+	    if (!line.empty() && (line[line.size()-1] == '\r'))
+	    {
+		line.erase(line.size()-1);
+	    }
+	    Command(c, line);
+	    if (c.fd < 0) return false;      // close
+	}
+	if (c.In.size() > kMaxLine) return false;
+    }
+    if (n == 0) return false;
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Command
+ *
+ * Description : Act on one command line and queue the reply. On a
+ *               binary subscription only close is taken.
+ *
+ * Inputs : c    - client
+ *          line - command
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : unknown command, reported to the client.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Command(Client &c, const std::string &line)
+{
+    SET_DEBUG_STACK;
+    std::vector<std::string> args;
+    std::istringstream       words(line);
+    std::string              w, reply;
+    bool                     ok = true;
+
+    while (words >> w) args.push_back(w);
+    if (args.empty()) return;
+
+    if ((c.Subscribed == 2) && (args[0] != "close"))
+    {
+	/*
+	 * Frames have no header, a reply in among them could not be
+	 * told apart. A binary stream takes close and nothing else.
+	 */
+	CLogger::GetThis()->Log("# ControlServer: %s ignored on a binary"
+				" stream.\n", line.c_str());
+	return;
+    }
+    if (args[0] == "subscribe")
+    {
+	if ((args.size() > 1) && (args[1] == "binary"))
+	{
+	    c.Subscribed = 2;
+	    reply = "binary";
+	}
+	else
+	{
+	    c.Subscribed = 1;
+	    reply = "json";
+	}
+    }
+    else if (args[0] == "unsubscribe")
+    {
+	c.Subscribed = 0;
+	reply = "unsubscribed";
+    }
+    else if (args[0] == "close")
+    {
+	close(c.fd);
+	c.fd = -1;
+	return;
+    }
+    else if (fHandler)
+    {
+	ok = fHandler(args, reply);
+    }
+    else
+    {
+	ok    = false;
+	reply = "unknown command";
+    }
+
+    if (ok)
+    {
+	c.Out += "{\"ok\":true,\"reply\":";
+	c.Out += (!reply.empty() && reply[0] == '{') ? reply : Quote(reply);
+    }
+    else
+    {
+	c.Out += "{\"ok\":false,\"error\":";
+	c.Out += Quote(reply);
+    }
+    c.Out += "}\n";
+    CLogger::GetThis()->Log("# ControlServer: %s %s\n", line.c_str(),
+			    ok ? "ok" : reply.c_str());
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Flush
+ *
+ * Description : Send as much of the pending output as the socket
+ *               takes, the rest waits for the next poll.
+ *
+ * Inputs : c - client
+ *
+ * Returns : false if the client has gone.
+ *
+ * Error Conditions : send failed for a reason other than a full 
+ *                    socket.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ControlServer::Flush(Client &c)
+{
+    SET_DEBUG_STACK;
+    ssize_t n;
+
+    if (c.Out.empty()) return true;
+    n = send(c.fd, c.Out.data(), c.Out.size(), MSG_NOSIGNAL|MSG_DONTWAIT);
+    if (n < 0)
+    {
+	return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || 
+		(errno == EINTR));
+    }
+    c.Out.erase(0, n);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Queue
+ *
+ * Description : Append a frame for a subscriber. If the subscriber
+ *               is too far behind the frame is counted and dropped,
+ *               once there is room again the count is sent first.
+ *
+ * Inputs : c    - client
+ *          data - frame
+ *          n    - size
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Queue(Client &c, const char *data, size_t n)
+{
+    char note[64];
+
+    if (c.Out.size() + n > kMaxBacklog)
+    {
+	c.Dropped++;
+	return;
+    }
+    if ((c.Dropped > 0) && (c.Subscribed == 1))
+    {
+	sprintf(note, "{\"event\":\"dropped\",\"n\":%u}\n", c.Dropped);
+	c.Out += note;
+    }
+    c.Dropped = 0;
+    c.Out.append(data, n);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Publish
+ *
+ * Description : Queue a point for every subscriber. It goes out at
+ *               the next Poll.
+ *
+ * Inputs : Index - point number in the sweep
+ *          V     - voltage
+ *          I     - mean current
+ *          Sigma - standard deviation of the readings
+ *          NAVG  - readings averaged
+ *          Time  - seconds since the start of the sweep
+ *          Fine  - 1 if taken with the fine step
+ *          Down  - 1 on the return branch of a bidirectional sweep
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Publish(uint32_t Index, double V, double I, 
+			    double Sigma, uint32_t NAVG, double Time, 
+			    uint8_t Fine, uint8_t Down)
+{
+    PointFrame frame;
+    char       json[192];
+    int        n = 0;
+
+    for (size_t i=0; i<fClients.size(); i++)
+    {
+	Client &c = fClients[i];
+	if (c.Subscribed == 1)
+	{
+	    if (n == 0)
+	    {
+		n = snprintf(json, sizeof(json),
+			     "{\"idx\":%u,\"v\":%.7g,\"i\":%.7g,\"sd\":%.4g,"
+			     "\"navg\":%u,\"t\":%.3f,\"fine\":%u,"
+			     "\"down\":%u}\n",
+			     Index, V, I, Sigma, NAVG, Time, Fine, Down);
+	    }
+	    Queue(c, json, n);
+	}
+	else if (c.Subscribed == 2)
+	{
+	    frame.Index    = Index;
+	    frame.V        = V;
+	    frame.I        = I;
+	    frame.Sigma    = Sigma;
+	    frame.Time     = Time;
+	    frame.NAVG     = (NAVG > 0xFFFF) ? 0xFFFF : NAVG;
+	    frame.Fine     = Fine;
+	    frame.Down     = Down;
+	    Queue(c, (const char *) &frame, sizeof(frame));
+	}
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Event
+ *
+ * Description : Queue an event for the JSON subscribers, sweep 
+ *               started, done, stopped and so on.
+ *
+ * Inputs : Name   - event
+ *          Detail - optional string, a file name for instance.
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ControlServer::Event(const char *Name, const char *Detail)
+{
+    std::string e("{\"event\":");
+
+    e += Quote(Name);
+    if (Detail)
+    {
+	e += ",\"detail\":";
+	e += Quote(Detail);
+    }
+    e += "}\n";
+    for (size_t i=0; i<fClients.size(); i++)
+    {
+	if (fClients[i].Subscribed == 1)
+	{
+	    Queue(fClients[i], e.data(), e.size());
+	}
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : ControlServer.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Local control of a sweep over a Unix domain socket,
+ *               for test executives and dashboards.
+ *
+ *               Commands are lines of text, words separated by
+ *               spaces. Each gets one reply line of JSON:
+ *                   {"ok":true,"reply":...}
+ *                   {"ok":false,"error":"..."}
+ *
+ *               The server itself answers
+ *                   subscribe [json|binary]  points as they come
+ *                   unsubscribe
+ *                   close
+ *               and hands everything else, start, stop, status,
+ *               set <key> <value> and so on, to the owner's handler.
+ *
+ *               Subscribers get one frame per point. JSON frames
+ *               are a line each,
+ *                   {"idx":12,"v":0.512,"i":1.2e-06,"sd":3e-09,
+ *                    "navg":4,"t":12.53,"fine":1,"down":0}
+ *               and events such as {"event":"done"}. Binary frames
+ *               are the 24 byte PointFrame below in the byte order
+ *               of this machine, events are not sent in binary.
+ *               The binary frames have no header, so after the 
+ *               reply to subscribe binary nothing but frames is 
+ *               sent on that connection. It takes close and ignores
+ *               any other command, unsubscribe too. Use a second
+ *               connection to control the sweep.
+ *
+ *               Nothing here ever waits. All sockets are non 
+ *               blocking and Poll, called from a timer or between
+ *               points, accepts, reads what has arrived and writes
+ *               what the socket will take. Publish only appends to
+ *               the subscriber's buffer so the frames that build up
+ *               between polls go out in one send. A subscriber that
+ *               falls kMaxBacklog behind loses frames, it is told
+ *               how many with a {"event":"dropped","n":N} frame, 
+ *               acquisition is never held up.
+ *
+ *               The socket is made readable by the owner only.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __CONTROLSERVER_hh_
+#define __CONTROLSERVER_hh_
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+/// Binary subscription frame, 24 bytes.
+struct PointFrame {
+    uint32_t Index;
+    float    V;
+    float    I;
+    float    Sigma;
+    float    Time;       /*! s from the start of the sweep */
+    uint16_t NAVG;
+    uint8_t  Fine;
+    uint8_t  Down;       /*! 1 on the return branch */
+};
+
+/*!
+ * Command handler: the words of the command line in, the reply out.
+ * A reply that starts with { is sent as a JSON object, anything else
+ * as a string. Returns false for an error, the reply is the message.
+ */
+typedef std::function<bool(const std::vector<std::string>&, std::string&)>
+    CommandHandler;
+
+/// ControlServer documentation here.
+class ControlServer {
+public:
+    /*!
+     * Description:
+     *   Open the socket and listen. A stale socket file left by a 
+     *   process that died is removed.
+     *
+     * Arguments:
+     *   Path    - socket file
+     *   Handler - commands the server does not answer itself
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   Check Error(), the socket is in use or can not be made.
+     */
+    ControlServer(const char *Path, CommandHandler Handler);
+    ~ControlServer(void);
+
+    /*! Accept, read and answer commands, send pending frames. */
+    void Poll(void);
+
+    /*! Queue a point for the subscribers. */
+    void Publish(uint32_t Index, double V, double I, double Sigma,
+		 uint32_t NAVG, double Time, uint8_t Fine, 
+		 uint8_t Down = 0);
+
+    /*! Queue an event, {"event":"Name"} plus Detail if given. */
+    void Event(const char *Name, const char *Detail = NULL);
+
+    inline bool     Error(void)    const {return (fListen < 0);};
+    inline uint32_t NClients(void) const {return fClients.size();};
+    inline const std::string& Path(void) const {return fPath;};
+
+private:
+    struct Client {
+	int         fd;
+	int         Subscribed;   /*! 0 none, 1 JSON, 2 binary */
+	std::string In;           /*! Partial command line       */
+	std::string Out;          /*! Replies and frames to send */
+	uint32_t    Dropped;      /*! Frames lost since last sent */
+    };
+
+    void Accept(void);
+    /*! Read and act on commands, false if the client has gone. */
+    bool Read(Client &c);
+    /*! Send what the socket takes, false if the client has gone. */
+    bool Flush(Client &c);
+    void Command(Client &c, const std::string &line);
+    /*! Append a frame to a subscriber, or count it as dropped. */
+    void Queue(Client &c, const char *data, size_t n);
+
+    std::string         fPath;
+    int                 fListen;
+    CommandHandler      fHandler;
+    std::vector<Client> fClients;
+};
+#endif
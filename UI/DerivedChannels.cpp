@@ -0,0 +1,282 @@
+/********************************************************************
+ *
+ * Module Name : DerivedChannels.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Point by point derived quantities of the sweep.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+
+// Local Includes.
+#include "debug.h"
+#include "DerivedChannels.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : DerivedChannels constructor
+ *
+ * Description :
+ *
+ * Inputs : HalfWidth - M
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+DerivedChannels::DerivedChannels(uint32_t HalfWidth)
+{
+    SET_DEBUG_STACK;
+    fM = (HalfWidth > 0) ? HalfWidth : 1;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reset
+ *
+ * Description : Drop all points.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DerivedChannels::Reset(void)
+{
+    SET_DEBUG_STACK;
+    fV.clear();
+    fI.clear();
+    fG.clear();
+    fR.clear();
+    fLogI.clear();
+    fVf.assign(fTarget.size(), NAN);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : VfTargets
+ *
+ * Description : Set the currents to report Vf at.
+ *
+ * Inputs : I - currents
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DerivedChannels::VfTargets(const std::vector<double> &I)
+{
+    fTarget = I;
+    fVf.assign(fTarget.size(), NAN);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Slope
+ *
+ * Description : Least squares I = a + b u + c u^2, u = V - V[k],
+ *               over the window, the slope at k is b. The normal
+ *               equations are 3x3, solved by Cramer's rule.
+ *
+ * Inputs : k     - point
+ *          first - start of the window
+ *
+ * Returns : dI/dV at point k
+ *
+ * Error Conditions : degenerate window gives 0.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DerivedChannels::Slope(uint32_t k, uint32_t first) const
+{
+    double S0 = 0, S1 = 0, S2 = 0, S3 = 0, S4 = 0;
+    double T0 = 0, T1 = 0, T2 = 0;
+    double u, u2, det, num;
+
+    for (uint32_t j=first; j<=first+2*fM; j++)
+    {
+	u   = fV[j] - fV[k];
+	u2  = u*u;
+	S0 += 1.0;  S1 += u;    S2 += u2;
+	S3 += u2*u; S4 += u2*u2;
+	T0 += fI[j]; T1 += u*fI[j]; T2 += u2*fI[j];
+    }
+    det = S0*(S2*S4 - S3*S3) - S1*(S1*S4 - S3*S2) + S2*(S1*S3 - S2*S2);
+    if (det == 0.0)
+    {
+	return 0.0;
+    }
+    num = S0*(T1*S4 - S3*T2) - T0*(S1*S4 - S3*S2) + S2*(S1*T2 - T1*S2);
+    return num/det;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Emit
+ *
+ * Description : Derived values of point k from a window.
+ *
+ * Inputs : k     - point
+ *          first - start of the window
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DerivedChannels::Emit(uint32_t k, uint32_t first)
+{
+    double g = Slope(k, first);
+
+    fG.push_back(g);
+    fR.push_back((g != 0.0) ? 1.0/g : HUGE_VAL);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : log10|I| and the Vf crossings right away, the
+ *               derivative of the point M back once its window is
+ *               full.
+ *
+ * Inputs : V, I - the point
+ *
+ * Returns : NDerived
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t DerivedChannels::Add(double V, double I)
+{
+    const uint32_t w = 2*fM + 1;
+    uint32_t       n, k;
+    double         l0, l1;
+
+    fV.push_back(V);
+    fI.push_back(I);
+    fLogI.push_back((I != 0.0) ? log10(fabs(I)) : -HUGE_VAL);
+    n = fV.size();
+
+    // Forward voltage, first rising crossing of each target.
+    if (n > 1)
+    {
+	for (k=0; k<fTarget.size(); k++)
+	{
+	    if (std::isnan(fVf[k]) && (fI[n-2] > 0.0) &&
+		(fI[n-2] < fTarget[k]) && (I >= fTarget[k]))
+	    {
+		l0     = fLogI[n-2];
+		l1     = fLogI[n-1];
+		fVf[k] = fV[n-2] + (fV[n-1] - fV[n-2])*
+		    (log10(fTarget[k]) - l0)/(l1 - l0);
+	    }
+	}
+    }
+
+    if (n == w)
+    {
+	// First full window, the leading points share it.
+	for (k=0; k<=fM; k++) Emit(k, 0);
+    }
+    else if (n > w)
+    {
+	Emit(n - 1 - fM, n - w);
+    }
+    return fG.size();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : End
+ *
+ * Description : The trailing M points use the last full window. A
+ *               sweep shorter than a window gets a straight two
+ *               point slope.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DerivedChannels::End(void)
+{
+    const uint32_t w = 2*fM + 1;
+    const uint32_t n = fV.size();
+    double         g;
+
+    if (n >= w)
+    {
+	for (uint32_t k=fG.size(); k<n; k++) Emit(k, n - w);
+    }
+    else
+    {
+	for (uint32_t k=fG.size(); k<n; k++)
+	{
+	    g = (n > 1) ? (fI[n-1] - fI[0])/(fV[n-1] - fV[0]) : 0.0;
+	    fG.push_back(g);
+	    fR.push_back((g != 0.0) ? 1.0/g : HUGE_VAL);
+	}
+    }
+}
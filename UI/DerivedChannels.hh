@@ -0,0 +1,113 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : DerivedChannels.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Quantities derived from the sweep, worked out point
+ *               by point as the data arrives.
+ *
+ *               G     = dI/dV, differential conductance
+ *               Rdyn  = dV/dI = 1/G, dynamic resistance
+ *               log10 |I|
+ *               Vf(I) - forward voltage at chosen currents
+ *
+ *               The derivative is a Savitzky-Golay filter, a 
+ *               quadratic fit over a sliding window of 2M+1 points
+ *               whose slope at the centre point is G. The sweep is
+ *               not evenly spaced, there is a fine step around the
+ *               knee, so the fit is done in the real voltages rather
+ *               than with the tabulated even spacing coefficients. A
+ *               point's derivative is known M points after it 
+ *               arrives. The first and last M points use the first
+ *               and last full windows.
+ *
+ *               Vf is found where the current first passes each
+ *               target, interpolating log|I| linearly in V.
+ *
+ * Restrictions/Limitations :
+ *               Points are expected in sweep order.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               A. Savitzky, M.J.E. Golay, Anal. Chem. 36 (1964)
+ *
+ *******************************************************************
+ */
+#ifndef __DERIVEDCHANNELS_hh_
+#define __DERIVEDCHANNELS_hh_
+#include <stdint.h>
+#include <vector>
+
+/// DerivedChannels documentation here.
+class DerivedChannels {
+public:
+    /*!
+     * Description:
+     *   Set up the pipeline.
+     *
+     * Arguments:
+     *   HalfWidth - M, the window is 2M+1 points.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    DerivedChannels(uint32_t HalfWidth = 3);
+
+    /*! Start a new sweep, keeps the Vf targets. */
+    void Reset(void);
+
+    /*!
+     * Description:
+     *   Take the next point.
+     *
+     * Arguments:
+     *   V, I - the point
+     *
+     * Returns:
+     *   number of points with a derivative so far.
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t Add(double V, double I);
+
+    /*! End of sweep, fill in the derivative of the last M points. */
+    void End(void);
+
+    /*! Currents at which to report the forward voltage. */
+    void VfTargets(const std::vector<double> &I);
+
+    /*! Points taken. */
+    inline uint32_t      N(void)      const {return fV.size();};
+    /*! Points with a derivative, these are the first NDerived. */
+    inline uint32_t      NDerived(void) const {return fG.size();};
+    inline const double* V(void)      const {return &fV[0];};
+    inline const double* G(void)      const {return &fG[0];};
+    inline const double* Rdyn(void)   const {return &fR[0];};
+    inline const double* Log10I(void) const {return &fLogI[0];};
+
+    /*! Vf targets and what was found, NaN if not reached. */
+    inline uint32_t NVf(void)          const {return fTarget.size();};
+    inline double   VfTarget(uint32_t k) const {return fTarget[k];};
+    inline double   Vf(uint32_t k)       const {return fVf[k];};
+
+private:
+    /*! Slope at point k of the quadratic fit to [first, first+2M]. */
+    double Slope(uint32_t k, uint32_t first) const;
+    /*! Append the derived values for point k. */
+    void   Emit(uint32_t k, uint32_t first);
+
+    uint32_t            fM;
+    std::vector<double> fV, fI;
+    std::vector<double> fG, fR, fLogI;
+    std::vector<double> fTarget, fVf;
+};
+#endif
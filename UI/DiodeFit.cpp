@@ -0,0 +1,976 @@
+/********************************************************************
+ *
+ * Module Name : DiodeFit.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Levenberg-Marquardt fits of the diode equation.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Local Includes.
+#include "debug.h"
+#include "DiodeFit.hh"
+
+/* Boltzmann constant over electron charge, V/K */
+const double kBoltzmannOverQ = 8.617333262e-5;
+
+/* Below this ln z, z is treated as exp(kLnZMin) in LambertWLog */
+const double kLnZMin = -700.0;
+
+/*
+ * Largest step, in e-folds, any log parameter of the full model may
+ * take in one iteration. Without it a single step can throw Rs to
+ * where it has no effect on the curve and the fit never recovers.
+ */
+const double kMaxLogStep = 2.0;
+
+/*
+ * FullGuess only looks for the exponential above this many kT/q.
+ */
+const double kGuessVt = 5.0;
+
+/* Starting and limiting values of the LM damping. */
+const double kLambdaStart = 1.0e-3;
+const double kLambdaMax   = 1.0e10;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : LogExpm1
+ *
+ * Description : ln(exp(x)-1) without overflow for large x and
+ *               without cancellation for small x.
+ *
+ * Inputs : x > 0
+ *
+ * Returns : ln(exp(x)-1)
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static inline double LogExpm1(double x)
+{
+    return (x > 20.0) ? x + log1p(-exp(-x)) : log(expm1(x));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DiodeFit constructor
+ *
+ * Description :
+ *
+ * Inputs : Temperature - junction temperature, Kelvin
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+DiodeFit::DiodeFit(double Temperature)
+{
+    SET_DEBUG_STACK;
+    fTemperature   = Temperature;
+    fMaxIterations = 100;
+    fTolerance     = 1.0e-10;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ThermalVoltage
+ *
+ * Description : kT/q
+ *
+ * Inputs : NONE
+ *
+ * Returns : thermal voltage in volts
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DiodeFit::ThermalVoltage(void) const
+{
+    return kBoltzmannOverQ * fTemperature;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Shockley
+ *
+ * Description : I = Is (exp(V/(n Vt)) - 1)
+ *
+ * Inputs : V - voltage
+ *          p - parameters
+ *
+ * Returns : current
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DiodeFit::Shockley(double V, const DiodeParams &p) const
+{
+    return p.Is * expm1(V/(p.n*ThermalVoltage()));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Select
+ *
+ * Description : Copy the forward points, V>0 and I>0, into the
+ *               scratch arrays. Those are the only points whose
+ *               log can be taken and they carry all the information
+ *               about Is and n.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *
+ * Returns : number of points selected
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t DiodeFit::Select(const double *V, const double *I, uint32_t N)
+{
+    uint32_t n = 0;
+
+    fV.resize(N);
+    fLnI.resize(N);
+    for (uint32_t i=0; i<N; i++)
+    {
+	if ((V[i] > 0.0) && (I[i] > 0.0))
+	{
+	    fV[n]   = V[i];
+	    fLnI[n] = log(I[i]);
+	    n++;
+	}
+    }
+    fV.resize(n);
+    fLnI.resize(n);
+    fR.resize(n);
+    fW.resize(n);
+    fJ.resize(n*kDiodeParameters);
+    return n;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : InitialGuess
+ *
+ * Description : Straight line fit of ln(I) against V.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *          p    - output
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : too few points, slope not positive.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::InitialGuess(const double *V, const double *I, uint32_t N,
+			    DiodeParams &p)
+{
+    SET_DEBUG_STACK;
+    double   Sx = 0.0, Sy = 0.0, Sxx = 0.0, Sxy = 0.0;
+    double   det, slope, intercept;
+    uint32_t n = Select(V, I, N);
+
+    memset(&p, 0, sizeof(p));
+    p.Rsh = HUGE_VAL;
+    if (n < 2)
+    {
+	return false;
+    }
+    for (uint32_t i=0; i<n; i++)
+    {
+	Sx  += fV[i];
+	Sy  += fLnI[i];
+	Sxx += fV[i]*fV[i];
+	Sxy += fV[i]*fLnI[i];
+    }
+    det = n*Sxx - Sx*Sx;
+    if (det <= 0.0)
+    {
+	return false;
+    }
+    slope     = (n*Sxy - Sx*Sy)/det;
+    intercept = (Sy - slope*Sx)/n;
+    if (slope <= 0.0)
+    {
+	return false;
+    }
+    p.Is = exp(intercept);
+    p.n  = 1.0/(slope*ThermalVoltage());
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Evaluate
+ *
+ * Description : Fill the residuals, ln(I) data - ln(I) model, and
+ *               if asked the Jacobian of ln(I) model with respect
+ *               to the fit parameters q.
+ *
+ *               Shockley: q = (ln Is, 1/(n Vt))
+ *                   ln I = q0 + ln(exp(q1 V) - 1)
+ *                   d/dq0 = 1
+ *                   d/dq1 = V/(1 - exp(-q1 V))
+ *
+ * Inputs : m        - model
+ *          q        - fit parameters
+ *          Jacobian - compute derivatives too
+ *
+ * Returns : sum of squared residuals
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DiodeFit::Evaluate(Model m, const double *q, bool Jacobian)
+{
+    double   chi2 = 0.0;
+    double   x, r;
+    uint32_t n = fV.size();
+    double   *J = &fJ[0];
+
+    switch(m)
+    {
+    case kShockley:
+	for (uint32_t i=0; i<n; i++)
+	{
+	    x     = q[1]*fV[i];
+	    r     = fLnI[i] - (q[0] + LogExpm1(x));
+	    fR[i] = r;
+	    chi2 += r*r;
+	    if (Jacobian)
+	    {
+		J[i*kDiodeParameters + 0] = 1.0;
+		J[i*kDiodeParameters + 1] = -fV[i]/expm1(-x);
+	    }
+	}
+	break;
+    case kFull:
+    {
+	/*
+	 * q = (ln Is, ln n, ln Rs, ln Rsh). The derivatives come from
+	 * the implicit form
+	 *    F = Is (E - 1) + u/Rsh - I = 0,  u = V - I Rs, E = exp(u/a)
+	 *    dI/dx = (dF/dx)/(1 + Rs dF/du)
+	 * where Is E = G a W with G = 1/Rs + 1/Rsh, so E is never 
+	 * formed and nothing overflows. 
+	 */
+	const double Is  = exp(q[0]);
+	const double a   = exp(q[1])*ThermalVoltage();
+	const double Rs  = exp(q[2]);
+	const double Rsh = exp(q[3]);
+	const double G   = 1.0/Rs + 1.0/Rsh;
+	double       *W  = &fW[0];
+	double       Im, u, IsE, gp, d;
+
+	FullLnZ(&fV[0], W, n, Is, a, Rs, Rsh);
+	LambertWLog(W, W, n);
+	for (uint32_t i=0; i<n; i++)
+	{
+	    Im = (fV[i] - Is*Rsh)/(Rs + Rsh) + (a/Rs)*W[i];
+	    if (!(Im > 0.0))
+	    {
+		return HUGE_VAL;
+	    }
+	    r     = fLnI[i] - log(Im);
+	    fR[i] = r;
+	    chi2 += r*r;
+	    if (Jacobian)
+	    {
+		u   = fV[i] - Im*Rs;
+		IsE = G*a*W[i];
+		gp  = IsE/a + 1.0/Rsh;
+		d   = 1.0/((1.0 + Rs*gp)*Im);
+		J[i*kDiodeParameters + 0] = (IsE - Is)*d;
+		J[i*kDiodeParameters + 1] = -IsE*u/a*d;
+		J[i*kDiodeParameters + 2] = -Im*Rs*gp*d;
+		J[i*kDiodeParameters + 3] = -u/Rsh*d;
+	    }
+	}
+    }
+	break;
+    }
+    return chi2;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Solve
+ *
+ * Description : Gaussian elimination with partial pivoting on a
+ *               small dense system. A is destroyed, the solution
+ *               is left in b.
+ *
+ * Inputs : npar - size of the system
+ *          A    - npar x npar, row major
+ *          b    - right hand side
+ *
+ * Returns : false if the matrix is singular.
+ *
+ * Error Conditions : singular matrix
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::Solve(uint32_t npar, double *A, double *b)
+{
+    uint32_t i, j, k, piv;
+    double   f, t;
+
+    for (k=0; k<npar; k++)
+    {
+	piv = k;
+	for (i=k+1; i<npar; i++)
+	{
+	    if (fabs(A[i*npar+k]) > fabs(A[piv*npar+k])) piv = i;
+	}
+	if (A[piv*npar+k] == 0.0)
+	{
+	    return false;
+	}
+	if (piv != k)
+	{
+	    for (j=0; j<npar; j++)
+	    {
+		t = A[k*npar+j]; A[k*npar+j] = A[piv*npar+j]; A[piv*npar+j] = t;
+	    }
+	    t = b[k]; b[k] = b[piv]; b[piv] = t;
+	}
+	for (i=k+1; i<npar; i++)
+	{
+	    f = A[i*npar+k]/A[k*npar+k];
+	    for (j=k; j<npar; j++) A[i*npar+j] -= f*A[k*npar+j];
+	    b[i] -= f*b[k];
+	}
+    }
+    for (k=npar; k-- > 0;)
+    {
+	for (j=k+1; j<npar; j++) b[k] -= A[k*npar+j]*b[j];
+	b[k] /= A[k*npar+k];
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Minimize
+ *
+ * Description : Levenberg-Marquardt. The normal equations
+ *                (J'J + lambda diag(J'J)) dq = J'r
+ *               are solved for the step, lambda shrinks when a step
+ *               lowers chi2 and grows when it does not. Converged
+ *               when chi2 stops improving by more than fTolerance
+ *               relative. The covariance of q is s^2 (J'J)^-1 with
+ *               s^2 = chi2/ndf, the caller maps that onto the
+ *               physical parameters.
+ *
+ * Inputs : m    - model
+ *          npar - number of fit parameters
+ *          q    - starting point, returns the minimum
+ *          p    - Chi2, NDF, Iterations, Converged filled in, Cov
+ *                 holds the covariance of q.
+ *
+ * Returns : true if converged
+ *
+ * Error Conditions : singular normal equations
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::Minimize(Model m, uint32_t npar, double *q, DiodeParams &p)
+{
+    const uint32_t K = kDiodeParameters;
+    double   A[K*K], M[K*K], g[K], dq[K], qt[K];
+    double   chi2, chi2t, lambda = kLambdaStart, s2, step;
+    uint32_t n = fV.size();
+    uint32_t i, j, k, it;
+    bool     improved;
+    const double *J = &fJ[0];
+
+    p.Converged  = false;
+    p.Iterations = 0;
+    p.NDF        = (n > npar) ? n - npar : 0;
+    memset(p.Cov, 0, sizeof(p.Cov));
+
+    chi2 = Evaluate(m, q, true);
+    for (it=0; it<fMaxIterations; it++)
+    {
+	// Normal equations.
+	memset(A, 0, sizeof(A));
+	memset(g, 0, sizeof(g));
+	for (k=0; k<n; k++)
+	{
+	    const double *Jk = J + k*K;
+	    for (i=0; i<npar; i++)
+	    {
+		g[i] += Jk[i]*fR[k];
+		for (j=0; j<=i; j++) A[i*npar+j] += Jk[i]*Jk[j];
+	    }
+	}
+	for (i=0; i<npar; i++)
+	    for (j=0; j<i; j++) A[j*npar+i] = A[i*npar+j];
+
+	improved = false;
+	while (!improved && (lambda < kLambdaMax))
+	{
+	    memcpy(M, A, sizeof(A));
+	    memcpy(dq, g, sizeof(g));
+	    for (i=0; i<npar; i++) M[i*npar+i] *= (1.0 + lambda);
+	    if (Solve(npar, M, dq))
+	    {
+		if (m == kFull)
+		{
+		    step = 0.0;
+		    for (i=0; i<npar; i++) step = fmax(step, fabs(dq[i]));
+		    if (step > kMaxLogStep)
+		    {
+			for (i=0; i<npar; i++) dq[i] *= kMaxLogStep/step;
+		    }
+		}
+		for (i=0; i<npar; i++) qt[i] = q[i] + dq[i];
+		chi2t = Evaluate(m, qt, false);
+		if (chi2t < chi2)
+		{
+		    improved = true;
+		    lambda  *= 0.1;
+		    break;
+		}
+	    }
+	    lambda *= 10.0;
+	}
+	if (!improved)
+	{
+	    // Can not go downhill, we are sitting on the minimum.
+	    p.Converged = true;
+	    break;
+	}
+	memcpy(q, qt, npar*sizeof(double));
+	p.Converged = ((chi2 - chi2t) <= fTolerance*chi2);
+	chi2 = Evaluate(m, q, true);
+	if (p.Converged) break;
+    }
+    p.Iterations = it + 1;
+    p.Chi2       = chi2;
+
+    // Covariance from the curvature at the minimum.
+    memset(A, 0, sizeof(A));
+    for (k=0; k<n; k++)
+    {
+	const double *Jk = J + k*K;
+	for (i=0; i<npar; i++)
+	    for (j=0; j<npar; j++) A[i*npar+j] += Jk[i]*Jk[j];
+    }
+    s2 = (p.NDF > 0) ? chi2/p.NDF : 0.0;
+    for (j=0; j<npar; j++)
+    {
+	memcpy(M, A, sizeof(A));
+	memset(dq, 0, sizeof(dq));
+	dq[j] = 1.0;
+	if (!Solve(npar, M, dq))
+	{
+	    return false;
+	}
+	for (i=0; i<npar; i++) p.Cov[i][j] = s2*dq[i];
+    }
+    return p.Converged;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitShockley
+ *
+ * Description : Fit I = Is (exp(V/(n Vt)) - 1). The fit is done in
+ *               q = (ln Is, 1/(n Vt)) and mapped back, errors and
+ *               covariance included, to Is and n.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *          p    - result, also starting point if Warm
+ *          Warm - start from p
+ *
+ * Returns : true if the fit converged
+ *
+ * Error Conditions : fewer than 3 forward points
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::FitShockley(const double *V, const double *I, uint32_t N,
+			   DiodeParams &p, bool Warm)
+{
+    SET_DEBUG_STACK;
+    double   q[kDiodeParameters];
+    double   T[2];         // d(Is,n)/d(q0,q1), diagonal.
+    double   cov[2][2];
+    bool     rc;
+
+    if (Warm && (p.Is > 0.0) && (p.n > 0.0))
+    {
+	Select(V, I, N);
+    }
+    else if (!InitialGuess(V, I, N, p))
+    {
+	p.Converged = false;
+	return false;
+    }
+    if (fV.size() < 3)
+    {
+	p.Converged = false;
+	return false;
+    }
+    q[0] = log(p.Is);
+    q[1] = 1.0/(p.n*ThermalVoltage());
+
+    rc = Minimize(kShockley, 2, q, p);
+
+    p.Is  = exp(q[0]);
+    p.n   = 1.0/(q[1]*ThermalVoltage());
+    p.Rs  = 0.0;
+    p.Rsh = HUGE_VAL;
+    T[0]  = p.Is;
+    T[1]  = -p.n/q[1];
+    cov[0][0] = p.Cov[0][0]; cov[0][1] = p.Cov[0][1];
+    cov[1][0] = p.Cov[1][0]; cov[1][1] = p.Cov[1][1];
+    memset(p.Cov,   0, sizeof(p.Cov));
+    memset(p.Error, 0, sizeof(p.Error));
+    for (uint32_t i=0; i<2; i++)
+    {
+	for (uint32_t j=0; j<2; j++) p.Cov[i][j] = T[i]*T[j]*cov[i][j];
+	p.Error[i] = sqrt(fabs(p.Cov[i][i]));
+    }
+    SET_DEBUG_STACK;
+    return rc;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LambertWLog
+ *
+ * Description : W(z) on the principal branch from ln z. 
+ *               Starting value:
+ *                 ln z <= 20  Winitzki, W ~ L (1 - ln(1+L)/(2+L)),
+ *                             L = ln(1+z), about 1e-3 relative.
+ *                 ln z >  20  W ~ l - ln l + ln l/l, l = ln z.
+ *               Both are computed and one selected so that the loop
+ *               does not branch. Then two Fritsch iterations,
+ *                 e  = ln z - ln w - w
+ *                 q  = 2 (1+w) (1 + w + 2e/3)
+ *                 w *= 1 + e/(1+w) (q - e)/(q - 2e)
+ *               each of which takes the relative error from d to
+ *               about d^4.
+ *
+ * Inputs : LnZ - ln z
+ *          W   - output
+ *          N   - number of points
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DiodeFit::LambertWLog(const double *LnZ, double *W, uint32_t N)
+{
+    for (uint32_t i=0; i<N; i++)
+    {
+	double l  = fmax(LnZ[i], kLnZMin);
+	// Winitzki, input clamped so exp can not overflow.
+	double L1 = log1p(exp(fmin(l, 20.0)));
+	double w0 = L1*(1.0 - log1p(L1)/(2.0 + L1));
+	// Asymptotic, input clamped so the logs are defined.
+	double la = fmax(l, 20.0);
+	double ll = log(la);
+	double w1 = la - ll + ll/la;
+	double w  = (l > 20.0) ? w1 : w0;
+	double e, t, q;
+
+	for (int k=0; k<2; k++)
+	{
+	    e  = l - log(w) - w;
+	    t  = 1.0 + w;
+	    q  = 2.0*t*(t + 2.0*e/3.0);
+	    w *= 1.0 + e/t*(q - e)/(q - 2.0*e);
+	}
+	W[i] = w;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FullLnZ
+ *
+ * Description : Argument of W for the full model, 
+ *   ln z = ln(Is Rs Rsh/(a (Rs+Rsh))) + Rsh (V + Is Rs)/(a (Rs+Rsh))
+ *
+ * Inputs : V          - voltages
+ *          L          - output ln z
+ *          N          - number of points
+ *          Is,a,Rs,Rsh - model parameters, a = n Vt
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DiodeFit::FullLnZ(const double *V, double *L, uint32_t N,
+		       double Is, double a, double Rs, double Rsh)
+{
+    const double c0 = log(Is) + log(Rs) + log(Rsh) - log(a) - log(Rs + Rsh);
+    const double c1 = Rsh/(a*(Rs + Rsh));
+    const double c2 = Is*Rs;
+
+    for (uint32_t i=0; i<N; i++)
+    {
+	L[i] = c0 + c1*(V[i] + c2);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Full
+ *
+ * Description : Full model over a curve. The output array holds
+ *               ln z then W on the way through.
+ *
+ * Inputs : V - voltages
+ *          I - output currents
+ *          N - number of points
+ *          p - parameters
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DiodeFit::Full(const double *V, double *I, uint32_t N,
+		    const DiodeParams &p) const
+{
+    const double a = p.n*ThermalVoltage();
+
+    FullLnZ(V, I, N, p.Is, a, p.Rs, p.Rsh);
+    LambertWLog(I, I, N);
+    for (uint32_t i=0; i<N; i++)
+    {
+	I[i] = (V[i] - p.Is*p.Rsh)/(p.Rs + p.Rsh) + (a/p.Rs)*I[i];
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Full
+ *
+ * Description : Full model at one voltage.
+ *
+ * Inputs : V - voltage
+ *          p - parameters
+ *
+ * Returns : current
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DiodeFit::Full(double V, const DiodeParams &p) const
+{
+    double I;
+    Full(&V, &I, 1, p);
+    return I;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FullGuess
+ *
+ * Description : Starting point for the full model from the selected
+ *               points. A Shockley line through all of them is no
+ *               good, the shunt flattens the bottom and Rs the top, 
+ *               and started from there the fit can run Rs off to 
+ *               zero. Instead:
+ *                 Is, n - the steepest straight ln(I) against V over
+ *                         a window of a tenth of the points, starting
+ *                         above 5 kT/q.
+ *                 Rs    - mean voltage in excess of that line over
+ *                         the top decade of current, divided by I.
+ *                 Rsh   - V over the current in excess of the line
+ *                         below the window.
+ *
+ * Inputs : p - output
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : fewer than 5 points, no rising window.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::FullGuess(DiodeParams &p)
+{
+    SET_DEBUG_STACK;
+    const uint32_t n = fV.size();
+    std::vector<uint32_t> idx(n);
+    std::vector<double>   v, l;
+    uint32_t i, k, w, best = 0, cnt;
+    double   Sx = 0.0, Sy = 0.0, Sxx = 0.0, Sxy = 0.0;
+    double   det, slope, bslope = 0.0, bint = 0.0;
+    double   a, Ii, dv, sum, sumV, sumI, Imax = 0.0, Vmax = 0.0, Rmax = 0.0;
+
+    if (n < 5)
+    {
+	return false;
+    }
+
+    // Windows are taken in voltage order.
+    for (i=0; i<n; i++) idx[i] = i;
+    std::sort(idx.begin(), idx.end(), 
+	      [this](uint32_t x, uint32_t y) {return fV[x] < fV[y];});
+    v.resize(n);
+    l.resize(n);
+    for (i=0; i<n; i++)
+    {
+	v[i] = fV[idx[i]];
+	l[i] = fLnI[idx[i]];
+	Imax = fmax(Imax, exp(l[i]));
+	Vmax = fmax(Vmax, v[i]);
+	Rmax = fmax(Rmax, v[i]*exp(-l[i]));
+    }
+
+    // Running sums over a sliding window.
+    w = (n/10 > 5) ? n/10 : 5;
+    for (k=0; k<n; k++)
+    {
+	Sx  += v[k];
+	Sy  += l[k];
+	Sxx += v[k]*v[k];
+	Sxy += v[k]*l[k];
+	if (k >= w)
+	{
+	    i    = k - w;
+	    Sx  -= v[i];
+	    Sy  -= l[i];
+	    Sxx -= v[i]*v[i];
+	    Sxy -= v[i]*l[i];
+	}
+	// Below a few kT/q ln(I) goes as ln(V), steep but not the diode.
+	if ((k + 1 >= w) && (v[k + 1 - w] > kGuessVt*ThermalVoltage()))
+	{
+	    det = w*Sxx - Sx*Sx;
+	    if (det > 0.0)
+	    {
+		slope = (w*Sxy - Sx*Sy)/det;
+		if (slope > bslope)
+		{
+		    bslope = slope;
+		    bint   = (Sy - slope*Sx)/w;
+		    best   = k + 1 - w;
+		}
+	    }
+	}
+    }
+    if (bslope <= 0.0)
+    {
+	return false;
+    }
+    p.Is = exp(bint);
+    p.n  = 1.0/(bslope*ThermalVoltage());
+    a    = p.n*ThermalVoltage();
+
+    sum = 0.0;
+    cnt = 0;
+    sumV = sumI = 0.0;
+    for (i=0; i<n; i++)
+    {
+	Ii = exp(l[i]);
+	if (l[i] > log(Imax) - M_LN10)
+	{
+	    dv   = v[i] - a*log1p(Ii/p.Is);
+	    sum += fmax(dv, 0.0)/Ii;
+	    cnt++;
+	}
+	if (i < best)
+	{
+	    dv = Ii - p.Is*expm1(v[i]/a);
+	    if (dv > 0.0)
+	    {
+		sumV += v[i];
+		sumI += dv;
+	    }
+	}
+    }
+    p.Rs  = fmax((cnt > 0) ? sum/cnt : 0.0, 1.0e-6*Vmax/Imax);
+    p.Rsh = (sumI > 0.0) ? sumV/sumI : 10.0*Rmax;
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitFull
+ *
+ * Description : Fit Is, n, Rs and Rsh, from FullGuess unless warm
+ *               started.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *          p    - result, also starting point if Warm
+ *          Warm - start from p
+ *
+ * Returns : true if the fit converged
+ *
+ * Error Conditions : fewer than 5 forward points
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DiodeFit::FitFull(const double *V, const double *I, uint32_t N,
+		       DiodeParams &p, bool Warm)
+{
+    SET_DEBUG_STACK;
+    double   q[kDiodeParameters];
+    double   P[kDiodeParameters];
+    uint32_t i, j, n;
+    bool     rc;
+
+    if (Warm && (p.Is > 0.0) && (p.n > 0.0) && (p.Rs > 0.0) &&
+	(p.Rsh > 0.0) && std::isfinite(p.Rsh))
+    {
+	n = Select(V, I, N);
+    }
+    else
+    {
+	n = Select(V, I, N);
+	if (!FullGuess(p))
+	{
+	    p.Converged = false;
+	    return false;
+	}
+    }
+    if (n < 5)
+    {
+	p.Converged = false;
+	return false;
+    }
+    q[0] = log(p.Is);
+    q[1] = log(p.n);
+    q[2] = log(p.Rs);
+    q[3] = log(p.Rsh);
+
+    rc = Minimize(kFull, 4, q, p);
+
+    for (i=0; i<kDiodeParameters; i++) P[i] = exp(q[i]);
+    p.Is  = P[0];
+    p.n   = P[1];
+    p.Rs  = P[2];
+    p.Rsh = P[3];
+    // d(Is,n,Rs,Rsh)/dq is diagonal, P itself.
+    for (i=0; i<kDiodeParameters; i++)
+    {
+	for (j=0; j<kDiodeParameters; j++) p.Cov[i][j] *= P[i]*P[j];
+	p.Error[i] = sqrt(fabs(p.Cov[i][i]));
+    }
+    SET_DEBUG_STACK;
+    return rc;
+}
@@ -0,0 +1,272 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : DiodeFit.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Compiled fits of the diode equation. A small
+ *               Levenberg-Marquardt minimizer with analytic
+ *               derivatives, the residuals are taken in log space,
+ *               ln(I) measured against ln(I) model, which keeps the
+ *               exponential well behaved over many decades of
+ *               current. The starting point comes from a straight
+ *               line fit of ln(I) against V.
+ *
+ *               Shockley: I = Is (exp(V/(n Vt)) - 1)
+ *
+ *               Full:     I = Is (exp((V - I Rs)/(n Vt)) - 1)
+ *                             + (V - I Rs)/Rsh
+ *
+ *               Vt = kT/q
+ *
+ *               The full model is implicit in I. It is made explicit
+ *               with the Lambert W function, a = n Vt:
+ *
+ *               I = (V - Is Rsh)/(Rs + Rsh) + (a/Rs) W(z)
+ *
+ *               ln z = ln(Is Rs Rsh/(a (Rs + Rsh)))
+ *                      + Rsh (V + Is Rs)/(a (Rs + Rsh))
+ *
+ *               z itself overflows a double long before the diode is
+ *               in trouble, so W is evaluated from ln z.
+ *
+ * Restrictions/Limitations :
+ *               Only points with V>0 and I>0 take part in the fit.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               https://en.wikipedia.org/wiki/Diode_modelling
+ *               Numerical Recipes, 15.5 Nonlinear Models
+ *               A. Jain, A. Kapoor, "Exact analytical solutions of the
+ *               parameters of real solar cells using Lambert
+ *               W-function", Sol. Energy Mater. Sol. Cells 81 (2004)
+ *               D.A. Barry et al, "Analytical approximations for real
+ *               values of the Lambert W-function", Math. Comput.
+ *               Simul. 53 (2000), Fritsch iteration.
+ *               S. Winitzki, "Uniform approximations for
+ *               transcendental functions", ICCSA 2003.
+ *
+ *******************************************************************
+ */
+#ifndef __DIODEFIT_hh_
+#define __DIODEFIT_hh_
+#include <stdint.h>
+#include <vector>
+
+/*! Number of parameters in the most general model. */
+const uint32_t kDiodeParameters = 4;
+
+/// Result of a diode fit.
+struct DiodeParams {
+    double   Is;         /*! Saturation current (A)             */
+    double   n;          /*! Ideality factor                    */
+    double   Rs;         /*! Series resistance (Ohm)            */
+    double   Rsh;        /*! Shunt resistance (Ohm)             */
+    /*! 1 sigma errors on Is, n, Rs, Rsh, zero if not fitted.   */
+    double   Error[kDiodeParameters];
+    /*! Covariance of Is, n, Rs, Rsh.                           */
+    double   Cov[kDiodeParameters][kDiodeParameters];
+    double   Chi2;       /*! Sum of squared log residuals.      */
+    uint32_t NDF;        /*! Points used less parameters.       */
+    uint32_t Iterations; /*! LM iterations taken.               */
+    bool     Converged;
+};
+
+/// DiodeFit documentation here.
+class DiodeFit {
+public:
+    /*! Which form of the diode equation. */
+    enum Model {kShockley=0, kFull};
+
+    /*!
+     * Description:
+     *   Create a fitter.
+     *
+     * Arguments:
+     *   Temperature - junction temperature in Kelvin.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    DiodeFit(double Temperature = 293.15);
+
+    /*!
+     * Description:
+     *   Starting values from a straight line fit of ln(I) against V
+     *   over the forward points. The slope is 1/(n Vt), the
+     *   intercept ln(Is).
+     *
+     * Arguments:
+     *   V, I - data
+     *   N    - number of points
+     *   p    - filled with Is and n, Rs = 0, Rsh = infinite.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   Fewer than 2 forward points or a non-positive slope.
+     */
+    bool InitialGuess(const double *V, const double *I, uint32_t N,
+		      DiodeParams &p);
+
+    /*!
+     * Description:
+     *   Fit the Shockley equation.
+     *
+     * Arguments:
+     *   V, I - data
+     *   N    - number of points
+     *   p    - result. If Warm is true p also holds the starting
+     *          point, typically the result of a previous fit.
+     *   Warm - use p as the starting point rather than InitialGuess.
+     *
+     * Returns:
+     *   true if the fit converged.
+     *
+     * Errors:
+     *   Too few forward points.
+     */
+    bool FitShockley(const double *V, const double *I, uint32_t N,
+		     DiodeParams &p, bool Warm = false);
+
+    /*!
+     * Description:
+     *   Evaluate the Shockley equation.
+     *
+     * Arguments:
+     *   V - voltage
+     *   p - parameters
+     *
+     * Returns:
+     *   current
+     *
+     * Errors:
+     *   NONE
+     */
+    double Shockley(double V, const DiodeParams &p) const;
+
+    /*!
+     * Description:
+     *   Fit the full model, Is, n, Rs and Rsh. All four are fit in
+     *   log so they stay positive. 
+     *
+     * Arguments:
+     *   V, I - data
+     *   N    - number of points
+     *   p    - result. If Warm is true p also holds the starting
+     *          point. Otherwise the start is a Shockley fit with Rs
+     *          estimated from the excess voltage at the top of the
+     *          curve.
+     *   Warm - use p as the starting point.
+     *
+     * Returns:
+     *   true if the fit converged.
+     *
+     * Errors:
+     *   Too few forward points.
+     */
+    bool FitFull(const double *V, const double *I, uint32_t N,
+		 DiodeParams &p, bool Warm = false);
+
+    /*!
+     * Description:
+     *   Evaluate the full model over a whole curve in one pass.
+     *
+     * Arguments:
+     *   V - voltages
+     *   I - output currents
+     *   N - number of points
+     *   p - parameters, Rs and Rsh must be positive and finite.
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void   Full(const double *V, double *I, uint32_t N,
+		const DiodeParams &p) const;
+    /*! Single point version of the above. */
+    double Full(double V, const DiodeParams &p) const;
+
+    /*!
+     * Description:
+     *   Principal branch of the Lambert W function, w exp(w) = z,
+     *   given ln z, for a batch of points. The loop body has no
+     *   branches so the compiler can vectorize it. A Winitzki
+     *   approximation, or the asymptotic series for large z, is
+     *   refined by two Fritsch iterations which are fourth order,
+     *   good to a few ulp.
+     *
+     * Arguments:
+     *   LnZ - ln z, z > 0. Below -700 z is taken as exp(-700).
+     *   W   - output, may be the same array as LnZ.
+     *   N   - number of points
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    static void LambertWLog(const double *LnZ, double *W, uint32_t N);
+
+    inline void   Temperature(double K) {fTemperature = K;};
+    inline double Temperature(void) const {return fTemperature;};
+    /*! kT/q at the set temperature. */
+    double        ThermalVoltage(void) const;
+
+    /*! Iteration limit and convergence tolerance on chi2. */
+    inline void   MaxIterations(uint32_t n) {fMaxIterations = n;};
+    inline void   Tolerance(double t) {fTolerance = t;};
+
+private:
+    /*!
+     * Copy the usable points into the scratch arrays. Returns the
+     * number of points kept.
+     */
+    uint32_t Select(const double *V, const double *I, uint32_t N);
+
+    /*!
+     * Residuals and Jacobian for the model at parameters q.
+     * Returns the sum of squares, HUGE_VAL if the model current
+     * is not positive somewhere.
+     */
+    double   Evaluate(Model m, const double *q, bool Jacobian);
+
+    /*! Levenberg-Marquardt on the selected points. */
+    bool     Minimize(Model m, uint32_t npar, double *q, DiodeParams &p);
+
+    /*! Starting point for the full model from the selected points. */
+    bool     FullGuess(DiodeParams &p);
+
+    /*! ln z for the full model at each V, into fL. */
+    static void FullLnZ(const double *V, double *L, uint32_t N,
+			double Is, double a, double Rs, double Rsh);
+
+    /*! Solve the npar x npar system A x = b in place, false if singular.*/
+    static bool Solve(uint32_t npar, double *A, double *b);
+
+    double   fTemperature;
+    uint32_t fMaxIterations;
+    double   fTolerance;
+
+    /*
+     * Scratch buffers, reused from fit to fit so that a fitter
+     * kept per thread allocates nothing once warmed up.
+     */
+    std::vector<double> fV;     /*! Selected voltages         */
+    std::vector<double> fLnI;   /*! ln of selected currents   */
+    std::vector<double> fR;     /*! Residuals                 */
+    std::vector<double> fJ;     /*! Jacobian, N x kDiodeParameters */
+    std::vector<double> fW;     /*! Lambert W per point       */
+};
+#endif
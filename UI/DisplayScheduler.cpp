@@ -0,0 +1,242 @@
+/********************************************************************
+ *
+ * Module Name : DisplayScheduler.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Frame rate limiting for the live plot.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <time.h>
+
+// Local Includes.
+#include "debug.h"
+#include "DisplayScheduler.hh"
+
+/*
+ * Drawing may take at most this fraction of the wall clock. If a
+ * frame takes 40ms to draw the interval becomes at least 160ms.
+ */
+const double kMaxDutyCycle = 0.25;
+/* Weight of the newest frame in the smoothed draw time. */
+const double kDrawSmoothing = 0.25;
+/* Never slower than this no matter how slow X is. (seconds) */
+const double kMaxInterval   = 5.0;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : DisplayScheduler constructor
+ *
+ * Description :
+ *
+ * Inputs : Hz - maximum frames per second.
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+DisplayScheduler::DisplayScheduler(double Hz)
+{
+    SET_DEBUG_STACK;
+    fMinInterval = 0.1;
+    MaxRate(Hz);
+    Reset();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MaxRate
+ *
+ * Description : Set the maximum frame rate.
+ *
+ * Inputs : Hz - frames per second, non positive values are ignored
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DisplayScheduler::MaxRate(double Hz)
+{
+    SET_DEBUG_STACK;
+    if (Hz > 0.0)
+    {
+	fMinInterval = 1.0/Hz;
+    }
+    fInterval = fMinInterval;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reset
+ *
+ * Description : Start fresh, typically at the beginning of a sweep.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DisplayScheduler::Reset(void)
+{
+    SET_DEBUG_STACK;
+    fInterval  = fMinInterval;
+    fLastFrame = 0.0;
+    fDrawStart = 0.0;
+    fDrawTime  = 0.0;
+    fFrames    = 0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Now
+ *
+ * Description : Monotonic clock in seconds.
+ *
+ * Inputs : NONE
+ *
+ * Returns : time in seconds
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double DisplayScheduler::Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Due
+ *
+ * Description : Is it time for another frame?
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if at least one interval elapsed since the last frame
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool DisplayScheduler::Due(void) const
+{
+    return ((Now() - fLastFrame) >= fInterval);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Begin
+ *
+ * Description : Mark the start of drawing a frame.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DisplayScheduler::Begin(void)
+{
+    fDrawStart = Now();
+    fLastFrame = fDrawStart;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : End
+ *
+ * Description : Mark the end of drawing a frame. The smoothed draw
+ *               time is updated and the interval stretched if
+ *               drawing is taking more than kMaxDutyCycle of the
+ *               time. As the draw time comes back down the interval
+ *               relaxes back to 1/MaxRate.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void DisplayScheduler::End(void)
+{
+    double dt = Now() - fDrawStart;
+    double want;
+
+    if (fFrames == 0)
+    {
+	fDrawTime = dt;
+    }
+    else
+    {
+	fDrawTime += kDrawSmoothing*(dt - fDrawTime);
+    }
+    fFrames++;
+
+    want = fDrawTime/kMaxDutyCycle;
+    if (want < fMinInterval) want = fMinInterval;
+    if (want > kMaxInterval) want = kMaxInterval;
+    fInterval = want;
+}
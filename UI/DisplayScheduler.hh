@@ -0,0 +1,122 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : DisplayScheduler.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Decide when the live plot is to be redrawn. Points
+ *               are acquired at whatever rate the instruments allow,
+ *               the display is refreshed at most MaxRate times per
+ *               second and backs off further if drawing is slow,
+ *               e.g. when running over a remote X connection.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __DISPLAYSCHEDULER_hh_
+#define __DISPLAYSCHEDULER_hh_
+#include <stdint.h>
+
+/// DisplayScheduler documentation here.
+class DisplayScheduler {
+public:
+
+    /*!
+     * Description:
+     *   Create a scheduler for display refreshes.
+     *
+     * Arguments:
+     *   Hz - maximum number of frames per second.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    DisplayScheduler(double Hz);
+
+    /*!
+     * Description:
+     *   Forget the draw timing history, call at the start of a sweep.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void Reset(void);
+
+    /*!
+     * Description:
+     *   Has enough time elapsed since the last frame to draw another?
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   true if a frame may be drawn now.
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Due(void) const;
+
+    /*!
+     * Description:
+     *   Bracket the drawing of a frame. The time between Begin and
+     *   End is used to lengthen the frame interval such that drawing
+     *   never takes more than a fixed fraction of the wall clock.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void Begin(void);
+    void End(void);
+
+    /*! Maximum frame rate in Hz. */
+    void   MaxRate(double Hz);
+    inline double MaxRate(void) const {return 1.0/fMinInterval;};
+
+    /*! Current frame interval in seconds. */
+    inline double Interval(void) const {return fInterval;};
+    /*! Current frame interval in milliseconds, suitable for a TTimer.*/
+    inline uint32_t IntervalMS(void) const
+	{return (uint32_t)(fInterval*1000.0 + 0.5);};
+
+    /*! Smoothed time in seconds taken to draw one frame. */
+    inline double DrawTime(void) const {return fDrawTime;};
+
+    /*! Number of frames drawn since the last Reset. */
+    inline uint32_t Frames(void) const {return fFrames;};
+
+private:
+    /*! Monotonic wall clock in seconds. */
+    static double Now(void);
+
+    double   fMinInterval;   /*! 1/MaxRate                          */
+    double   fInterval;      /*! Interval in use, >= fMinInterval   */
+    double   fLastFrame;     /*! Time the last frame was started    */
+    double   fDrawStart;     /*! Time the current frame was started */
+    double   fDrawTime;      /*! Smoothed draw time.                */
+    uint32_t fFrames;        /*! Frames drawn.                      */
+};
+#endif
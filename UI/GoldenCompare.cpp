@@ -0,0 +1,382 @@
+/********************************************************************
+ *
+ * Module Name : GoldenCompare.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Golden reference comparison of I-V sweeps.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <algorithm>
+
+// Local Includes.
+#include "debug.h"
+#include "GoldenCompare.hh"
+
+/* Sort helper, order points by voltage. */
+struct ByVoltage {
+    const double *V;
+    bool operator()(uint32_t a, uint32_t b) const {return V[a] < V[b];};
+};
+
+/**
+ ******************************************************************
+ *
+ * Function Name : GoldenCompare constructor
+ *
+ * Description :
+ *
+ * Inputs : NGrid - points on the common grid
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+GoldenCompare::GoldenCompare(uint32_t NGrid)
+{
+    SET_DEBUG_STACK;
+    fNGrid = (NGrid > 1) ? NGrid : 2;
+    fRel   = 0.05;
+    fAbs   = 1.0e-9;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Band
+ *
+ * Description : Set the tolerance band, the band on the grid is 
+ *               redone if there is a reference.
+ *
+ * Inputs : Rel - fraction of |Iref|
+ *          Abs - amps
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void GoldenCompare::Band(double Rel, double Abs)
+{
+    fRel = fabs(Rel);
+    fAbs = fabs(Abs);
+    for (uint32_t k=0; k<fRef.size(); k++)
+    {
+	fBand[k] = fAbs + fRel*fabs(fRef[k]);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Prepare
+ *
+ * Description : Sort the points, a sweep normally arrives in order
+ *               so the sort is skipped, and work out the slopes.
+ *               Interior slopes are the weighted harmonic mean of
+ *               the neighbouring secants, zero where they change
+ *               sign, which keeps each piece monotone. The end
+ *               slopes are the end secants.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *
+ * Returns : number of knots
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t GoldenCompare::Prepare(const double *V, const double *I, uint32_t N)
+{
+    uint32_t  i, n, count;
+    bool      sorted = true;
+    ByVoltage cmp;
+    double    h0, h1, s0, s1, w0, w1;
+
+    fX.resize(N);
+    fY.resize(N);
+    for (i=1; i<N; i++)
+    {
+	if (!(V[i] > V[i-1]))
+	{
+	    sorted = false;
+	    break;
+	}
+    }
+    if (sorted)
+    {
+	std::copy(V, V+N, fX.begin());
+	std::copy(I, I+N, fY.begin());
+	n = N;
+    }
+    else
+    {
+	fOrder.resize(N);
+	for (i=0; i<N; i++) fOrder[i] = i;
+	cmp.V = V;
+	std::stable_sort(fOrder.begin(), fOrder.end(), cmp);
+	// Repeated voltages, a return sweep for one, are averaged.
+	n = 0;
+	for (i=0; i<N; i++)
+	{
+	    if ((n > 0) && (V[fOrder[i]] == fX[n-1]))
+	    {
+		fY[n-1] += I[fOrder[i]];
+		count++;
+		continue;
+	    }
+	    if (n > 0) fY[n-1] /= count;
+	    fX[n] = V[fOrder[i]];
+	    fY[n] = I[fOrder[i]];
+	    count = 1;
+	    n++;
+	}
+	if (n > 0) fY[n-1] /= count;
+    }
+    if (n < 2)
+    {
+	return n;
+    }
+
+    fD.resize(n);
+    fD[0]   = (fY[1] - fY[0])/(fX[1] - fX[0]);
+    fD[n-1] = (fY[n-1] - fY[n-2])/(fX[n-1] - fX[n-2]);
+    for (i=1; i<n-1; i++)
+    {
+	h0 = fX[i]   - fX[i-1];
+	h1 = fX[i+1] - fX[i];
+	s0 = (fY[i]   - fY[i-1])/h0;
+	s1 = (fY[i+1] - fY[i])/h1;
+	if (s0*s1 <= 0.0)
+	{
+	    fD[i] = 0.0;
+	}
+	else
+	{
+	    w0    = 2.0*h1 + h0;
+	    w1    = h1 + 2.0*h0;
+	    fD[i] = (w0 + w1)/(w0/s0 + w1/s1);
+	}
+    }
+    return n;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Evaluate
+ *
+ * Description : Cubic Hermite at the grid points. The segment of
+ *               each point is found first, the grid and the knots
+ *               are both in order so that is one pass. 
+ *
+ * Inputs : lo, hi - grid points to do
+ *          out    - result on the grid
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void GoldenCompare::Evaluate(uint32_t lo, uint32_t hi, double *out)
+{
+    const uint32_t last = fX.size() - 2;
+    const double   *X   = &fX[0];
+    const double   *Y   = &fY[0];
+    const double   *D   = &fD[0];
+    const double   *G   = &fGrid[0];
+    uint32_t       *S   = &fSeg[0];
+    uint32_t       j    = 0;
+
+    for (uint32_t k=lo; k<hi; k++)
+    {
+	while ((j < last) && (X[j+1] < G[k])) j++;
+	S[k] = j;
+    }
+    for (uint32_t k=lo; k<hi; k++)
+    {
+	const uint32_t s  = S[k];
+	const double   h  = X[s+1] - X[s];
+	const double   t  = (G[k] - X[s])/h;
+	const double   t2 = t*t;
+	const double   t3 = t2*t;
+	out[k] = (2.0*t3 - 3.0*t2 + 1.0)*Y[s] + (t3 - 2.0*t2 + t)*h*D[s] +
+	    (3.0*t2 - 2.0*t3)*Y[s+1] + (t3 - t2)*h*D[s+1];
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reference
+ *
+ * Description : Lay the grid over the reference range, put the
+ *               reference on it and work out the band.
+ *
+ * Inputs : V, I - reference
+ *          N    - number of points
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : too few distinct voltages
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool GoldenCompare::Reference(const double *V, const double *I, uint32_t N)
+{
+    SET_DEBUG_STACK;
+    uint32_t n = Prepare(V, I, N);
+    double   lo, dv;
+
+    fRef.clear();
+    if (n < 2)
+    {
+	return false;
+    }
+    lo = fX[0];
+    dv = (fX[n-1] - lo)/(fNGrid - 1);
+    fGrid.resize(fNGrid);
+    for (uint32_t k=0; k<fNGrid; k++)
+    {
+	fGrid[k] = lo + k*dv;
+    }
+    // Keep the last point on the last knot against rounding.
+    fGrid[fNGrid-1] = fX[n-1];
+    fSeg.resize(fNGrid);
+    fRef.resize(fNGrid);
+    fBand.resize(fNGrid);
+    fTest.assign(fNGrid, 0.0);
+    Evaluate(0, fNGrid, &fRef[0]);
+    Band(fRel, fAbs);
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Compare
+ *
+ * Description : Put the test sweep on the grid and score it. 
+ *
+ * Inputs : V, I - test sweep
+ *          N    - number of points
+ *          r    - result
+ *
+ * Returns : true if the comparison was made
+ *
+ * Error Conditions : no reference, too few distinct voltages
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool GoldenCompare::Compare(const double *V, const double *I, uint32_t N,
+			    GoldenResult &r)
+{
+    SET_DEBUG_STACK;
+    const uint32_t M = fGrid.size();
+    uint32_t       n, lo, hi, k, nfail, kmax;
+    double         sum, dev, ratio, maxratio, maxdev;
+
+    r.Pass     = false;
+    r.NGrid    = M;
+    r.NCovered = 0;
+    r.NFail    = M;
+    r.MaxDev   = r.VMaxDev = r.RMS = r.MaxRatio = 0.0;
+    if (!HasReference())
+    {
+	return false;
+    }
+    n = Prepare(V, I, N);
+    if (n < 2)
+    {
+	return false;
+    }
+
+    // The part of the grid the test sweep covers.
+    lo = std::lower_bound(fGrid.begin(), fGrid.end(), fX[0]) - fGrid.begin();
+    hi = std::upper_bound(fGrid.begin(), fGrid.end(), fX[n-1]) - 
+	fGrid.begin();
+    std::fill(fTest.begin(), fTest.end(), NAN);
+    if (hi <= lo)
+    {
+	return true;
+    }
+    Evaluate(lo, hi, &fTest[0]);
+
+    sum      = 0.0;
+    nfail    = 0;
+    maxratio = 0.0;
+    maxdev   = 0.0;
+    kmax     = lo;
+    for (k=lo; k<hi; k++)
+    {
+	dev      = fabs(fTest[k] - fRef[k]);
+	ratio    = dev/fBand[k];
+	sum     += dev*dev;
+	nfail   += (ratio > 1.0);
+	maxratio = std::max(maxratio, ratio);
+	maxdev   = std::max(maxdev, dev);
+    }
+    // Where the worst one was, only once.
+    for (k=lo; k<hi; k++)
+    {
+	if (fabs(fTest[k] - fRef[k]) == maxdev)
+	{
+	    kmax = k;
+	    break;
+	}
+    }
+
+    r.NCovered = hi - lo;
+    r.NFail    = nfail + (M - r.NCovered);
+    r.MaxDev   = maxdev;
+    r.VMaxDev  = fGrid[kmax];
+    r.RMS      = sqrt(sum/r.NCovered);
+    r.MaxRatio = maxratio;
+    r.Pass     = (r.NFail == 0);
+    SET_DEBUG_STACK;
+    return true;
+}
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : GoldenCompare.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Compare a sweep against the golden reference curve
+ *               for the part number, incoming inspection.
+ *
+ *               Both curves are put on one voltage grid, evenly
+ *               spaced over the reference range, with monotone cubic
+ *               (Fritsch-Carlson, PCHIP) interpolation. That keeps
+ *               the knee free of the overshoot a spline gives and
+ *               does not invent bumps between points.
+ *
+ *               Each grid point has a band
+ *                   |Itest - Iref| <= Abs + Rel |Iref|
+ *               The curve passes if every grid point is inside its
+ *               band. Max and RMS deviation are reported as well as
+ *               the worst deviation in units of the band.
+ *
+ *               The reference side, its grid and the band are
+ *               worked out once when the reference is set. A check
+ *               finds the segment for each grid point in one merge
+ *               pass, then the Hermite evaluation and the scoring are
+ *               plain loops over the grid with no branches so the
+ *               compiler vectorizes them. With the default 512 point
+ *               grid a check is a few microseconds.
+ *
+ * Restrictions/Limitations :
+ *               Grid points the test sweep does not reach count as
+ *               failures.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *               F.N. Fritsch, R.E. Carlson, "Monotone Piecewise Cubic
+ *               Interpolation", SIAM J. Numer. Anal. 17 (1980)
+ *
+ *******************************************************************
+ */
+#ifndef __GOLDENCOMPARE_hh_
+#define __GOLDENCOMPARE_hh_
+#include <stdint.h>
+#include <vector>
+
+/// Outcome of one check.
+struct GoldenResult {
+    bool     Pass;
+    uint32_t NGrid;      /*! Grid points                          */
+    uint32_t NCovered;   /*! Grid points inside the test sweep    */
+    uint32_t NFail;      /*! Out of band, uncovered included      */
+    double   MaxDev;     /*! max |Itest - Iref| (A)               */
+    double   VMaxDev;    /*! Voltage of MaxDev                    */
+    double   RMS;        /*! RMS of Itest - Iref (A)              */
+    double   MaxRatio;   /*! max |Itest - Iref|/band              */
+};
+
+/// GoldenCompare documentation here.
+class GoldenCompare {
+public:
+    /*!
+     * Description:
+     *   Create an empty comparison.
+     *
+     * Arguments:
+     *   NGrid - grid points
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    GoldenCompare(uint32_t NGrid = 512);
+
+    /*!
+     * Description:
+     *   Set the reference curve.
+     *
+     * Arguments:
+     *   V, I - reference data, any order.
+     *   N    - number of points
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   Fewer than 2 distinct voltages.
+     */
+    bool Reference(const double *V, const double *I, uint32_t N);
+
+    /*!
+     * Description:
+     *   Check a sweep against the reference.
+     *
+     * Arguments:
+     *   V, I - test data, any order.
+     *   N    - number of points
+     *   r    - result
+     *
+     * Returns:
+     *   true if the check could be made, r.Pass has the verdict.
+     *
+     * Errors:
+     *   No reference or fewer than 2 distinct test voltages.
+     */
+    bool Compare(const double *V, const double *I, uint32_t N,
+		 GoldenResult &r);
+
+    /*! Tolerance band, relative and absolute (A). */
+    void Band(double Rel, double Abs);
+
+    inline bool     HasReference(void) const {return !fRef.empty();};
+    inline uint32_t NGrid(void) const {return fGrid.size();};
+    inline const double* Grid(void)    const {return &fGrid[0];};
+    /*! Reference and the last test sweep on the grid. */
+    inline const double* Ref(void)     const {return &fRef[0];};
+    inline const double* Test(void)    const {return &fTest[0];};
+
+private:
+    /*!
+     * Sort the points by V into fX, fY, averaging repeated voltages,
+     * and compute the PCHIP slopes fD. Returns the number of knots.
+     */
+    uint32_t Prepare(const double *V, const double *I, uint32_t N);
+
+    /*!
+     * Interpolate the prepared curve at the grid points lo..hi-1,
+     * which lie within the knots.
+     */
+    void     Evaluate(uint32_t lo, uint32_t hi, double *out);
+
+    uint32_t            fNGrid;
+    double              fRel, fAbs;
+
+    // Prepared curve, reused for reference and test.
+    std::vector<double>   fX, fY, fD;
+    std::vector<uint32_t> fOrder;
+    std::vector<uint32_t> fSeg;     /*! knot segment per grid point */
+
+    std::vector<double> fGrid;
+    std::vector<double> fRef;
+    std::vector<double> fBand;      /*! Abs + Rel |Iref|            */
+    std::vector<double> fTest;
+};
+#endif
@@ -0,0 +1,108 @@
+/********************************************************************
+ *
+ * Module Name : GpibBackend.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : The part of the backend interface all share.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <cmath>
+#include <ctime>
+
+// Local Includes.
+#include "GpibBackend.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Wait
+ *
+ * Description : Sleep, the time really passes.
+ *
+ * Inputs : s - seconds
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void GpibBackend::Wait(double s)
+{
+    struct timespec sleeptime;
+
+    if (s <= 0.0) return;
+    sleeptime.tv_sec  = (time_t) s;
+    sleeptime.tv_nsec = (long)((s - floor(s))*1.0e9);
+    nanosleep(&sleeptime, NULL);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Now
+ *
+ * Description : The system clock.
+ *
+ * Inputs : NONE
+ *
+ * Returns : seconds since the epoch
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double GpibBackend::Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (double) now.tv_sec + 1.0e-9 * (double) now.tv_nsec;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Elapsed
+ *
+ * Description : The monotonic clock.
+ *
+ * Inputs : NONE
+ *
+ * Returns : seconds from an arbitrary start
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double GpibBackend::Elapsed(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1.0e-9 * (double) now.tv_nsec;
+}
@@ -0,0 +1,144 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : GpibBackend.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : What Instruments asks of the Keithley 196 and 230,
+ *               in one place. The real instruments are behind
+ *               KeithleyBackend. TraceRecorder sits in front of any
+ *               backend and writes each call to a trace file,
+ *               TraceReplay answers from such a trace with no GPIB
+ *               at all, so a run from the lab can be taken again on
+ *               any machine.
+ *
+ *               Every call but Wait, Now and Elapsed is one entry in a
+ *               trace, the Call numbers below are the trace codes and
+ *               must not be changed, only added to.
+ *
+ *               Instruments takes all its time from Wait, Now and
+ *               Elapsed. Now is the wall clock for time stamps,
+ *               Elapsed a clock that is never set back, for
+ *               intervals. A simulated or fast replayed backend keeps
+ *               a clock of its own that only they move and serves
+ *               both from it, a sweep that takes half an hour on the
+ *               bench is over in milliseconds and sees the same times
+ *               it would have.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __GPIBBACKEND_hh_
+#define __GPIBBACKEND_hh_
+#include <stdint.h>
+
+/// GpibBackend documentation here.
+class GpibBackend {
+public:
+    /*! Trace codes, one per call. */
+    enum Call {kMeterFunction=1, kMeterRange, kMeterRate, kMeterTrigger,
+	       kMeterRead, kMeterStatus, kSourceOperate, kSourceLimit,
+	       kSourceVoltage, kSourceProgram, kSourceExecute, kNCalls};
+
+    virtual ~GpibBackend(void) {};
+
+    /*! Is each instrument there, and where. */
+    virtual bool    MeterOK(void)  const = 0;
+    virtual bool    SourceOK(void) const = 0;
+    virtual uint8_t MeterAddress(void)  const = 0;
+    virtual uint8_t SourceAddress(void) const = 0;
+
+    /*!
+     * Keithley 196.
+     *   MeterFunction - DCA if Current, DCV otherwise
+     *   MeterRange    - 0 autorange, 1 the lowest range and up
+     *   MeterRate     - 0 for 3.5 digits to 3 for 6.5 digits
+     *   MeterTrigger  - one shot on X Delay s after it, or
+     *                   continuous on talk
+     *   MeterRead     - one reading
+     *   MeterStatus   - status word
+     */
+    virtual void    MeterFunction(bool Current) = 0;
+    virtual void    MeterRange(uint8_t Range) = 0;
+    virtual void    MeterRate(uint8_t Rate) = 0;
+    virtual void    MeterTrigger(bool OneShot, double Delay) = 0;
+    virtual double  MeterRead(void) = 0;
+    virtual int     MeterStatus(void) = 0;
+
+    /*!
+     * Keithley 230.
+     *   SourceOperate - voltage source, operate, Limit amps
+     *   SourceLimit   - current limit, amps
+     *   SourceVoltage - DC output, volts
+     *   SourceProgram - two location program run once per X, V for
+     *                   Width s then Base for Off s
+     *   SourceExecute - X, run the program
+     */
+    virtual void    SourceOperate(double Limit) = 0;
+    virtual void    SourceLimit(double A) = 0;
+    virtual void    SourceVoltage(double V) = 0;
+    virtual void    SourceProgram(double V, double Base, double Limit,
+				  double Width, double Off) = 0;
+    virtual void    SourceExecute(void) = 0;
+
+    /*!
+     * Description:
+     *   Let time pass between calls, settle times and pulse cool
+     *   down. A virtual clock is moved on instead.
+     *
+     * Arguments:
+     *   s - seconds
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    virtual void    Wait(double s);
+
+    /*!
+     * Description:
+     *   Time on the clock the instruments run on, the system clock
+     *   unless the backend keeps its own.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   seconds
+     *
+     * Errors:
+     *   NONE
+     */
+    virtual double  Now(void);
+
+    /*!
+     * Description:
+     *   Time to measure intervals by. The monotonic clock, so a
+     *   change to the system time does not stretch or shorten a
+     *   wait, unless the backend keeps its own.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   seconds from an arbitrary start
+     *
+     * Errors:
+     *   NONE
+     */
+    virtual double  Elapsed(void);
+
+    /*! True if Now and Elapsed are a virtual clock. */
+    virtual bool    Virtual(void) const {return false;};
+};
+#endif
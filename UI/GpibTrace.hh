@@ -0,0 +1,63 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : GpibTrace.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Layout of a GPIB trace file. A header
+ *
+ *                 Magic         "IVGT"
+ *                 Version       kGpibTraceVersion
+ *                 MeterAddress  196 address when recorded
+ *                 SourceAddress 230 address
+ *                 T0            s since the epoch at the start
+ *
+ *               then one record per backend call, a record header
+ *
+ *                 Call     - GpibBackend::Call
+ *                 N        - values that follow
+ *                 Delta    - us from the start of the call before
+ *                 Duration - us spent in the driver
+ *
+ *               followed by N doubles, the arguments of a command
+ *               or the answer to a read. A reading is 20 bytes.
+ *
+ * Restrictions/Limitations :
+ *               Native byte order, the lab machines and anything
+ *               the trace goes to are all little endian x86.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __GPIBTRACE_hh_
+#define __GPIBTRACE_hh_
+#include <stdint.h>
+
+const uint16_t kGpibTraceVersion = 1;
+/*! Most values in one record, SourceProgram has five. */
+const uint8_t  kGpibTraceMaxN    = 8;
+
+/// Start of a trace file.
+struct GpibTraceHeader {
+    char     Magic[4];
+    uint16_t Version;
+    uint8_t  MeterAddress;
+    uint8_t  SourceAddress;
+    double   T0;
+};
+
+/// Start of a record, N doubles follow.
+struct GpibTraceRecord {
+    uint8_t  Call;
+    uint8_t  N;
+    uint16_t Spare;
+    uint32_t Delta;
+    uint32_t Duration;
+};
+#endif
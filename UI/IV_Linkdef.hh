@@ -28,5 +28,6 @@
 #pragma link C++ class ParamDlg;
 #pragma link C++ class ParamPane;
 #pragma link C++ class CommentDlg;
+#pragma link C++ class OverlayDlg;
 
 #endif
@@ -33,7 +33,9 @@ using namespace std;
 #include <cmath>
 #include <csignal>
 #include <list>
+#include <vector>
 #include <fstream>
+#include <sstream>
 
 /// Root Includes
 #include <TROOT.h>
@@ -44,6 +46,7 @@ using namespace std;
 #include <TVirtualX.h>
 #include <TAxis.h>
 #include <TGraph.h>
+#include <TGraphErrors.h>
 #include <TGButton.h>
 #include <TGMenu.h>
 #include <TGFileDialog.h>
@@ -59,6 +62,11 @@ using namespace std;
 #include <TLatex.h>
 #include <TEnv.h>
 #include <TTimer.h>
+#include <TMultiGraph.h>
+#include <TLegend.h>
+#include <TList.h>
+#include <TObjString.h>
+#include <TMath.h>
 
 // Local Includes
 #include "debug.h"
@@ -67,6 +75,39 @@ using namespace std;
 #include "CLogger.hh"
 #include "ParamDialog.hh"
 #include "CommentDialog.hh"
+#include "DisplayScheduler.hh"
+#include "MinMaxPyramid.hh"
+#include "RunCache.hh"
+#include "OverlayDialog.hh"
+#include "DiodeFit.hh"
+#include "OnlineFit.hh"
+#include "RegionDetect.hh"
+#include "ThreadPool.hh"
+#include "Bootstrap.hh"
+#include "DerivedChannels.hh"
+#include "GoldenCompare.hh"
+#include "SweepFile.hh"
+#include "SampleStore.hh"
+#include "Recipe.hh"
+#include "RecipeQueue.hh"
+#include "ControlServer.hh"
+#include "ProfileStore.hh"
+#include "KeithleyBackend.hh"
+#include "TraceReplay.hh"
+#include "SimBackend.hh"
+
+/*
+ * Once there are more than this many points per pixel column across
+ * the pad the graph is drawn from its min/max envelope. 
+ */
+const Int_t kLODPointsPerPixel = 4;
+
+/*
+ * Sweep timer, ms. A point a tick at the bench, as fast as the
+ * display keeps up when the instruments run on a virtual clock.
+ */
+const Long_t kSweepTickMS   = 500;
+const Long_t kVirtualTickMS = 1;
 
 // Setup print queues. Way out of date!
 const char *PrintPrg[]  = {"/usr/bin/lpr","/usr/bin/lp"};
@@ -81,6 +122,12 @@ const char *filetypes[] = {
     "ROOT files",    "*.root",
     0,               0 };
 
+// Recipe queues
+static const char *QueueTypes[] = { 
+    "Queue files",   "*.queue",
+    "All files",     "*",
+    0,               0 };
+
 // Save as file types
 static const char *SPSaveTypes[] = {
     "PostScript",   "*.ps",
@@ -109,7 +156,14 @@ enum SVPCommandIdentifiers {
    M_INST_K196,
    M_INST_K230,
    M_INST_FIT,
+   M_INST_BOOTSTRAP,
+   M_INST_REFERENCE,
+   M_INST_COMPARE,
+   M_INST_QUEUE,
    M_INST_COMMENT,
+   M_VIEW_OVERLAY,
+   M_VIEW_RUNS,
+   M_VIEW_SINGLE,
 };
 
 /*
@@ -200,6 +254,52 @@ IVCurve::IVCurve(const TGWindow *p, UInt_t w, UInt_t h) :
     fLastDir     = new TString(".");
 
     fGraph       = NULL;
+    fStore       = new SampleStore();
+    fGraphDown   = new TGraphErrors();
+    fGraphDown->SetName("IVCurveDown");
+    fGraphDown->SetLineColor(kRed);
+    fGraphDown->SetMarkerColor(kRed);
+    fNDownPlotted = 0;
+    fViewScale   = 1.0;
+    fFrame       = NULL;
+    fNPlotted    = 0;
+    fNDerivedPlotted = 0;
+    fNLogIPlotted    = 0;
+    fPyramid     = new MinMaxPyramid();
+    fLODGraph    = new TGraph();
+    fLODGraph->SetName("IVCurveLOD");
+    fPyramidDown = new MinMaxPyramid();
+    fLODDown     = new TGraph();
+    fLODDown->SetName("IVCurveDownLOD");
+    fLODDown->SetLineColor(kRed);
+    fLODActive   = kFALSE;
+    fRuns        = new RunCache();
+    fOverlay     = NULL;
+    fLegend      = NULL;
+    fOverlayMode = kFALSE;
+    fOnline      = new OnlineFit(fTemperature, fOnlineRefine);
+    fRegions     = new RegionDetect(fTemperature);
+    fPool        = new ThreadPool(fThreads);
+    fBootstrap   = new Bootstrap(fPool, fTemperature);
+    fDerived     = new DerivedChannels(fSGHalfWidth);
+    fDerived->VfTargets(fVfCurrents);
+    fGdIdV       = new TGraph();
+    fGdIdV->SetName("dIdV");
+    fGdIdV->SetTitle("Differential conductance;V;dI/dV");
+    fGRdyn       = new TGraph();
+    fGRdyn->SetName("Rdyn");
+    fGRdyn->SetTitle("Dynamic resistance;V;dV/dI");
+    fGLogI       = new TGraph();
+    fGLogI->SetName("LogI");
+    fGLogI->SetTitle("log_{10}|I|;V;log_{10}|I|");
+    fGolden      = new GoldenCompare(fGoldenGrid);
+    fGolden->Band(fGoldenRel, fGoldenAbs);
+    LoadReference();
+    fQueue        = new RecipeQueue();
+    fQueueRunning = kFALSE;
+    fUntuned      = NULL;
+    fUserSettings = NULL;
+    fOnlineStable= kFALSE;
     fZoomLevel   = 2;
     fTakeData    = kFALSE;
 
@@ -216,6 +316,37 @@ IVCurve::IVCurve(const TGWindow *p, UInt_t w, UInt_t h) :
     CLogger::GetThis()->LogData("# IVcurve Timeout started.\n");
     //fTimer->Start(500, kFALSE);
 
+    /*
+     * The live plot is refreshed on its own timer so that drawing
+     * is not tied one to one with acquisition. 
+     */
+    fDisplay      = new DisplayScheduler(fDisplayRate);
+    fDisplayTimer = new TTimer();
+    fDisplayTimer->Connect("Timeout()", "IVCurve", this, "DisplayProc()");
+
+    /*
+     * Local control socket. It is polled on its own timer, a poll
+     * costs next to nothing when nobody is connected.
+     */
+    fControl      = NULL;
+    fControlTimer = NULL;
+    if (!fControlPath.empty())
+    {
+	fControl = new ControlServer(fControlPath.c_str(), 
+	    [this](const std::vector<std::string> &args, std::string &reply)
+	    {return ControlCommand(args, reply);});
+	fControlTimer = new TTimer();
+	fControlTimer->Connect("Timeout()", "IVCurve", this, 
+			       "ControlProc()");
+	fControlTimer->Start(100, kFALSE);
+    }
+    fProfiles = NULL;
+    if (!fProfileFile.empty())
+    {
+	fProfiles = new ProfileStore(fProfileFile.c_str());
+	fProfiles->Temperature(fTemperature);
+    }
+
     SET_DEBUG_STACK;
 }
 /**
@@ -279,8 +410,66 @@ void IVCurve::CleanUp(void)
     fInstruments = 0;
     delete fGraph;
     fGraph = 0;
+    delete fGraphDown;
+    fGraphDown = 0;
     delete fComment;
     fComment = 0;
+    delete fDisplay;
+    fDisplay = 0;
+    delete fPyramid;
+    fPyramid = 0;
+    delete fLODGraph;
+    fLODGraph = 0;
+    delete fPyramidDown;
+    fPyramidDown = 0;
+    delete fLODDown;
+    fLODDown = 0;
+    if (fOverlay)
+    {
+	// The graphs belong to the run cache.
+	if (fOverlay->GetListOfGraphs())
+	    fOverlay->GetListOfGraphs()->Clear("nodelete");
+	delete fOverlay;
+	fOverlay = 0;
+    }
+    delete fLegend;
+    fLegend = 0;
+    delete fRuns;
+    fRuns = 0;
+    delete fDiodeFit;
+    fDiodeFit = 0;
+    delete fOnline;
+    fOnline = 0;
+    delete fRegions;
+    fRegions = 0;
+    delete fBootstrap;
+    fBootstrap = 0;
+    delete fDerived;
+    fDerived = 0;
+    delete fGdIdV;
+    fGdIdV = 0;
+    delete fGRdyn;
+    fGRdyn = 0;
+    delete fGLogI;
+    fGLogI = 0;
+    delete fGolden;
+    fGolden = 0;
+    delete fStore;
+    fStore = 0;
+    delete fQueue;
+    fQueue = 0;
+    delete fUntuned;
+    fUntuned = 0;
+    delete fUserSettings;
+    fUserSettings = 0;
+    delete fControlTimer;
+    fControlTimer = 0;
+    delete fControl;
+    fControl = 0;
+    delete fProfiles;
+    fProfiles = 0;
+    delete fPool;
+    fPool = 0;
 
     SET_DEBUG_STACK;
 }
@@ -329,6 +518,31 @@ void IVCurve::AddEmbeddedCanvas(UInt_t w, UInt_t h)
     fGraphicsFrame->AddFrame( fEmbeddedCanvas, 
 			      new TGLayoutHints(kLHintsExpandX |
 						kLHintsExpandY, 2, 2, 2, 0));
+    /*
+     * Derived channels get their own canvas to the right so that
+     * the main plot keeps the whole of ec1. Three pads, one above
+     * the other, dI/dV, dynamic resistance and log10|I|.
+     */
+    fDerivedCanvas = NULL;
+    if (fShowDerived)
+    {
+	fDerivedCanvas = new TRootEmbeddedCanvas("ec2", fGraphicsFrame, 
+						 w/3, h);
+	fGraphicsFrame->AddFrame( fDerivedCanvas, 
+				  new TGLayoutHints(kLHintsExpandY, 
+						    2, 2, 2, 0));
+	TCanvas *c2 = fDerivedCanvas->GetCanvas();
+	c2->SetBorderMode(0);
+	c2->SetFillColor(0);
+	c2->Divide(1,3);
+	for (Int_t i=1; i<=3; i++)
+	{
+	    c2->cd(i);
+	    gPad->SetGrid();
+	}
+	c2->cd(2);
+	gPad->SetLogy();
+    }
     this->AddFrame( fGraphicsFrame, 
 		    new TGLayoutHints(kLHintsExpandX |
 				      kLHintsExpandY, 2, 2, 2, 0));
@@ -421,7 +635,7 @@ void IVCurve::AddStatusPane(void)
 void IVCurve::CreateMenuBar()
 {
     SET_DEBUG_STACK;
-    TGPopupMenu *MenuFile, *MenuHelp, *MenuEdit;
+    TGPopupMenu *MenuFile, *MenuHelp, *MenuEdit, *MenuView;
 
     // Layout menu here. 
     // Create menubar and popup menus. The hint objects are used to place
@@ -450,6 +664,12 @@ void IVCurve::CreateMenuBar()
 
     MenuEdit->AddEntry("P&arameters"  , M_EDIT_PARAMETERS);
 
+    // View menu -------------------------------------------
+    MenuView = new TGPopupMenu(gClient->GetRoot());
+    MenuView->AddEntry("&Overlay Runs...", M_VIEW_OVERLAY);
+    MenuView->AddEntry("Select &Runs...",  M_VIEW_RUNS);
+    MenuView->AddEntry("&Single Run",      M_VIEW_SINGLE);
+
     // Instrument Menu ------------------------------------
     
     fMenuInstrument = new TGPopupMenu(gClient->GetRoot());
@@ -457,6 +677,10 @@ void IVCurve::CreateMenuBar()
     fMenuInstrument->AddEntry("Keithley 230", M_INST_K230);
     fMenuInstrument->AddSeparator();
     fMenuInstrument->AddEntry("Fit",          M_INST_FIT);
+    fMenuInstrument->AddEntry("Fit Errors",   M_INST_BOOTSTRAP);
+    fMenuInstrument->AddEntry("Set Reference",     M_INST_REFERENCE);
+    fMenuInstrument->AddEntry("Compare Reference", M_INST_COMPARE);
+    fMenuInstrument->AddEntry("Run Queue...",      M_INST_QUEUE);
     fMenuInstrument->AddEntry("Comment",      M_INST_COMMENT);
 
     // Help menu -------------------------------------------
@@ -475,6 +699,10 @@ void IVCurve::CreateMenuBar()
 		       TGLayoutHints(kLHintsTop | kLHintsLeft, 
 				     0, 4, 0, 0));
 
+    MenuBar->AddPopup("&View", MenuView, new 
+		       TGLayoutHints(kLHintsTop | kLHintsLeft, 
+				     0, 4, 0, 0));
+
     MenuBar->AddPopup("&Instruments", fMenuInstrument, new 
 		       TGLayoutHints(kLHintsTop | kLHintsLeft, 
 				     0, 4, 0, 0));
@@ -490,6 +718,9 @@ void IVCurve::CreateMenuBar()
     MenuEdit->Connect("Activated(Int_t)", "IVCurve", this,
 		       "HandleMenu(Int_t)");
 
+    MenuView->Connect("Activated(Int_t)", "IVCurve", this,
+		       "HandleMenu(Int_t)");
+
     fMenuInstrument->Connect("Activated(Int_t)", "IVCurve", this,
 			    "HandleMenu(Int_t)");
 
@@ -588,7 +819,12 @@ void IVCurve::HandleToolBar(Int_t id)
     case M_START:
 	tb = fToolBar->GetButton(M_START);
         tb->SetState(kButtonUp);
-	fTimer->Start(500, kFALSE);
+	fTimer->Start(fInstruments->Backend()->Virtual() ? kVirtualTickMS :
+		      kSweepTickMS, kFALSE);
+	if (fAutoTune && (fMode == 3))
+	{
+	    TuneFromProfile();
+	}
 	fInstruments->Reset();
 	switch(fMode)
 	{
@@ -598,6 +834,7 @@ void IVCurve::HandleToolBar(Int_t id)
 	case 1:
 	case 2:
             // set to measure Voltage
+	    fInstruments->SenseResistance((fMode == 2) ? fResistor : 0.0);
 	    fInstruments->Setup(kFALSE);  
 	    break;
 	case 3:  // Current
@@ -605,14 +842,43 @@ void IVCurve::HandleToolBar(Int_t id)
 	    fInstruments->Setup(kTRUE);  
 	    break;
 	}
+	// Room for the whole sweep before the first point.
+	fStore->Reserve(fInstruments->PlanPoints());
+	fStore->DriftCorrection(fInstruments->DriftCorrect());
+	fViewScale = (fMode == 2) ? 1.0/fResistor : 1.0;
 	CreateGraphObjects();
+	fGraph->Expand(fInstruments->PlanPoints());
+	fGraphDown->Set(0);
+	fOnline->Temperature(fTemperature);
+	fOnline->RefineEvery(fOnlineRefine);
+	fOnline->Reset();
+	fOnlineStable = kFALSE;
+	fDerived->Reset();
+	fNDerivedPlotted = 0;
+	fNLogIPlotted    = 0;
 	fTakeData = kTRUE;
+	fDisplay->Reset();
+	fDisplayTimer->Start(fDisplay->IntervalMS(), kFALSE);
+	if (fControl) fControl->Event("start");
 	break;
     case M_STOP:
 	tb = fToolBar->GetButton(M_STOP);
         tb->SetState(kButtonUp);
 	fTakeData = kFALSE;
 	fTimer->Stop();
+	fDisplayTimer->Stop();
+	fDerived->End();
+	PlotMe(0);
+	if (fControl) fControl->Event("stopped");
+	Restore(fUntuned);
+	if (fQueueRunning)
+	{
+	    // Not advanced, loading the queue again redoes this sweep.
+	    fQueueRunning = kFALSE;
+	    Restore(fUserSettings);
+	    CLogger::GetThis()->Log("# IVCurve: queue stopped at %d of %d.\n",
+				    (int) fQueue->Next()+1, (int) fQueue->N());
+	}
 	break;
     case M_ZOOM_PLUS:
 	Zoom();
@@ -717,6 +983,27 @@ void IVCurve::HandleMenu(Int_t id)
     case M_INST_FIT:
 	FitData();
 	break;
+    case M_INST_BOOTSTRAP:
+	FitErrors();
+	break;
+    case M_INST_REFERENCE:
+	SetReference();
+	break;
+    case M_INST_COMPARE:
+	CheckReference();
+	break;
+    case M_INST_QUEUE:
+	RunQueue();
+	break;
+    case M_VIEW_OVERLAY:
+	OverlayDialog();
+	break;
+    case M_VIEW_RUNS:
+	SelectRuns();
+	break;
+    case M_VIEW_SINGLE:
+	if (fGraph) PlotMe(0);
+	break;
     case M_INST_COMMENT:
     {
 	TString temp;
@@ -878,9 +1165,9 @@ void IVCurve::FileDialog(bool LoadOrSave)
 	{
 	    Load(fi.fFilename);
 	}
-	else
+	else if (!Save(fi.fFilename))
 	{
-	    Save(fi.fFilename);
+	    fStatusBar->SetText(Form("Can not save %s", fi.fFilename), 0);
 	}
     }
 
@@ -892,7 +1179,10 @@ void IVCurve::FileDialog(bool LoadOrSave)
  *
  * Function Name : PlotMe
  *
- * Description : Setup the actual plot
+ * Description : Setup the actual plot. This is the full redraw, 
+ *               the pad is cleared, a frame is drawn that covers 
+ *               the data and the graph is drawn on top of it. 
+ *               Live data uses PlotAppend instead. 
  *
  * Inputs : Index - not used
  *
@@ -910,16 +1200,103 @@ void IVCurve::FileDialog(bool LoadOrSave)
 void IVCurve::PlotMe(Int_t Index)
 {
     SET_DEBUG_STACK;
+    Int_t    N = fGraph->GetN();
+    Int_t    ND = fGraphDown->GetN();
+    Double_t dx, dy;
 
     gPad->Clear();
+    fFrame       = NULL;
+    fNPlotted    = 0;
+    fNDownPlotted = 0;
+    fLODActive   = kFALSE;
+    fOverlayMode = kFALSE;
+    // The graph may have been replaced, start the pyramid over.
+    fPyramid->Clear();
+    fPyramidDown->Clear();
+    if (N<=0)
+    {
+	gPad->Update();
+	return;
+    }
+
+    fXlo = TMath::MinElement(N, fGraph->GetX());
+    fXhi = TMath::MaxElement(N, fGraph->GetX());
+    fYlo = TMath::MinElement(N, fGraph->GetY());
+    fYhi = TMath::MaxElement(N, fGraph->GetY());
+    if (ND > 0)
+    {
+	// The return branch can run past the up branch.
+	fXlo = TMath::Min(fXlo, TMath::MinElement(ND, fGraphDown->GetX()));
+	fXhi = TMath::Max(fXhi, TMath::MaxElement(ND, fGraphDown->GetX()));
+	fYlo = TMath::Min(fYlo, TMath::MinElement(ND, fGraphDown->GetY()));
+	fYhi = TMath::Max(fYhi, TMath::MaxElement(ND, fGraphDown->GetY()));
+    }
+    // Leave a little room around the data, and something to 
+    // look at if there is only one point. 
+    dx = 0.05*(fXhi-fXlo);
+    dy = 0.05*(fYhi-fYlo);
+    if (dx<=0.0) dx = 0.05*fabs(fXlo) + 1.0e-3;
+    if (dy<=0.0) dy = 0.05*fabs(fYlo) + 1.0e-9;
+    fXlo -= dx; fXhi += dx;
+    fYlo -= dy; fYhi += dy;
+
+    fFrame = gPad->DrawFrame(fXlo, fYlo, fXhi, fYhi);
+    SetAxisTitles(fFrame);
+
     fGraph->SetMarkerSize(0.75);
     fGraph->SetMarkerStyle(kPlus);
-    fGraph->Draw("ACP");
+    if (N > kLODPointsPerPixel*(Int_t)gPad->GetWw())
+    {
+	// Far more points than pixels, draw the envelope. 
+	fLODActive = kTRUE;
+	fLODGraph->SetLineColor(fGraph->GetLineColor());
+	fLODGraph->Draw("L");
+	if (ND > 0) fLODDown->Draw("L");
+	RefineLOD();
+    }
+    else
+    {
+	fGraph->Draw("CP");
+	if (fGraphDown->GetN() > 0)
+	{
+	    fGraphDown->SetMarkerSize(0.75);
+	    fGraphDown->SetMarkerStyle(kCircle);
+	    fGraphDown->Draw("CP");
+	}
+    }
+    fNPlotted     = N;
+    fNDownPlotted = fGraphDown->GetN();
 
+    gPad->Update();
+    PlotDerived();
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SetAxisTitles
+ *
+ * Description : Label the axes according to the mode we are 
+ *               running in. 
+ *
+ * Inputs : h - histogram that owns the axes. 
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::SetAxisTitles(TH1 *f)
+{
+    SET_DEBUG_STACK;
     // SetTitle(char) FIXME - Add in a dialog to get info on what is under test
     //
-    TH1 *f = fGraph->GetHistogram();
-
     switch(fMode)
     {
     case 0:
@@ -938,8 +1315,295 @@ void IVCurve::PlotMe(Int_t Index)
     }
     f->SetLabelSize(0.03, "X");
     f->SetLabelSize(0.03, "Y");
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ExtendFrame
+ *
+ * Description : Check the points not yet painted, of both branches,
+ *               against the current frame. If any fall outside, grow
+ *               the frame
+ *               limits. The growth is geometric, half again the 
+ *               current span beyond the new point, such that a 
+ *               sweep of N points only rescales of order log(N)
+ *               times. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if the frame limits changed. 
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::ExtendFrame(void)
+{
+    SET_DEBUG_STACK;
+    Int_t     N  = fGraph->GetN();
+    Double_t *x  = fGraph->GetX();
+    Double_t *y  = fGraph->GetY();
+    Double_t  sx = 0.5*(fXhi-fXlo);
+    Double_t  sy = 0.5*(fYhi-fYlo);
+    bool      rc = false;
+
+    for (Int_t i=fNPlotted; i<N; i++)
+    {
+	if (x[i]<fXlo) { fXlo = x[i] - sx; rc = true;}
+	if (x[i]>fXhi) { fXhi = x[i] + sx; rc = true;}
+	if (y[i]<fYlo) { fYlo = y[i] - sy; rc = true;}
+	if (y[i]>fYhi) { fYhi = y[i] + sy; rc = true;}
+    }
+    N = fGraphDown->GetN();
+    x = fGraphDown->GetX();
+    y = fGraphDown->GetY();
+    for (Int_t i=fNDownPlotted; i<N; i++)
+    {
+	if (x[i]<fXlo) { fXlo = x[i] - sx; rc = true;}
+	if (x[i]>fXhi) { fXhi = x[i] + sx; rc = true;}
+	if (y[i]<fYlo) { fYlo = y[i] - sy; rc = true;}
+	if (y[i]>fYhi) { fYhi = y[i] + sy; rc = true;}
+    }
+    if (rc)
+    {
+	fFrame->GetXaxis()->SetLimits(fXlo, fXhi);
+	fFrame->SetMinimum(fYlo);
+	fFrame->SetMaximum(fYhi);
+    }
+    SET_DEBUG_STACK;
+    return rc;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : RefineLOD
+ *
+ * Description : Recompute the envelope drawn for large data sets
+ *               for the x range currently shown on the frame. This
+ *               is called whenever the range changes, zoom, unzoom
+ *               the rubber band or new data. In the overlay each 
+ *               visible run is done instead. The work done is of 
+ *               order the number of pixel columns, not the number
+ *               of points. The return branch runs back down in x, 
+ *               so its envelope is clipped point by point, of order
+ *               its number of points.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::RefineLOD(void)
+{
+    SET_DEBUG_STACK;
+    TAxis    *a;
+    Double_t lo, hi;
+    Int_t    pixels;
+    UInt_t   n;
 
-    gPad->Update();
+    if ((!fLODActive && !fOverlayMode) || (fFrame == NULL))
+    {
+	return;
+    }
+    a      = fFrame->GetXaxis();
+    lo     = a->GetBinLowEdge(a->GetFirst());
+    hi     = a->GetBinUpEdge(a->GetLast());
+    pixels = TMath::Abs(gPad->XtoAbsPixel(hi) - gPad->XtoAbsPixel(lo));
+    if (pixels < 16) pixels = 16;
+
+    if (fOverlayMode)
+    {
+	// Each run on show from its own pyramid, as for the sweep.
+	for (size_t i=0; i<fRuns->N(); i++)
+	{
+	    if (fRuns->Visible(i)) fRuns->Refine(i, lo, hi, pixels);
+	}
+	return;
+    }
+
+    fPyramid->Update(fGraph->GetX(), fGraph->GetY(), fGraph->GetN());
+    fLODGraph->Set(MinMaxPyramid::MaxOut(pixels));
+    n = fPyramid->Envelope(fGraph->GetX(), fGraph->GetY(), lo, hi, pixels,
+			   fLODGraph->GetX(), fLODGraph->GetY());
+    fLODGraph->Set(n);
+    if (fGraphDown->GetN() > 0)
+    {
+	fPyramidDown->Update(fGraphDown->GetX(), fGraphDown->GetY(), 
+			     fGraphDown->GetN());
+	fLODDown->Set(MinMaxPyramid::MaxOut(pixels));
+	n = fPyramidDown->Envelope(fGraphDown->GetX(), fGraphDown->GetY(),
+				   lo, hi, pixels,
+				   fLODDown->GetX(), fLODDown->GetY());
+	fLODDown->Set(n);
+    }
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PlotAppend
+ *
+ * Description : Incremental version of PlotMe for live data. 
+ *               The frame and axes are drawn once. Points added 
+ *               to fGraph since the last call are painted directly
+ *               onto the pad as a line and marker segment and the 
+ *               pad is marked modified so that any later repaint
+ *               (expose, resize, zoom) draws the whole graph. 
+ *               Only when a point falls outside the frame is the
+ *               pad fully updated. The cost per point is then 
+ *               independent of the number of points in the sweep. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::PlotAppend(void)
+{
+    SET_DEBUG_STACK;
+    Int_t    N = fGraph->GetN();
+    Int_t    first;
+    TCanvas *c1;
+
+    if (fFrame == NULL)
+    {
+	// Nothing drawn yet this sweep, draw the whole thing.
+	PlotMe(0);
+	return;
+    }
+    if (N <= fNPlotted)
+    {
+	return;
+    }
+
+    c1 = fEmbeddedCanvas->GetCanvas();
+    c1->cd();
+    if (!fLODActive && (N > kLODPointsPerPixel*(Int_t)gPad->GetWw()))
+    {
+	// Crossed into envelope drawing. 
+	PlotMe(0);
+	return;
+    }
+    if (fLODActive)
+    {
+	/*
+	 * The envelope is of order the pad width in points so 
+	 * a full repaint is still a fixed cost per frame. 
+	 */
+	ExtendFrame();
+	RefineLOD();
+	gPad->Modified();
+	gPad->Update();
+    }
+    else if (ExtendFrame())
+    {
+	// The axes moved, everything has to be repainted. 
+	gPad->Modified();
+	gPad->Update();
+    }
+    else
+    {
+	/*
+	 * Start the segment on the last painted point so that 
+	 * the line is continuous. 
+	 */
+	first = (fNPlotted>0) ? fNPlotted-1 : 0;
+	fGraph->TAttLine::Modify();
+	gPad->PaintPolyLine(N-first, fGraph->GetX()+first, 
+			    fGraph->GetY()+first);
+	fGraph->TAttMarker::Modify();
+	gPad->PaintPolyMarker(N-fNPlotted, fGraph->GetX()+fNPlotted,
+			      fGraph->GetY()+fNPlotted);
+	gPad->Modified();
+	c1->Flush();
+    }
+    fNPlotted = N;
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PlotReturn
+ *
+ * Description : Live drawing of the return branch of a bidirectional
+ *               sweep, painted onto the pad the same way PlotAppend
+ *               does the up branch. The first down point redraws
+ *               the pad so the graph joins the pad's list. When the
+ *               up branch is drawn as an envelope so is this, from
+ *               its own pyramid.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::PlotReturn(void)
+{
+    SET_DEBUG_STACK;
+    Int_t    N = fGraphDown->GetN();
+    Int_t    first;
+    TCanvas *c1;
+
+    if (N <= fNDownPlotted)
+    {
+	return;
+    }
+    if ((fFrame == NULL) || (fNDownPlotted == 0))
+    {
+	PlotMe(0);
+	return;
+    }
+    c1 = fEmbeddedCanvas->GetCanvas();
+    c1->cd();
+    if (fLODActive || ExtendFrame())
+    {
+	// Envelope or new axes, either way a full repaint.
+	RefineLOD();
+	gPad->Modified();
+	gPad->Update();
+	fNDownPlotted = N;
+	return;
+    }
+    first = fNDownPlotted-1;
+    fGraphDown->TAttLine::Modify();
+    gPad->PaintPolyLine(N-first, fGraphDown->GetX()+first, 
+			fGraphDown->GetY()+first);
+    fGraphDown->TAttMarker::Modify();
+    gPad->PaintPolyMarker(N-fNDownPlotted, fGraphDown->GetX()+fNDownPlotted,
+			  fGraphDown->GetY()+fNDownPlotted);
+    gPad->Modified();
+    c1->Flush();
+    fNDownPlotted = N;
     SET_DEBUG_STACK;
 }
 
@@ -973,6 +1637,13 @@ void IVCurve::CloseWindow(void)
         delete fTimer;
         fTimer = 0;
     }
+    if (fDisplayTimer)
+    {
+        fDisplayTimer->Stop();
+        fDisplayTimer->Disconnect("Timeout()");
+        delete fDisplayTimer;
+        fDisplayTimer = 0;
+    }
     // Got close message for this MainFrame. Terminates the application.
     CleanUp();
     gApplication->Terminate(0);
@@ -1059,6 +1730,15 @@ void IVCurve::ProcessedEvent(Int_t event, Int_t px, Int_t py,
 #endif
 	switch (PlotState)
 	{
+	case PLOT_STATE_NORMAL:
+	    // The axes may have been dragged, pick up the new range.
+	    if (fLODActive || fOverlayMode)
+	    {
+		RefineLOD();
+		gPad->Modified();
+		gPad->Update();
+	    }
+	    break;
 	case PLOT_STATE_ZOOM:
             gPad->GetCanvas()->FeedbackMode(kFALSE);
             if (px == px0) return;
@@ -1078,12 +1758,13 @@ void IVCurve::ProcessedEvent(Int_t event, Int_t px, Int_t py,
                 y0   = y1;
                 y1   = temp;
             }
-	    TH1 *h = fGraph->GetHistogram();
+	    TH1 *h = fFrame;
 	    if (h)
 	    {
 		h->GetXaxis()->SetRangeUser(x0,x1);
 		h->GetYaxis()->SetRangeUser(y0,y1);
 	    }
+	    RefineLOD();
             gPad->Modified();
             gPad->Update();
 	    PlotState = PLOT_STATE_NORMAL;
@@ -1124,12 +1805,14 @@ void IVCurve::ProcessedEvent(Int_t event, Int_t px, Int_t py,
 void IVCurve::UnZoom(void)
 {
     SET_DEBUG_STACK;
-    TH1 *h = fGraph->GetHistogram();
+    TH1 *h = fFrame;
     if (h)
     {
 	cout << "Got Histogram " << endl;
 	h->GetXaxis()->UnZoom();
 	h->GetYaxis()->UnZoom();
+	RefineLOD();
+	gPad->Modified();
     }
     gPad->Update();
     SET_DEBUG_STACK;
@@ -1206,7 +1889,7 @@ void IVCurve::ZoomAxis(TAxis *a)
 void IVCurve::Zoom(void)
 {
     SET_DEBUG_STACK;
-    TH1 *h = fGraph->GetHistogram();
+    TH1 *h = fFrame;
     TAxis *ax;
     if (h)
     {
@@ -1216,6 +1899,8 @@ void IVCurve::Zoom(void)
 	ax = h->GetYaxis();
 	ZoomAxis(ax);
 	fZoomLevel *= 2.0;
+	RefineLOD();
+	gPad->Modified();
     }
     gPad->Update();
     SET_DEBUG_STACK;
@@ -1225,13 +1910,15 @@ void IVCurve::Zoom(void)
  *
  * Function Name : Load
  *
- * Description : Load a previously generated file. 
+ * Description : Load a previously generated file. The points go
+ *               into the sample store, x as it is in the file, and
+ *               the graph is made from the store. 
  *
  * Inputs : filename to load
  *
- * Returns :
+ * Returns : true on success
  *
- * Error Conditions :
+ * Error Conditions : file could not be read
  * 
  * Unit Tested on: 
  *
@@ -1243,74 +1930,260 @@ void IVCurve::Zoom(void)
 bool IVCurve::Load(const char *file)
 {
     SET_DEBUG_STACK;
+    std::vector<double> x, y;
 
-
-    if (strstr(file, "root") != NULL)
-    {
-	CleanGraphObjects();
-	// Open a file for save, use the root file protocol. 
-	TFile myin(file, "READ");
-	fGraph = (TGraph *)myin.Get("IVCurve");
-	myin.Close();
-    }
-    else if(strstr(file, "csv") != NULL)
+    // root, csv, tsv and txt, same as before.
+    if (!SweepFile::Read(file, x, y))
     {
-	delete fGraph;
-	fGraph = new TGraph(file, "%lg,%lg");
-        // Named -- This appears to be used as the TKey. 
-	fGraph->SetName("IVCurve");  
+	fStatusBar->SetText(Form("Can not load %s", file), 0);
+	return false;
     }
-    else if((strstr(file, "tsv") != NULL) ||
-	    (strstr(file, "txt") != NULL))
+    fStore->Reserve(x.size());
+    for (size_t i=0; i<x.size(); i++)
     {
-	// In this case delete and recreate the load. 
-	delete fGraph;
-	fGraph = new TGraph(file); 
-	fGraph->SetName("IVCurve");
+	fStore->Add(x[i], y[i], 0.0, 1, 0.0, 0.0, SampleStore::kCoarse);
     }
+    fViewScale = 1.0;
+    CreateGraphObjects();
+    fGraphDown->Set(0);
+    fStore->View(fGraph, fViewScale);
+    // Derived channels are worked out again from the new graph.
+    fDerived->Reset();
+    fNDerivedPlotted = 0;
+    fNLogIPlotted    = 0;
     PlotMe(0);
-    // Someday add in the ability to insert multiple files.
+    // Multiple files are loaded with OverlayDialog.
     SET_DEBUG_STACK;
     return true;
 }
 /**
  ******************************************************************
  *
- * Function Name : Save
+ * Function Name : OverlayDialog
  *
- * Description : Save data to file
+ * Description : Bring up a file dialog that allows many runs to be
+ *               selected at once. An archive is opened up into the
+ *               runs it holds. Each run is added to the run cache,
+ *               runs already there are not read again, and the 
+ *               overlay is drawn. 
  *
- * Inputs : filename to save
+ * Inputs : NONE
  *
- * Returns : true on success. 
+ * Returns : NONE
  *
- * Error Conditions : file open failed
+ * Error Conditions : NONE
  * 
- * Unit Tested on: 25-Jul-23
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool IVCurve::Save(const char *file)
+void IVCurve::OverlayDialog(void)
 {
     SET_DEBUG_STACK;
+    TGFileInfo fi;
+    TObject    *obj;
+    Int_t      count = 0;
+    std::vector<std::string> runs;
 
-    // Look at the suffix and determine how we want to store. 
-    if (strstr(file, "root") != NULL)
-    {
-	// Open a file for save, use the root file protocol. 
+    fi.fFileTypes = filetypes;
+    fi.fIniDir    = StrDup(fLastDir->Data());
+    fi.SetMultipleSelection(kTRUE);
+
+    new TGFileDialog( gClient->GetRoot(), 0, kFDOpen, &fi);
+
+    if (fi.fFilename == NULL)
+    {
+	return;
+    }
+    delete fLastDir;
+    fLastDir = new TString(fi.fIniDir);
+
+    if (fi.fFileNamesList && (fi.fFileNamesList->GetSize()>0))
+    {
+	TIter next(fi.fFileNamesList);
+	while ((obj = next()))
+	{
+	    SweepFile::List(((TObjString *)obj)->GetString().Data(), runs);
+	}
+    }
+    else
+    {
+	SweepFile::List(fi.fFilename, runs);
+    }
+    for (size_t i=0; i<runs.size(); i++)
+    {
+	if (fRuns->Add(runs[i].c_str())>=0)
+	    count++;
+    }
+    if (count>0)
+    {
+	PlotOverlay();
+    }
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SelectRuns
+ *
+ * Description : Turn cached runs on and off and redraw the overlay.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::SelectRuns(void)
+{
+    SET_DEBUG_STACK;
+    Bool_t changed;
+
+    if (fRuns->N() == 0)
+    {
+	OverlayDialog();
+	return;
+    }
+    new OverlayDlg(this, fRuns, &changed);
+    if (changed)
+    {
+	PlotOverlay();
+    }
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PlotOverlay
+ *
+ * Description : Draw all visible cached runs with a legend. The 
+ *               graphs come from the cache and are only built the 
+ *               first time a run is shown. The multigraph is 
+ *               remade each time, but it must not delete the graphs
+ *               it is given. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::PlotOverlay(void)
+{
+    SET_DEBUG_STACK;
+    TGraph *g;
+
+    fEmbeddedCanvas->GetCanvas()->cd();
+    gPad->Clear();
+    fFrame      = NULL;
+    fNPlotted   = 0;
+    fLODActive  = kFALSE;
+
+    if (fOverlay)
+    {
+	if (fOverlay->GetListOfGraphs())
+	    fOverlay->GetListOfGraphs()->Clear("nodelete");
+	delete fOverlay;
+    }
+    delete fLegend;
+    fOverlay = new TMultiGraph();
+    fLegend  = new TLegend(0.80, 0.75, 0.95, 0.89);
+
+    for (size_t i=0; i<fRuns->N(); i++)
+    {
+	if (fRuns->Visible(i))
+	{
+	    g = fRuns->Graph(i);
+	    fOverlay->Add(g, "LP");
+	    fLegend->AddEntry(g, fRuns->Label(i), "lp");
+	}
+    }
+    fOverlayMode = kTRUE;
+    if (fRuns->NVisible() == 0)
+    {
+	gPad->Update();
+	return;
+    }
+    fOverlay->Draw("A");
+    fLegend->Draw();
+
+    // Zoom and friends work on the multigraph axes. 
+    fFrame = fOverlay->GetHistogram();
+    SetAxisTitles(fFrame);
+    gPad->Modified();
+    gPad->Update();
+    fStatusBar->SetText(Form("Overlay: %d of %d runs", 
+			     (int) fRuns->NVisible(), (int) fRuns->N()), 0);
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Save
+ *
+ * Description : Save data to file. The text formats carry the 
+ *               noise information from the sample store after x and
+ *               y: sigma, readings, settle time, time from the start
+ *               and step type. Readers only look at the first two
+ *               columns.
+ *
+ * Inputs : filename to save
+ *
+ * Returns : true on success. 
+ *
+ * Error Conditions : file open or write failed, a ROOT file that is
+ *                    already there, a suffix we do not know.
+ * 
+ * Unit Tested on: 25-Jul-23
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::Save(const char *file)
+{
+    SET_DEBUG_STACK;
+    bool ok = false;
+
+    // Look at the suffix and determine how we want to store. 
+    if (SweepFile::IsROOT(file))
+    {
+	// Open a file for save, use the root file protocol. 
 	TFile myout(file, "NEW", "IVCurve Data");
-	//myout.cd();
-	fGraph->Write();
+	if (myout.IsZombie())
+	{
+	    // NEW will not open a file that is already there.
+	    CLogger::GetThis()->Log("# IVCurve: can not create %s\n", file);
+	    return false;
+	}
+	myout.cd();
+	ok = (fGraph->Write() > 0);
+	if (fGraphDown->GetN() > 0) ok = ok && (fGraphDown->Write() > 0);
 	TNamed Named("Comment","NONE");
 
 	if (fComment)
 	{
 	    // Name the string we want to write, this gives it a key. 
 	    Named.SetTitle(fComment->Data());
-	    Named.Write(); 
+	    ok = ok && (Named.Write() > 0); 
 	}
 	myout.Close();
     }
@@ -1327,17 +2200,30 @@ bool IVCurve::Save(const char *file)
 		myout << "# " << *fComment << endl;
 	    Int_t N = fGraph->GetN();
 	    Double_t x, y;
-	    for(Int_t i=0;i<N;i++)
+	    if ((Int_t) fStore->NBranch(SampleStore::kUp) == N)
+	    {
+		// Both branches, in the order taken.
+		for(UInt_t i=0;i<fStore->N();i++) 
+		    fStore->Write(myout, i, fViewScale);
+	    }
+	    else
 	    {
-		fGraph->GetPoint( i, x, y);
-		myout << x << "," << y << endl;
+		for(Int_t i=0;i<N;i++)
+		{
+		    fGraph->GetPoint( i, x, y);
+		    myout << x << "," << y << endl;
+		}
 	    }
 	    myout.close();
+	    ok = !myout.fail();
 	}
     }
-
+    if (!ok)
+    {
+	CLogger::GetThis()->Log("# IVCurve: save to %s failed.\n", file);
+    }
     SET_DEBUG_STACK;
-    return kTRUE;
+    return ok;
 }
 /**
  ******************************************************************
@@ -1365,7 +2251,7 @@ bool IVCurve::CreateGraphObjects(void)
 //     ftmg         = new TMultiGraph();
 //     fLegend      = new TLegend(0.80, 0.75, 0.95, 0.89);
     CleanGraphObjects();
-    fGraph = new TGraph();
+    fGraph = new TGraphErrors();
     // TNamed - This appears to create the key in the TFile structure. 
     fGraph->SetName("IVCurve");
     SET_DEBUG_STACK;
@@ -1396,6 +2282,9 @@ bool IVCurve::CleanGraphObjects(void)
     SET_DEBUG_STACK;
     if (gPad)
 	gPad->Clear();
+    // The frame belongs to the pad and went with the Clear. 
+    fFrame    = NULL;
+    fNPlotted = 0;
     delete fGraph;
     fGraph = NULL;
 
@@ -1535,23 +2424,128 @@ void IVCurve::TimeoutProc(void)
 	    // Test code
 	    x = x + 1.0;
 	    y = pow(x,2.0);
-	    fGraph->AddPoint(x,y);
+	    fStore->Add(x, y, 0.0, 1, 0.0, fInstruments->Backend()->Now(), 
+			SampleStore::kCoarse);
+	    fStore->View(fGraph, fViewScale);
+	    PublishPoint();
+	    fDerived->Add(x,y);
 	    break;
 	default:
 	    // advance the voltage, take the measurement and plot it. 
 	    fInstruments->StepAndAcquire();
-	    x = fInstruments->Voltage();
-	    y = fInstruments->Result();
-	    if (fMode == 2)
+	    fStore->Add(fInstruments->Voltage(), fInstruments->Result(),
+			fInstruments->StdDev(), fInstruments->NSamples(),
+			fInstruments->SampleDelay(), fInstruments->TimeStamp(),
+			fInstruments->PointType(), fInstruments->Branch(),
+			fInstruments->PairIndex());
+	    fTakeData = !fInstruments->Done();
+	    PublishPoint();
+	    if (fInstruments->Branch() == SampleStore::kReference)
 	    {
-		x = x/fResistor;
+		// Not plotted, the drift it shows is applied to the rest.
+		fStatusBar->SetText(Form("Drift %.3g, %d references",
+					 fStore->ReferenceDrift(),
+					 (int) fInstruments->NReference()), 2);
+		break;
+	    }
+	    if (fInstruments->Branch() == SampleStore::kDown)
+	    {
+		fStore->View(fGraphDown, fViewScale, SampleStore::kDown);
+		fStatusBar->SetText(Form("Hysteresis %.3g, %d pairs",
+					 fStore->HysteresisArea(),
+					 (int) fStore->NPairs()), 2);
+		break;
+	    }
+	    // The fits and derived channels follow the up branch.
+	    fStore->View(fGraph, fViewScale, SampleStore::kUp);
+	    x = fViewScale*fInstruments->Voltage();
+	    y = fStore->Value(fStore->N()-1);
+	    fDerived->Add(x,y);
+	    if (fOnlineFit && (fMode == 3) && fOnline->Add(x,y))
+	    {
+		ShowOnlineFit();
 	    }
-	    fGraph->AddPoint(x,y);
-	    fTakeData = !fInstruments->Done();
 	    break;
 	}
 
-	PlotMe(0);
+	if (!fTakeData)
+	{
+	    // End of sweep, tidy up the axes around the data. 
+	    fTimer->Stop();
+	    fDisplayTimer->Stop();
+	    if ((fMode != 0) && (fStore->DriftCorrection() != 
+				 SampleStore::kNoCorrection))
+	    {
+		/*
+		 * The drift between references is known only now. The
+		 * graphs, and what was fed from them point by point, 
+		 * start again from the corrected values.
+		 */
+		fGraph->Set(0);
+		fStore->View(fGraph, fViewScale, SampleStore::kUp);
+		fGraphDown->Set(0);
+		fStore->View(fGraphDown, fViewScale, SampleStore::kDown);
+		fDerived->Reset();
+		fNDerivedPlotted = 0;
+		fNLogIPlotted    = 0;
+		for (Int_t i=0; i<fGraph->GetN(); i++)
+		{
+		    fDerived->Add(fGraph->GetX()[i], fGraph->GetY()[i]);
+		}
+		if (fOnlineFit && (fMode == 3))
+		{
+		    fOnline->Reset();
+		    for (Int_t i=0; i<fGraph->GetN(); i++)
+		    {
+			fOnline->Add(fGraph->GetX()[i], fGraph->GetY()[i]);
+		    }
+		    ShowOnlineFit();
+		}
+	    }
+	    fDerived->End();
+	    if ((fMode != 0) && !std::isnan(fInstruments->ComplianceVoltage()))
+	    {
+		fStatusBar->SetText(Form("Compliance from %.3f V", 
+				   fInstruments->ComplianceVoltage()), 0);
+	    }
+	    // The verdict goes up first, before the redraw.
+	    if (fGolden->HasReference())
+	    {
+		CheckReference();
+	    }
+	    if (fStore->NPairs() > 0)
+	    {
+		CLogger::GetThis()->Log("# IVCurve: hysteresis area %g over %d pairs, max %g at %g V\n",
+					fStore->HysteresisArea(),
+					(int) fStore->NPairs(),
+					fStore->MaxDeviation(),
+					fStore->VMaxDeviation());
+	    }
+	    if (fInstruments->NReference() > 1)
+	    {
+		CLogger::GetThis()->Log("# IVCurve: reference drifted %g over %d readings\n",
+					fStore->ReferenceDrift(),
+					(int) fInstruments->NReference());
+	    }
+	    for (uint32_t k=0; k<fDerived->NVf(); k++)
+	    {
+		CLogger::GetThis()->Log("# IVCurve: Vf(%g A) = %g V\n",
+					fDerived->VfTarget(k), 
+					fDerived->Vf(k));
+	    }
+	    PlotMe(0);
+	    if (fProfiles && (fMode == 3))
+	    {
+		LearnProfile();
+	    }
+	    // The tune was for this sweep only.
+	    Restore(fUntuned);
+	    if (fControl) fControl->Event("done");
+	    if (fQueueRunning)
+	    {
+		QueueSweepDone();
+	    }
+	}
     }
     //cout << "Timeout" << endl;
     SET_DEBUG_STACK;
@@ -1559,16 +2553,21 @@ void IVCurve::TimeoutProc(void)
 /**
  ******************************************************************
  *
- * Function Name : FitData
+ * Function Name : DisplayProc
  *
- * Description : Fit the diode equation to the current plot. 
+ * Description : Refresh the live plot. All points acquired since the
+ *               last frame are painted in one go. The scheduler 
+ *               times the frame, including the X round trip made 
+ *               by the canvas flush, and the timer is stretched if
+ *               the display can not keep up. Acquisition in 
+ *               TimeoutProc never waits on this. 
  *
- * Inputs : NONE
+ * Inputs :  NONE
  *
- * Returns :
+ * Returns : none
+ *
+ * Error Conditions : none
  *
- * Error Conditions :
- * 
  * Unit Tested on: 
  *
  * Unit Tested by: CBL
@@ -1576,41 +2575,53 @@ void IVCurve::TimeoutProc(void)
  *
  *******************************************************************
  */
-void IVCurve::FitData(void)
+void IVCurve::DisplayProc(void)
 {
     SET_DEBUG_STACK;
-    /*
-     * https://en.wikipedia.org/wiki/Diode_modelling
-     *
-     * https://root.cern.ch/doc/master/classTGraph.html#a61269bcd47a57296f0f1d57ceff8feeb
-     *
-     * FIXME, put the upper and lower limits in. 
-     * parameters dialog. 
-     */
-    PlotMe(0);
-    TAxis *a     = fGraph->GetXaxis();
-    Double_t min = a->GetXmin();
-    Double_t max = a->GetXmax();
-    fFitFunction->SetRange(min,max);
-    fGraph->Fit(fFitFunction,"V","", min, max);
-    fPlotNotes->DrawLatexNDC( 0.15, 0.85,
-			      "I(V) = I_{s}(e^{#frac{V}{K_{b} T}}-1.0)");
-    fFitFunction->Draw("SAME");
-    gPad->Update();
+    uint32_t interval;
+
+    if ((fGraph == NULL) || ((fGraph->GetN() <= fNPlotted) &&
+			     (fGraphDown->GetN() <= fNDownPlotted)))
+    {
+	// Nothing new to show. 
+	return;
+    }
+    if (!fDisplay->Due())
+    {
+	return;
+    }
+    interval = fDisplay->IntervalMS();
+    fDisplay->Begin();
+    PlotAppend();
+    PlotReturn();
+    PlotDerived();
+    fDisplay->End();
+    if (fDisplay->IntervalMS() != interval)
+    {
+	fDisplayTimer->SetTime(fDisplay->IntervalMS());
+    }
+    SET_DEBUG_STACK;
 }
 /**
  ******************************************************************
  *
- * Function Name : CreateFitFunction
+ * Function Name : PlotDerived
  *
- * Description :
- * https://root.cern.ch/doc/master/classTF1.html
- * 
- * Inputs :
+ * Description : Draw the derived channels in the pads beside the
+ *               main plot. During a sweep the pipeline is fed from
+ *               TimeoutProc. If the graph was loaded or replaced
+ *               the channels are worked out again from it. As with
+ *               the store only the points new since the last call
+ *               are added to the graphs, a derived point does not
+ *               change once it is known. This runs at the rate
+ *               DisplayScheduler allows, gPad is handed back to the
+ *               main canvas for the rest of the code.
  *
- * Returns :
+ * Inputs : NONE
  *
- * Error Conditions :
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
  * 
  * Unit Tested on: 
  *
@@ -1619,67 +2630,1205 @@ void IVCurve::FitData(void)
  *
  *******************************************************************
  */
-void IVCurve::CreateFitFunction(void)
+void IVCurve::PlotDerived(void)
 {
-    /*
-     * Thermal voltage 
-     */
-    Double_t IdealityFactor = 1.0; 
-    Double_t Temperature    = 293.15;
-    Double_t ThermalVoltage =  IdealityFactor * TMath::K() * Temperature/TMath::Qe();
-    fFitFunction = new TF1("Shockley", "[0]*(exp(x/[1])-1.0)",0.0, 1.0);
-    fFitFunction->SetParameter(0, 1.0e-3);
-    // Can we fix the thermal voltage? 
-    fFitFunction->SetParameter(1, ThermalVoltage);
-    fFitFunction->SetLineColor(2);
+    SET_DEBUG_STACK;
+    TVirtualPad *save = gPad;
+    TCanvas     *c2;
+    TString     title("log_{10}|I|");
+    Int_t       N, n, i, k;
 
-    //fPlotNotes = new TPaveLabel( 0.0, 140.0, 4.0, 180.0, 
-    fPlotNotes = new TLatex( );
+    if ((fDerivedCanvas == NULL) || (fGraph == NULL))
+    {
+	return;
+    }
+    N = fGraph->GetN();
+    if ((Int_t) fDerived->N() != N)
+    {
+	fDerived->Reset();
+	fNDerivedPlotted = 0;
+	fNLogIPlotted    = 0;
+	for (i=0; i<N; i++)
+	{
+	    fDerived->Add(fGraph->GetX()[i], fGraph->GetY()[i]);
+	}
+    }
+    if (!fTakeData)
+    {
+	fDerived->End();
+    }
+
+    const double *V = fDerived->V();
+    n = fDerived->NDerived();
+    if ((n < fNDerivedPlotted) || (N < fNLogIPlotted) ||
+	((fNDerivedPlotted == 0) && (fNLogIPlotted == 0)))
+    {
+	// The pipeline started again, so do the graphs.
+	fGdIdV->Set(0);
+	fGRdyn->Set(0);
+	fGLogI->Set(0);
+	fNDerivedPlotted = 0;
+	fNLogIPlotted    = 0;
+    }
+    for (i=fNDerivedPlotted; i<n; i++)
+    {
+	fGdIdV->SetPoint(fGdIdV->GetN(), V[i], fDerived->G()[i]);
+	// Only a positive resistance goes on the log axis.
+	if (fDerived->G()[i] > 0.0)
+	{
+	    fGRdyn->SetPoint(fGRdyn->GetN(), V[i], fDerived->Rdyn()[i]);
+	}
+    }
+    fNDerivedPlotted = n;
+    for (i=fNLogIPlotted; i<N; i++)
+    {
+	if (std::isfinite(fDerived->Log10I()[i]))
+	{
+	    fGLogI->SetPoint(fGLogI->GetN(), V[i], fDerived->Log10I()[i]);
+	}
+    }
+    fNLogIPlotted = N;
+    for (k=0; k<(Int_t)fDerived->NVf(); k++)
+    {
+	if (!std::isnan(fDerived->Vf(k)))
+	{
+	    title += Form("  V_{f}(%.3g A)=%.4f", fDerived->VfTarget(k),
+			  fDerived->Vf(k));
+	}
+    }
+    fGLogI->SetTitle(title + ";V;log_{10}|I|");
+
+    c2 = fDerivedCanvas->GetCanvas();
+    TGraph *g[3] = {fGdIdV, fGRdyn, fGLogI};
+    for (k=0; k<3; k++)
+    {
+	c2->cd(k+1);
+	if (g[k]->GetN() < 2)
+	{
+	    gPad->Clear();
+	}
+	else if (gPad->GetListOfPrimitives()->FindObject(g[k]) == NULL)
+	{
+	    // First time on the pad, after that a repaint will do.
+	    g[k]->Draw("AL");
+	}
+	gPad->Modified();
+    }
+    c2->Update();
+    if (save) save->cd();
+    SET_DEBUG_STACK;
 }
 /**
  ******************************************************************
  *
- * Function Name : ReadConfiguration
+ * Function Name : ReferenceFile
  *
- * Description : Open read the configuration file. 
+ * Description : Name of the golden curve for the part number, 
+ *               GoldenDir/PartNumber.root
  *
- * Inputs : none
+ * Inputs : NONE
  *
- * Returns : NONE
+ * Returns : file name, empty if there is no part number.
  *
  * Error Conditions : NONE
  * 
- * Unit Tested on:  
+ * Unit Tested on: 
  *
  * Unit Tested by: CBL
  *
  *
  *******************************************************************
  */
-bool IVCurve::ReadConfiguration(void)
+std::string IVCurve::ReferenceFile(void) const
 {
-    SET_DEBUG_STACK;
-    CLogger *log = CLogger::GetThis();
-
-    fEnv = new TEnv(".IVCurve");
-    log->Log("# IVCurve Loading prefs: %s \n", fEnv->GetRcName());
-
-    int32_t v = fEnv->GetValue("IVCurve.Verbose", 0);
-    log->SetVerbose(v);
-
-    uint8_t Voltmeter     = fEnv->GetValue("Voltmeter.GPIB", 3);
-    uint8_t VoltageSource = fEnv->GetValue("VoltageSource.GPIB", 14);
-    double Start          = fEnv->GetValue("VoltageSource.Start", -1.0);
-    double Stop           = fEnv->GetValue("VoltageSource.Stop",   1.0);
-    double Step           = fEnv->GetValue("VoltageSource.Step",   0.1);
-    double Fine           = fEnv->GetValue("VoltageSource.FineStep", 0.01);
-    double Window         = fEnv->GetValue("VoltageSource.Window",    0.1);
-    fResistor             = fEnv->GetValue("IVCurve.Resistance",   1000.0);
-    fMode                 = fEnv->GetValue("IVCurve.Mode",            0);
-    double MaxCurrent     = fEnv->GetValue("VoltageSource.MaxI",   4.0e-3);
-    int    NAVG           = fEnv->GetValue("IVCurve.Average",    1);
-    bool   FINEONLY       = fEnv->GetValue("IVCurve.FINE_ONLY",  1);
-
+    if (fPartNumber.empty())
+    {
+	return std::string();
+    }
+    return fGoldenDir + "/" + fPartNumber + ".root";
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LoadReference
+ *
+ * Description : Read the golden curve for the part number, if there
+ *               is one, and hand it to the comparison.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if a reference was loaded
+ *
+ * Error Conditions : no part number, no file
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::LoadReference(void)
+{
+    SET_DEBUG_STACK;
+    std::string         file = ReferenceFile();
+    std::vector<double> x, y;
+
+    if (file.empty() || gSystem->AccessPathName(file.c_str()))
+    {
+	return false;
+    }
+    if (!SweepFile::Read(file.c_str(), x, y) ||
+	!fGolden->Reference(&x[0], &y[0], x.size()))
+    {
+	CLogger::GetThis()->Log("# IVCurve: bad reference %s\n", 
+				file.c_str());
+	return false;
+    }
+    CLogger::GetThis()->Log("# IVCurve: reference %s, %d points.\n",
+			    file.c_str(), (int) x.size());
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SetReference
+ *
+ * Description : Store the current curve as the golden curve for 
+ *               the part number.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : no part number or no data
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::SetReference(void)
+{
+    SET_DEBUG_STACK;
+    std::string file = ReferenceFile();
+
+    if (file.empty())
+    {
+	fStatusBar->SetText("No part number, set IVCurve.PartNumber", 0);
+	return;
+    }
+    if ((fGraph == NULL) || (fGraph->GetN() < 2))
+    {
+	fStatusBar->SetText("No data for the reference.", 0);
+	return;
+    }
+    gSystem->mkdir(fGoldenDir.c_str(), kTRUE);
+    TFile myout(file.c_str(), "RECREATE", "IVCurve Reference");
+    fGraph->Write();
+    myout.Close();
+
+    if (LoadReference())
+    {
+	fStatusBar->SetText(Form("Reference for %s set.", 
+				 fPartNumber.c_str()), 0);
+    }
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CheckReference
+ *
+ * Description : Compare the current curve with the golden curve and
+ *               put the verdict in the status bar. Called the moment
+ *               the sweep is done.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : no reference
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::CheckReference(void)
+{
+    SET_DEBUG_STACK;
+    GoldenResult r;
+    double       t0, dt;
+
+    if ((fGraph == NULL) || !fGolden->HasReference())
+    {
+	fStatusBar->SetText("No reference for this part number.", 0);
+	return;
+    }
+    t0 = fInstruments->Backend()->Elapsed();
+    if (!fGolden->Compare(fGraph->GetX(), fGraph->GetY(), fGraph->GetN(), r))
+    {
+	fStatusBar->SetText("Reference check failed, too few points.", 0);
+	return;
+    }
+    dt = fInstruments->Backend()->Elapsed() - t0;
+
+    fStatusBar->SetText(
+	Form("%s %s: max %.2g A at %.3f V, rms %.2g A, %.2f of band",
+	     r.Pass ? "PASS" : "FAIL", fPartNumber.c_str(), r.MaxDev,
+	     r.VMaxDev, r.RMS, r.MaxRatio), 0);
+    CLogger::GetThis()->Log("# IVCurve: %s %s, %d of %d grid points out of band (%d covered), max %g A at %g V, rms %g A, %g of band, %.1f us\n",
+			    r.Pass ? "PASS" : "FAIL", fPartNumber.c_str(),
+			    (int) r.NFail, (int) r.NGrid, (int) r.NCovered,
+			    r.MaxDev, r.VMaxDev, r.RMS, r.MaxRatio, 1.0e6*dt);
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : RunQueue
+ *
+ * Description : Pick a queue file and run it unattended. The 
+ *               recipes are read on top of the present settings. If
+ *               the queue was stopped before it picks up from its
+ *               checkpoint.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : bad queue file
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::RunQueue(void)
+{
+    SET_DEBUG_STACK;
+    TGFileInfo fi;
+    Recipe     base;
+
+    if (fTakeData)
+    {
+	fStatusBar->SetText("Stop the sweep first.", 0);
+	return;
+    }
+    fi.fFileTypes = QueueTypes;
+    fi.fIniDir    = StrDup(fLastDir->Data());
+    new TGFileDialog( gClient->GetRoot(), 0, kFDOpen, &fi);
+    if (fi.fFilename == NULL)
+    {
+	return;
+    }
+    delete fLastDir;
+    fLastDir = new TString(fi.fIniDir);
+
+    base.From(fInstruments);
+    base.Mode       = fMode;
+    base.Resistance = fResistor;
+    if (!fQueue->Load(fi.fFilename, base) || fQueue->Finished())
+    {
+	fStatusBar->SetText(Form("Nothing to run in %s", fi.fFilename), 0);
+	return;
+    }
+    // Put back when the queue is done or stopped.
+    delete fUserSettings;
+    fUserSettings = new Recipe();
+    Snapshot(*fUserSettings);
+    fQueueRunning = kTRUE;
+    StartQueued();
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : StartQueued
+ *
+ * Description : Set up the next recipe in the queue and start it,
+ *               the same as pressing Run. The instruments stay open
+ *               from sweep to sweep.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::StartQueued(void)
+{
+    SET_DEBUG_STACK;
+    const Recipe &r = fQueue->Current();
+
+    r.Apply(fInstruments);
+    fMode     = r.Mode;
+    fResistor = r.Resistance;
+    if (!r.Part.empty())
+    {
+	fPartNumber = r.Part;
+    }
+    if (!r.Comment.empty())
+    {
+	delete fComment;
+	fComment = new TString(r.Comment.c_str());
+    }
+    fStatusBar->SetText(Form("Queue %d of %d: %s", (int) fQueue->Next()+1,
+			     (int) fQueue->N(), r.Output.c_str()), 0);
+    HandleToolBar(M_START);
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : QueueSweepDone
+ *
+ * Description : A queued sweep finished, save it, checkpoint and 
+ *               start the next.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::QueueSweepDone(void)
+{
+    SET_DEBUG_STACK;
+    bool ok = Save(fQueue->Current().Output.c_str());
+
+    fQueue->Advance(ok);
+    if (fQueue->Finished())
+    {
+	fQueueRunning = kFALSE;
+	Restore(fUserSettings);
+	fStatusBar->SetText(Form("Queue done, %d of %d failed.", 
+				 (int) fQueue->NFailed(), 
+				 (int) fQueue->N()), 0);
+	return;
+    }
+    StartQueued();
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ControlProc
+ *
+ * Description : Service the control socket, commands in and points
+ *               out. Runs on its own timer so subscribers get the
+ *               points that came in since the last call in one send.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::ControlProc(void)
+{
+    SET_DEBUG_STACK;
+    fControl->Poll();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ControlCommand
+ *
+ * Description : Commands from the control socket.
+ *
+ *               start                 same as Run
+ *               stop                  same as Stop
+ *               status                one line of JSON
+ *               set <key> <value>     change a recipe setting,
+ *                                     VoltageSource.Stop 0.8 say
+ *
+ * Inputs : args  - words of the command
+ *          reply - filled in
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : unknown command, bad setting, the sweep is in
+ *                    the wrong state for the command.
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::ControlCommand(const std::vector<std::string> &args, 
+			     std::string &reply)
+{
+    SET_DEBUG_STACK;
+    const std::string &cmd = args[0];
+    std::string       value;
+    Recipe            r;
+
+    if (cmd == "start")
+    {
+	if (fTakeData)
+	{
+	    reply = "sweep running";
+	    return false;
+	}
+	HandleToolBar(M_START);
+	reply = "started";
+    }
+    else if (cmd == "stop")
+    {
+	if (!fTakeData)
+	{
+	    reply = "not running";
+	    return false;
+	}
+	HandleToolBar(M_STOP);
+	reply = "stopped";
+    }
+    else if (cmd == "status")
+    {
+	reply = Form("{\"running\":%s,\"points\":%u,\"planned\":%u,"
+		     "\"mode\":%d,\"queue\":%s,\"next\":%u,\"of\":%u}",
+		     fTakeData ? "true" : "false", fStore->N(),
+		     fInstruments->PlanPoints(), (int) fMode,
+		     fQueueRunning ? "true" : "false",
+		     fQueue->Next(), fQueue->N());
+    }
+    else if (cmd == "set")
+    {
+	if (args.size() < 3)
+	{
+	    reply = "set <key> <value>";
+	    return false;
+	}
+	if (fTakeData)
+	{
+	    reply = "sweep running";
+	    return false;
+	}
+	for (size_t i=2; i<args.size(); i++)
+	{
+	    if (i > 2) value += " ";
+	    value += args[i];
+	}
+	r.From(fInstruments);
+	r.Mode       = fMode;
+	r.Resistance = fResistor;
+	r.Part       = fPartNumber;
+	if (!r.Set(args[1].c_str(), value.c_str()))
+	{
+	    reply = "bad setting " + args[1];
+	    return false;
+	}
+	r.Apply(fInstruments);
+	fMode     = r.Mode;
+	fResistor   = r.Resistance;
+	fPartNumber = r.Part;
+	if (!r.Comment.empty())
+	{
+	    delete fComment;
+	    fComment = new TString(r.Comment.c_str());
+	}
+	reply = args[1] + " " + value;
+    }
+    else
+    {
+	reply = "unknown command " + cmd;
+	return false;
+    }
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PublishPoint
+ *
+ * Description : Hand the newest point in the store to the control
+ *               socket subscribers.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::PublishPoint(void)
+{
+    uint32_t i;
+
+    if ((fControl == NULL) || (fStore->N() == 0)) return;
+    i = fStore->N() - 1;
+    fControl->Publish(i, fViewScale*fStore->SetV()[i], fStore->Mean()[i],
+		      fStore->Sigma()[i], fStore->NSamples()[i],
+		      fStore->Time()[i], fStore->StepType()[i],
+		      fStore->BranchOf()[i]);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TuneFromProfile
+ *
+ * Description : Set the sweep up from what is known of the part,
+ *               the part number or failing that the comment. A copy
+ *               of the settings is tuned, they are put back at the
+ *               end of the sweep so tunes do not build on each other
+ *               and are never saved as the configuration.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::TuneFromProfile(void)
+{
+    SET_DEBUG_STACK;
+    Recipe r;
+
+    if (fProfiles == NULL) return;
+    Restore(fUntuned);
+    Snapshot(r);
+    r.Comment    = fComment ? fComment->Data() : "";
+    if (fProfiles->Tune(r))
+    {
+	fUntuned = new Recipe();
+	Snapshot(*fUntuned);
+	r.Apply(fInstruments);
+	fStatusBar->SetText(Form("Tuned for %s", r.PartKey().c_str()), 0);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Snapshot
+ *
+ * Description : The settings as they stand, resources under the
+ *               instruments, mode and part.
+ *
+ * Inputs : r - filled
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::Snapshot(Recipe &r) const
+{
+    SET_DEBUG_STACK;
+    r.Read(fEnv);
+    r.From(fInstruments);
+    r.Mode       = fMode;
+    r.Resistance = fResistor;
+    r.Part       = fPartNumber;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Restore
+ *
+ * Description : Put saved settings back and forget them.
+ *
+ * Inputs : r - settings from Snapshot, NULL does nothing, set
+ *              NULL
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::Restore(Recipe* &r)
+{
+    SET_DEBUG_STACK;
+    if (r == NULL) return;
+    r->Apply(fInstruments);
+    fMode       = r->Mode;
+    fResistor   = r->Resistance;
+    fPartNumber = r->Part;
+    delete r;
+    r = NULL;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LearnProfile
+ *
+ * Description : Fold the sweep just finished into the part profile.
+ *               Until the profile has enough of them the settle 
+ *               time is measured on the first step of the sweep,
+ *               which holds the window up for a couple of seconds.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::LearnProfile(void)
+{
+    SET_DEBUG_STACK;
+    std::string part = fPartNumber;
+    double      From, To, Expected, Settle = NAN;
+
+    if (part.empty() && fComment) part = fComment->Data();
+    if (fProfiles->WantsSettle(part) &&
+	ProfileStore::SettleStep(*fStore, From, To, Expected))
+    {
+	fStatusBar->SetText("Measuring settle time", 0);
+	gSystem->ProcessEvents();
+	Settle = fInstruments->MeasureSettle(From, To, Expected);
+    }
+    if (fProfiles->Learn(part, *fStore, fInstruments->CurrentLimit(),
+			 fInstruments->ComplianceVoltage(), Settle))
+    {
+	fProfiles->Save();
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ShowOnlineFit
+ *
+ * Description : Put the running fit in the status bar while the 
+ *               sweep is in progress, note it in the log when it 
+ *               first settles so the operator can stop early.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::ShowOnlineFit(void)
+{
+    SET_DEBUG_STACK;
+    const DiodeParams &p = fOnline->Params();
+
+    if (fOnline->Refined())
+    {
+	fStatusBar->SetText(
+	    Form("Is=%.3g(%.2g) n=%.3f(%.3f) Rs=%.3g(%.2g)%s",
+		 p.Is, p.Error[0], p.n, p.Error[1], p.Rs, p.Error[2],
+		 fOnline->Stable() ? " stable" : ""), 0);
+    }
+    else
+    {
+	fStatusBar->SetText(Form("Is=%.3g(%.2g) n=%.3f(%.3f)",
+				 p.Is, p.Error[0], p.n, p.Error[1]), 0);
+    }
+    if (fOnline->Stable() && !fOnlineStable)
+    {
+	CLogger::GetThis()->Log("# IVCurve: online fit stable after %d points, Is = %g +/- %g A, n = %g +/- %g, Rs = %g +/- %g\n",
+				(int) fOnline->NPoints(), p.Is, p.Error[0],
+				p.n, p.Error[1], p.Rs, p.Error[2]);
+    }
+    fOnlineStable = fOnline->Stable();
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitData
+ *
+ * Description : Fit the diode equation to the current plot. 
+ *
+ * Inputs : NONE
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::FitData(void)
+{
+    SET_DEBUG_STACK;
+    /*
+     * https://en.wikipedia.org/wiki/Diode_modelling
+     *
+     * https://root.cern.ch/doc/master/classTGraph.html#a61269bcd47a57296f0f1d57ceff8feeb
+     *
+     * FIXME, put the upper and lower limits in. 
+     * parameters dialog. 
+     */
+    PlotMe(0);
+    TAxis *a     = fGraph->GetXaxis();
+    Double_t min = a->GetXmin();
+    Double_t max = a->GetXmax();
+    if (fAutoWindow)
+    {
+	FitWindow(min, max);
+    }
+    fFitFunction->SetRange(min,max);
+    fFullFunction->SetRange(min,max);
+    /*
+     * Minuit only gets the Shockley form, it has no good way to start
+     * the full model.
+     */
+    if ((fFitEngine == 0) && (fFitModel == 0))
+    {
+	fGraph->Fit(fFitFunction,"V","", min, max);
+    }
+    else if (!NativeFit(min, max))
+    {
+	return;
+    }
+    if (fFitModel == 0)
+    {
+	fPlotNotes->DrawLatexNDC( 0.15, 0.85,
+				  "I(V) = I_{s}(e^{#frac{V}{K_{b} T}}-1.0)");
+	fFitFunction->Draw("SAME");
+    }
+    else
+    {
+	fPlotNotes->DrawLatexNDC( 0.15, 0.85,
+          "I = I_{s}(e^{#frac{V-IR_{s}}{nV_{t}}}-1) + #frac{V-IR_{s}}{R_{sh}}");
+	fFullFunction->Draw("SAME");
+    }
+    gPad->Update();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitErrors
+ *
+ * Description : Fit the current curve then resample it, bootstrap or
+ *               jackknife, for errors that do not lean on Gaussian
+ *               residuals. The intervals go to the log and the 
+ *               status bar.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : no data, fit failed.
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::FitErrors(void)
+{
+    SET_DEBUG_STACK;
+    static const char   *names[] = {"Is", "n", "Rs", "Rsh"};
+    CLogger             *log = CLogger::GetThis();
+    std::vector<double> V, I;
+    DiodeParams         p;
+    Double_t            min = -HUGE_VAL, max = HUGE_VAL;
+    Bool_t              ok;
+    uint32_t            npar = (fFitModel == 1) ? 4 : 2;
+    Bootstrap::Method   how  = (fBootMethod == 1) ? 
+	Bootstrap::kJackknife : Bootstrap::kBootstrap;
+
+    if ((fGraph == NULL) || (fGraph->GetN() == 0))
+    {
+	return;
+    }
+    if (fAutoWindow)
+    {
+	FitWindow(min, max);
+    }
+    RegionDetect::Select(fGraph->GetX(), fGraph->GetY(), fGraph->GetN(),
+			 min, max, V, I);
+    fDiodeFit->Temperature(fTemperature);
+    if (fFitModel == 1)
+	ok = fDiodeFit->FitFull(&V[0], &I[0], V.size(), p);
+    else
+	ok = fDiodeFit->FitShockley(&V[0], &I[0], V.size(), p);
+    if (!ok)
+    {
+	fStatusBar->SetText("Fit failed.", 0);
+	return;
+    }
+
+    fBootstrap->Temperature(fTemperature);
+    if (!fBootstrap->Run(&V[0], &I[0], V.size(), fFitModel == 1 ?
+			 DiodeFit::kFull : DiodeFit::kShockley,
+			 p, how, fNReplicas, fBootCL))
+    {
+	log->Log("# IVCurve: resampling failed, %d of %d converged.\n",
+		 (int) fBootstrap->NConverged(), 
+		 (int) fBootstrap->NReplicas());
+	fStatusBar->SetText("Resampling failed.", 0);
+	return;
+    }
+    log->Log("# IVCurve: %s, %d of %d replicas, %.1f%% intervals\n",
+	     (how == Bootstrap::kJackknife) ? "jackknife" : "bootstrap",
+	     (int) fBootstrap->NConverged(), (int) fBootstrap->NReplicas(),
+	     100.0*fBootCL);
+    for (uint32_t k=0; k<npar; k++)
+    {
+	const BootstrapInterval &b = fBootstrap->Interval(k);
+	log->Log("#   %-3s = %g  fit error %g  resampled sigma %g  [%g, %g]\n",
+		 names[k], (k==0) ? p.Is : (k==1) ? p.n : (k==2) ? p.Rs : p.Rsh,
+		 p.Error[k], b.Sigma, b.Lo, b.Hi);
+    }
+    const BootstrapInterval &bi = fBootstrap->Interval(0);
+    const BootstrapInterval &bn = fBootstrap->Interval(1);
+    fStatusBar->SetText(Form("Is [%.3g, %.3g]  n [%.4f, %.4f]",
+			     bi.Lo, bi.Hi, bn.Lo, bn.Hi), 0);
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FitWindow
+ *
+ * Description : Pick the fit range from the regions of the curve,
+ *               the exponential region for Shockley, all of forward
+ *               bias short of compliance for the full model. 
+ *
+ * Inputs : min, max - range, left alone if no window is found.
+ *
+ * Returns : true if a window was found
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::FitWindow(Double_t &min, Double_t &max)
+{
+    SET_DEBUG_STACK;
+    CLogger *log = CLogger::GetThis();
+    size_t  i;
+
+    fRegions->Temperature(fTemperature);
+    fRegions->Compliance((fMode == 3) ? fInstruments->CurrentLimit() : 0.0);
+    fRegions->Analyze(fGraph->GetX(), fGraph->GetY(), fGraph->GetN());
+    for (i=0; i<fRegions->Regions().size(); i++)
+    {
+	const RegionDetect::Region &r = fRegions->Regions()[i];
+	log->Log("# IVCurve: %-11s %6d points %g to %g V\n",
+		 RegionDetect::Name(r.Type), r.NPoints, r.Vlo, r.Vhi);
+    }
+    if (!fRegions->Window(fFitModel == 1, min, max))
+    {
+	log->Log("# IVCurve: no fit window found, using the full range.\n");
+	return false;
+    }
+    log->Log("# IVCurve: fit window %g to %g V\n", min, max);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NativeFit
+ *
+ * Description : Fit the diode with the compiled LM fitter rather
+ *               than through Minuit. The result is loaded into 
+ *               fFitFunction, or fFullFunction for the full model, so
+ *               it is drawn the same way as a Minuit fit. 
+ *
+ * Inputs : min, max - voltage range to fit over
+ *
+ * Returns : true if the fit converged
+ *
+ * Error Conditions : too few forward points in range
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::NativeFit(Double_t min, Double_t max)
+{
+    SET_DEBUG_STACK;
+    CLogger             *log = CLogger::GetThis();
+    std::vector<double> V, I;
+    DiodeParams         p;
+    const Double_t      *x = fGraph->GetX();
+    const Double_t      *y = fGraph->GetY();
+
+    for (Int_t i=0; i<fGraph->GetN(); i++)
+    {
+	if ((x[i] >= min) && (x[i] <= max))
+	{
+	    V.push_back(x[i]);
+	    I.push_back(y[i]);
+	}
+    }
+    fDiodeFit->Temperature(fTemperature);
+    if (fFitModel == 1)
+    {
+	if (!fDiodeFit->FitFull(&V[0], &I[0], V.size(), p))
+	{
+	    log->Log("# IVCurve: full diode fit failed, %d points in range.\n",
+		     (int) V.size());
+	    fStatusBar->SetText("Fit failed.", 0);
+	    return false;
+	}
+	for (Int_t i=0; i<4; i++)
+	{
+	    fFullFunction->SetParError(i, p.Error[i]);
+	}
+	fFullFunction->SetParameters(p.Is, p.n, p.Rs, p.Rsh, fTemperature);
+	fFullFunction->SetChisquare(p.Chi2);
+	fFullFunction->SetNDF(p.NDF);
+	log->Log("# IVCurve: full diode fit Is = %g +/- %g A, n = %g +/- %g, Rs = %g +/- %g, Rsh = %g +/- %g, chi2/ndf = %g/%d, %d iterations.\n",
+		 p.Is, p.Error[0], p.n, p.Error[1], p.Rs, p.Error[2],
+		 p.Rsh, p.Error[3], p.Chi2, p.NDF, p.Iterations);
+	fStatusBar->SetText(Form("Is = %.3g A  n = %.3f  Rs = %.3g  Rsh = %.3g",
+				 p.Is, p.n, p.Rs, p.Rsh), 0);
+	return true;
+    }
+    if (!fDiodeFit->FitShockley(&V[0], &I[0], V.size(), p))
+    {
+	log->Log("# IVCurve: Shockley fit failed, %d points in range.\n",
+		 (int) V.size());
+	fStatusBar->SetText("Fit failed.", 0);
+	return false;
+    }
+    fFitFunction->SetParameter(0, p.Is);
+    fFitFunction->SetParError(0,  p.Error[0]);
+    fFitFunction->SetParameter(1, p.n*fDiodeFit->ThermalVoltage());
+    fFitFunction->SetParError(1,  p.Error[1]*fDiodeFit->ThermalVoltage());
+    fFitFunction->SetChisquare(p.Chi2);
+    fFitFunction->SetNDF(p.NDF);
+
+    log->Log("# IVCurve: Shockley fit Is = %g +/- %g A, n = %g +/- %g, chi2/ndf = %g/%d, %d iterations.\n",
+	     p.Is, p.Error[0], p.n, p.Error[1], p.Chi2, p.NDF, p.Iterations);
+    fStatusBar->SetText(Form("Is = %.3g A  n = %.3f", p.Is, p.n), 0);
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FullDiode
+ *
+ * Description : TF1 wrapper around the full diode model so the
+ *               result of a full fit can be drawn. 
+ *
+ * Inputs : x   - voltage
+ *          par - Is, n, Rs, Rsh, T
+ *
+ * Returns : current
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+static Double_t FullDiode(Double_t *x, Double_t *par)
+{
+    DiodeFit    fit(par[4]);
+    DiodeParams p;
+
+    p.Is  = par[0];
+    p.n   = par[1];
+    p.Rs  = par[2];
+    p.Rsh = par[3];
+    return fit.Full(x[0], p);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CreateFitFunction
+ *
+ * Description :
+ * https://root.cern.ch/doc/master/classTF1.html
+ * 
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void IVCurve::CreateFitFunction(void)
+{
+    /*
+     * Thermal voltage 
+     */
+    Double_t IdealityFactor = 1.0; 
+    Double_t ThermalVoltage =  IdealityFactor * TMath::K() * fTemperature/TMath::Qe();
+    fFitFunction = new TF1("Shockley", "[0]*(exp(x/[1])-1.0)",0.0, 1.0);
+    fFitFunction->SetParameter(0, 1.0e-3);
+    // Can we fix the thermal voltage? 
+    fFitFunction->SetParameter(1, ThermalVoltage);
+    fFitFunction->SetLineColor(2);
+
+    /*
+     * Is, n, Rs and Rsh, the temperature rides along fixed so the 
+     * function can be drawn on its own.
+     */
+    fFullFunction = new TF1("DiodeFull", FullDiode, 0.0, 1.0, 5);
+    fFullFunction->SetParNames("Is", "n", "Rs", "Rsh", "T");
+    fFullFunction->SetParameters(1.0e-12, 1.0, 1.0, 1.0e9, fTemperature);
+    fFullFunction->FixParameter(4, fTemperature);
+    fFullFunction->SetLineColor(2);
+
+    fDiodeFit = new DiodeFit(fTemperature);
+
+    //fPlotNotes = new TPaveLabel( 0.0, 140.0, 4.0, 180.0, 
+    fPlotNotes = new TLatex( );
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadConfiguration
+ *
+ * Description : Open read the configuration file. 
+ *
+ * Inputs : none
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on:  
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool IVCurve::ReadConfiguration(void)
+{
+    SET_DEBUG_STACK;
+    CLogger *log = CLogger::GetThis();
+
+    fEnv = new TEnv(".IVCurve");
+    log->Log("# IVCurve Loading prefs: %s \n", fEnv->GetRcName());
+
+    int32_t v = fEnv->GetValue("IVCurve.Verbose", 0);
+    log->SetVerbose(v);
+
+    uint8_t Voltmeter     = fEnv->GetValue("Voltmeter.GPIB", 3);
+    uint8_t VoltageSource = fEnv->GetValue("VoltageSource.GPIB", 14);
+    // The sweep itself, shared with the headless runner.
+    Recipe  recipe;
+    if (!recipe.Read(fEnv))
+    {
+	log->Log("# IVCurve: check the sweep settings in %s\n",
+		 fEnv->GetRcName());
+    }
+    fResistor             = recipe.Resistance;
+    fMode                 = recipe.Mode;
+    fDisplayRate          = fEnv->GetValue("IVCurve.DisplayRate", 10.0);
+    fTemperature          = fEnv->GetValue("IVCurve.Temperature", 293.15);
+    fFitEngine            = fEnv->GetValue("IVCurve.FitEngine",      1);
+    fFitModel             = fEnv->GetValue("IVCurve.FitModel",       0);
+    fOnlineFit            = fEnv->GetValue("IVCurve.OnlineFit",      1);
+    fOnlineRefine         = fEnv->GetValue("IVCurve.OnlineRefine",  25);
+    fAutoWindow           = fEnv->GetValue("IVCurve.AutoWindow",     1);
+    fThreads              = fEnv->GetValue("IVCurve.Threads",        0);
+    fNReplicas            = fEnv->GetValue("IVCurve.Bootstrap",   2000);
+    fBootMethod           = fEnv->GetValue("IVCurve.BootstrapMethod", 0);
+    fBootCL               = fEnv->GetValue("IVCurve.BootstrapCL", 0.95);
+    fShowDerived          = fEnv->GetValue("IVCurve.Derived",        1);
+    fSGHalfWidth          = fEnv->GetValue("IVCurve.SGHalfWidth",    3);
+    // Space separated list of currents, amps.
+    std::istringstream VfList(fEnv->GetValue("IVCurve.VfCurrents", 
+					      "1.0e-6 1.0e-4 1.0e-3"));
+    double Vf;
+    fVfCurrents.clear();
+    while (VfList >> Vf) fVfCurrents.push_back(Vf);
+    fPartNumber           = fEnv->GetValue("IVCurve.PartNumber",      "");
+    fGoldenDir            = fEnv->GetValue("IVCurve.GoldenDir", "golden");
+    fGoldenRel            = fEnv->GetValue("IVCurve.GoldenRel",     0.05);
+    fGoldenAbs            = fEnv->GetValue("IVCurve.GoldenAbs",   1.0e-9);
+    fGoldenGrid           = fEnv->GetValue("IVCurve.GoldenGrid",     512);
+    fControlPath          = fEnv->GetValue("IVCurve.ControlSocket", 
+					   "/tmp/IVCurve.sock");
+    fProfileFile          = fEnv->GetValue("IVCurve.ProfileFile",     "");
+    fAutoTune             = fEnv->GetValue("IVCurve.AutoTune",        0);
+
     switch (fMode)
     {
     case 0:
@@ -1697,27 +3846,39 @@ bool IVCurve::ReadConfiguration(void)
     }
 
 
-    // Open the instruments - 
-    fInstruments = new Instruments(Voltmeter, VoltageSource);
+    // Open the instruments, play a trace back or simulate them.
+    std::string Replay = fEnv->GetValue("IVCurve.Replay", "");
+    std::string Trace  = fEnv->GetValue("IVCurve.Trace",  "");
+    if (fEnv->GetValue("IVCurve.Simulate", 0))
+    {
+	fInstruments = new Instruments(SimBackend::Open(fEnv));
+    }
+    else if (Replay.empty())
+    {
+	fInstruments = new Instruments(new KeithleyBackend(Voltmeter, 
+							   VoltageSource));
+    }
+    else
+    {
+	fInstruments = new Instruments(new TraceReplay(Replay.c_str(), 
+			    fEnv->GetValue("IVCurve.ReplayRealTime", 1)));
+    }
     if (fInstruments->Error())
     {
 	cerr << "ERROR STARTING INSTRUMENTS." << endl;
 	return false;
     }
+    if (!Trace.empty())
+    {
+	fInstruments->Record(Trace.c_str());
+    }
     fComment     = NULL;
 
     /**
      * Configure the various parameters in the instruments according to
      * the configuration file. 
      */
-    fInstruments->Start(Start);
-    fInstruments->Stop( Stop);
-    fInstruments->Step( Step);
-    fInstruments->Fine( Fine);
-    fInstruments->Window(Window);
-    fInstruments->SetCurrentLimit(MaxCurrent);
-    fInstruments->FineOnly(FINEONLY);
-    fInstruments->NAVG(NAVG);
+    recipe.Apply(fInstruments);
 
     SET_DEBUG_STACK;
     return true;
@@ -1752,16 +3913,48 @@ bool IVCurve::WriteConfiguration(void)
     fEnv->SetValue("IVCurve.Verbose"   , (Int_t) log->GetVerbose());
     fEnv->SetValue("Voltmeter.GPIB",     fInstruments->MultimeterAddress());
     fEnv->SetValue("VoltageSource.GPIB", fInstruments->VoltageSourceAddress());
-    fEnv->SetValue("VoltageSource.Start",    fInstruments->Start());
-    fEnv->SetValue("VoltageSource.Stop",     fInstruments->Stop());
-    fEnv->SetValue("VoltageSource.Step",     fInstruments->Step());
-    fEnv->SetValue("VoltageSource.FineStep", fInstruments->Fine());
-    fEnv->SetValue("VoltageSource.Window",   fInstruments->Window());
-    fEnv->SetValue("IVCurve.Resistance",     fResistor);
-    fEnv->SetValue("IVCurve.Mode",           fMode);
-    fEnv->SetValue("VoltageSource.MaxI",     fInstruments->CurrentLimit());
-    fEnv->SetValue("IVCurve.Average",    (int) fInstruments->NAVG());
-    fEnv->SetValue("IVCurve.FINE_ONLY",  (bool) fInstruments->FineOnly());
+    // The user's settings, not those of a tune or queue in progress.
+    Recipe recipe;
+    if (fUserSettings)
+    {
+	recipe = *fUserSettings;
+    }
+    else if (fUntuned)
+    {
+	recipe = *fUntuned;
+    }
+    else
+    {
+	Snapshot(recipe);
+    }
+    recipe.Write(fEnv);
+    fEnv->SetValue("IVCurve.DisplayRate",    fDisplayRate);
+    fEnv->SetValue("IVCurve.Temperature",    fTemperature);
+    fEnv->SetValue("IVCurve.FitEngine",      (int) fFitEngine);
+    fEnv->SetValue("IVCurve.FitModel",       (int) fFitModel);
+    fEnv->SetValue("IVCurve.OnlineFit",      (bool) fOnlineFit);
+    fEnv->SetValue("IVCurve.OnlineRefine",   (int) fOnlineRefine);
+    fEnv->SetValue("IVCurve.AutoWindow",     (bool) fAutoWindow);
+    fEnv->SetValue("IVCurve.Threads",        (int) fThreads);
+    fEnv->SetValue("IVCurve.Bootstrap",      (int) fNReplicas);
+    fEnv->SetValue("IVCurve.BootstrapMethod",(int) fBootMethod);
+    fEnv->SetValue("IVCurve.BootstrapCL",    fBootCL);
+    fEnv->SetValue("IVCurve.Derived",        (bool) fShowDerived);
+    fEnv->SetValue("IVCurve.SGHalfWidth",    (int) fSGHalfWidth);
+    std::ostringstream VfList;
+    for (size_t i=0; i<fVfCurrents.size(); i++)
+    {
+	VfList << (i ? " " : "") << fVfCurrents[i];
+    }
+    fEnv->SetValue("IVCurve.VfCurrents",     VfList.str().c_str());
+    fEnv->SetValue("IVCurve.PartNumber",     fPartNumber.c_str());
+    fEnv->SetValue("IVCurve.GoldenDir",      fGoldenDir.c_str());
+    fEnv->SetValue("IVCurve.GoldenRel",      fGoldenRel);
+    fEnv->SetValue("IVCurve.GoldenAbs",      fGoldenAbs);
+    fEnv->SetValue("IVCurve.GoldenGrid",     (int) fGoldenGrid);
+    fEnv->SetValue("IVCurve.ControlSocket",  fControlPath.c_str());
+    fEnv->SetValue("IVCurve.ProfileFile",    fProfileFile.c_str());
+    fEnv->SetValue("IVCurve.AutoTune",       (bool) fAutoTune);
 
     fEnv->SaveLevel(kEnvUser);
     delete fEnv;
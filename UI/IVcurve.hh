@@ -20,6 +20,8 @@
 #ifndef __IVCURVE_hh_
 #define __IVCURVE_hh_
 
+#  include <string>
+#  include <vector>
 #  include <TGFrame.h>
 #  include <TPoint.h>
 class TGWindow;
@@ -36,12 +38,30 @@ class TColor;
 class Instruments;
 class TGPopupMenu;
 class TGraph;
+class TGraphErrors;
+class TH1;
+class TH1F;
 class TTimer;
 class TF1;
 class TPaveLabel;
 class TString;
 class TLatex;
 class TEnv;
+class DisplayScheduler;
+class MinMaxPyramid;
+class RunCache;
+class DiodeFit;
+class OnlineFit;
+class RegionDetect;
+class ThreadPool;
+class Bootstrap;
+class DerivedChannels;
+class GoldenCompare;
+class SampleStore;
+class RecipeQueue;
+class ControlServer;
+class ProfileStore;
+struct Recipe;
 
 enum PlotStateVals {PLOT_STATE_NORMAL, PLOT_STATE_ZOOM};
 
@@ -57,9 +77,12 @@ public:
     void HandleMenu(Int_t id);
     void HandleToolBar(Int_t id);
     void TimeoutProc(void);
+    void DisplayProc(void);
+    void ControlProc(void);
 
 private:
     TRootEmbeddedCanvas *fEmbeddedCanvas;
+    TRootEmbeddedCanvas *fDerivedCanvas; // dI/dV, Rdyn, log|I| pads
     TGStatusBar         *fStatusBar; 
     Double_t            down_x, down_y;
     TString             *fLastDir;
@@ -76,8 +99,48 @@ private:
      * For plotting
      */
     // Plotting
-    TGraph*             fGraph;
+    SampleStore*        fStore;       // The acquired data
+    TGraphErrors*       fGraph;       // View of fStore for display
+    TGraphErrors*       fGraphDown;   // Return branch, same store
+    Int_t               fNDownPlotted;
+    Double_t            fViewScale;   // x on fGraph is SetV*fViewScale
+    TH1F*               fFrame;       // Axis frame, drawn once per sweep
+    Int_t               fNPlotted;    // Points of fGraph already painted
+    Double_t            fXlo, fXhi;   // Current frame limits. 
+    Double_t            fYlo, fYhi;
+    // Level of detail for large data sets. 
+    MinMaxPyramid*      fPyramid;
+    TGraph*             fLODGraph;    // min/max envelope of fGraph
+    MinMaxPyramid*      fPyramidDown;
+    TGraph*             fLODDown;     // and of fGraphDown
+    Bool_t              fLODActive;   // Drawing fLODGraph, not fGraph
+    // Overlay of many runs
+    RunCache*           fRuns;
+    TMultiGraph*        fOverlay;
+    TLegend*            fLegend;
+    Bool_t              fOverlayMode; // Showing fOverlay, not fGraph
     TF1*                fFitFunction;
+    TF1*                fFullFunction;// Is, n, Rs, Rsh model
+    DiodeFit*           fDiodeFit;    // Compiled LM fitter
+    OnlineFit*          fOnline;      // Running fit during a sweep
+    Bool_t              fOnlineStable;// Last state shown
+    RegionDetect*       fRegions;     // Picks the fit window
+    ThreadPool*         fPool;        // Workers for resampling
+    Bootstrap*          fBootstrap;   // Resampled fit errors
+    DerivedChannels*    fDerived;     // dI/dV etc. as points arrive
+    TGraph*             fGdIdV;       // Derived channel graphs
+    TGraph*             fGRdyn;
+    TGraph*             fGLogI;
+    Int_t               fNDerivedPlotted; // Points of fDerived in them
+    Int_t               fNLogIPlotted;
+    GoldenCompare*      fGolden;      // Reference for the part number
+    RecipeQueue*        fQueue;       // Unattended sweeps
+    Bool_t              fQueueRunning;
+    ControlServer*      fControl;     // Local socket, NULL if off
+    TTimer*             fControlTimer;
+    ProfileStore*       fProfiles;    // Learned part profiles, or NULL
+    Recipe*             fUntuned;     // Settings before a tune, or NULL
+    Recipe*             fUserSettings;// Settings before a queue, or NULL
     //TPaveLabel*         fPlotNotes;
     TLatex*             fPlotNotes;
 
@@ -104,6 +167,8 @@ private:
     TGPopupMenu*        fMenuInstrument; 
 
     TTimer*             fTimer;
+    TTimer*             fDisplayTimer;     // Live plot refresh
+    DisplayScheduler*   fDisplay;          // Live plot frame rate
 
     // Logging
     TString*            fComment;
@@ -113,6 +178,38 @@ private:
 
     // Enviroment settings
     Double_t            fResistor;
+    Double_t            fDisplayRate;      // Max live plot frames/sec
+    Double_t            fTemperature;      // Junction temperature, K
+    /*!
+     * Fit engine
+     *    0 - TF1 through ROOT Minuit
+     *    1 - DiodeFit, compiled LM with analytic Jacobian
+     */
+    UChar_t             fFitEngine;
+    /*!
+     * Fit model
+     *    0 - Shockley, Is and n
+     *    1 - Full, Is, n, series Rs and shunt Rsh
+     */
+    UChar_t             fFitModel;
+    Bool_t              fOnlineFit;        // Fit as the sweep runs
+    UInt_t              fOnlineRefine;     // Points between refinements
+    Bool_t              fAutoWindow;       // Fit window from regions
+    UInt_t              fThreads;          // Pool size, 0 one per core
+    UInt_t              fNReplicas;        // Bootstrap replicas
+    UChar_t             fBootMethod;       // 0 bootstrap, 1 jackknife
+    Double_t            fBootCL;           // Interval confidence level
+    Bool_t              fShowDerived;      // Derived channel pads
+    UInt_t              fSGHalfWidth;      // Savitzky-Golay window 2M+1
+    std::vector<double> fVfCurrents;       // Report Vf at these currents
+    std::string         fPartNumber;       // Selects the golden curve
+    std::string         fGoldenDir;        // Where golden curves live
+    Double_t            fGoldenRel;        // Band, fraction of Iref
+    Double_t            fGoldenAbs;        // Band, amps
+    UInt_t              fGoldenGrid;       // Comparison grid points
+    std::string         fControlPath;      // Control socket, "" off
+    std::string         fProfileFile;      // Part profiles, "" off
+    Bool_t              fAutoTune;         // Sweep from the profile
 
     /*!
      * modes
@@ -134,12 +231,20 @@ private:
     void FileDialog(bool LoadOrSave);
     void DoSaveAs(void);
     bool Load(const char *Filename);
+    void OverlayDialog(void);
+    void SelectRuns(void);
+    void PlotOverlay(void);
     bool Save(const char *Filename);
     bool ReadConfiguration(void);
     bool WriteConfiguration(void);
     void CleanUp(void);
 
     void PlotMe(Int_t);
+    void PlotAppend(void);
+    void PlotReturn(void);
+    bool ExtendFrame(void);
+    void SetAxisTitles(TH1 *h);
+    void RefineLOD(void);
     void UnZoom(void);
     void Zoom(void);
     void ZoomAxis(TAxis *a);
@@ -148,6 +253,25 @@ private:
 
     // For later
     void FitData(void);
+    bool NativeFit(Double_t min, Double_t max);
+    void ShowOnlineFit(void);
+    bool FitWindow(Double_t &min, Double_t &max);
+    void FitErrors(void);
+    void PlotDerived(void);
+    std::string ReferenceFile(void) const;
+    bool LoadReference(void);
+    void SetReference(void);
+    void CheckReference(void);
+    void RunQueue(void);
+    void StartQueued(void);
+    void QueueSweepDone(void);
+    bool ControlCommand(const std::vector<std::string> &args,
+			std::string &reply);
+    void PublishPoint(void);
+    void TuneFromProfile(void);
+    void LearnProfile(void);
+    void Snapshot(Recipe &r) const;
+    void Restore(Recipe* &r);
 
     // Open and parse utilities
     bool CreateGraphObjects(void);
@@ -21,16 +21,14 @@
 using namespace std;
 #include <string>
 #include <cmath>
-
-// GPIB control.
-#include "Keithley2x0.hh"
-#include "Keithley196.hh"
-
+#include <ctime>
 
 // Local Includes.
 #include "debug.h"
 #include "CLogger.hh"
 #include "Instruments.hh"
+#include "KeithleyBackend.hh"
+#include "TraceRecorder.hh"
 
 // Default Starting values
 const double kIncrement =  0.1;    // Volts
@@ -38,7 +36,48 @@ const double kMedium    =  0.05;   // Volts
 const double kFine      =  0.01;   // Volts
 const double kStart     = -1.0;    // Volts
 const double kStop      =  1.0;    // Volts
-const double kCurrentLimit = 1.0e3; // Current limit 1mA
+const double kCurrentLimit = 4.0e-3; // Current limit 4mA
+const double kSettle    =  0.25;   // Seconds
+const double kSample    =  0.1;    // Seconds between averaged reads
+// No sweep plan is longer than this.
+const uint32_t kMaxPlanPoints = 10000000;
+// |I| within this fraction of the limit is in compliance.
+const double kAtLimit      = 0.98;
+// A current plateau only counts above this fraction of the limit.
+const double kPlateauFloor = 0.5;
+// Step multiplier under the Coarse policy.
+const double kComplianceStride = 10.0;
+// Pulsed defaults, seconds.
+const double kPulseWidth = 0.05;
+const double kPulseOff   = 0.5;
+const double kPulseDelay = 0.03;
+/*
+ * Keithley 196 full scale by range, R1 upward, R0 is autorange.
+ * DCA 300uA to 3A, DCV 300mV to 300V.
+ */
+const double  kDCARange[] = {300.0e-6, 3.0e-3, 30.0e-3, 300.0e-3, 3.0};
+const uint8_t kNDCARange  = 5;
+const double  kDCVRange[] = {0.3, 3.0, 30.0, 300.0};
+const uint8_t kNDCVRange  = 4;
+/*
+ * Counts at full scale and integration time for the rates, 3.5 to
+ * 6.5 digits. 3.5 and 4.5 share the short integration, 5.5 is one
+ * line cycle, 6.5 ten.
+ */
+const double  kRateCounts[] = {3.0e3, 3.0e4, 3.0e5, 3.0e6};
+const double  kRateTime[]   = {3.0e-3, 3.0e-3, 16.7e-3, 166.7e-3};
+const uint8_t kNRates       = 4;
+const uint8_t kNoRange      = 0xFF;
+// Expected readings kept below this fraction of full scale.
+const double kRangeFill  = 0.8;
+// A reading beyond this fraction of full scale is over range.
+const double kOverRange  = 1.01;
+// Most the current is taken to grow from one up point to the next.
+const double kMaxGrowth  = 10.0;
+// Default resolution, relative to the reading.
+const double kNoiseTarget = 1.0e-3;
+// Most readings taken watching a step settle.
+const size_t kMaxSettleReadings = 10000;
 
 Instruments* Instruments::fInstruments;
 
@@ -69,46 +108,27 @@ Instruments::Instruments (uint8_t Keithley196_Address,
 			  uint8_t Keithley230_Address)
 {
     SET_DEBUG_STACK;
-    CLogger *LogPtr = CLogger::GetThis();
     fInstruments = this;
-    fError = false;
-
     // Try to open the instruments. 
-    if(!OpenKeithley196(Keithley196_Address))
-    {
-	fError = true;
-	return;
-    }
-    if (!OpenKeithley230(Keithley230_Address))
-    {
-	fError = true;
-	return;
-    }
-
-    Reset();
-    fStartVoltage = kStart;
-    fStopVoltage  = kStop;
-    fStep         = kIncrement;
-    fFine         = kFine;
-    fCurrentStep  = fStep;
-    fFINE_ONLY    = true;
-    fNAVG         = 1;
-
+    fBackend = new KeithleyBackend(Keithley196_Address, Keithley230_Address);
+    fError   = !(fBackend->MeterOK() && fBackend->SourceOK());
+    Init();
     SET_DEBUG_STACK;
 }
-
 /**
  ******************************************************************
  *
- * Function Name : Instruments destructor
+ * Function Name : Instruments constructor
  *
- * Description : Clean up the instruments
+ * Description :
+ *     Run on the backend given, a replay or a simulation.
  *
- * Inputs : NONE
+ * Inputs :
+ *   Backend - owned from here on
  *
  * Returns : NONE
  *
- * Error Conditions : NONE
+ * Error Conditions : if either instrument is not there
  * 
  * Unit Tested on: 
  *
@@ -117,18 +137,21 @@ Instruments::Instruments (uint8_t Keithley196_Address,
  *
  *******************************************************************
  */
-Instruments::~Instruments (void)
+Instruments::Instruments (GpibBackend *Backend)
 {
-    delete hgpib196;
-    delete hgpib230;
+    SET_DEBUG_STACK;
+    fInstruments = this;
+    fBackend = Backend;
+    fError   = !(fBackend->MeterOK() && fBackend->SourceOK());
+    Init();
     SET_DEBUG_STACK;
 }
 /**
  ******************************************************************
  *
- * Function Name : Reset
+ * Function Name : Init
  *
- * Description : Reset all state machine pointers etc. 
+ * Description : Default settings and a reset state machine.
  *
  * Inputs : NONE
  *
@@ -143,24 +166,50 @@ Instruments::~Instruments (void)
  *
  *******************************************************************
  */
-void Instruments::Reset(void)
+void Instruments::Init(void)
 {
     SET_DEBUG_STACK;
-    fStepNumber  = 0;
-    fSetVoltage  = fStartVoltage;
-    fVoltage     = 0.0;
-    fResult      = 0.0;
-    fCurrentStep = fStep;
-    fStepType    = 0;
+    Reset();
+    fStartVoltage = kStart;
+    fStopVoltage  = kStop;
+    fStep         = kIncrement;
+    fFine         = kFine;
+    fBandFrom     = 0.0;
+    fBandTo       = 0.0;
+    fCurrentStep  = fStep;
+    fFINE_ONLY    = true;
+    fNAVG         = 1;
+    fSettle       = kSettle;
+    fMaxI         = kCurrentLimit;
+    fMeasureCurrent = false;
+    fPolicy        = kComplianceContinue;
+    fSenseR        = 0.0;
+    fPlateauPoints = 3;
+    fPlateauTol    = 2.0e-3;
+    fPulsed        = false;
+    fPulseWidth    = kPulseWidth;
+    fPulseOff      = kPulseOff;
+    fPulseBase     = 0.0;
+    fPulseDelay    = kPulseDelay;
+    fDirection     = kSweepUp;
+    fAutoRange     = false;
+    fNoiseTarget   = kNoiseTarget;
+    fRange         = kNoRange;
+    fRate          = kNoRange;
+    fRefV          = 0.0;
+    fRefEvery      = 0;
+    fRefInterval   = 0.0;
+    fDriftCorrect  = 0;
+
     SET_DEBUG_STACK;
 }
+
 /**
  ******************************************************************
  *
- * Function Name : OpenKeithley196
+ * Function Name : Instruments destructor
  *
- * Description : Open the multimeter in this case straight out 
- *               of the box setup to measure voltage. 
+ * Description : Clean up the instruments
  *
  * Inputs : NONE
  *
@@ -175,33 +224,47 @@ void Instruments::Reset(void)
  *
  *******************************************************************
  */
-bool Instruments::OpenKeithley196(uint8_t address)
+Instruments::~Instruments (void)
 {
+    delete fBackend;
     SET_DEBUG_STACK;
-    CLogger *LogPtr = CLogger::GetThis();
-    int verbose     = LogPtr->GetVerbose();
-    hgpib196        = new Keithley196( address, verbose);
-    if (hgpib196->CheckError())
-    {
-	LogPtr->Log("# Error opening device. perhaps wrong GPIB address.\n");
-	delete hgpib196;
-	hgpib196 = NULL;
-	SET_DEBUG_STACK;    
-	return false;
-    }
-    LogPtr->Log("# Keithley 196 open at address %d\n", address);
-    SET_DEBUG_STACK;
-    return true;
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : Record
+ *
+ * Description : Put a recorder in front of the backend. 
+ *
+ * Inputs : File - trace file
+ *
+ * Returns : true if the trace is being written
+ *
+ * Error Conditions : file could not be opened
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Instruments::Record(const char *File)
+{
+    SET_DEBUG_STACK;
+    TraceRecorder *rec = new TraceRecorder(fBackend, File);
 
+    fBackend = rec;
+    return !rec->Error();
+}
 /**
  ******************************************************************
  *
- * Function Name : OpenKeithley230
+ * Function Name : Reset
  *
- * Description : open up the Keithley230 Voltage source
+ * Description : Reset all state machine pointers etc. 
  *
- * Inputs : address - gpib address to use. 
+ * Inputs : NONE
  *
  * Returns : NONE
  *
@@ -214,23 +277,42 @@ bool Instruments::OpenKeithley196(uint8_t address)
  *
  *******************************************************************
  */
-bool Instruments::OpenKeithley230(uint8_t address)
+void Instruments::Reset(void)
 {
     SET_DEBUG_STACK;
-    CLogger *LogPtr = CLogger::GetThis();
-    int verbose     = LogPtr->GetVerbose();
-    hgpib230        = new Keithley2x0( address, 'V', verbose);
-    if (hgpib230->CheckError())
-    {
-	LogPtr->Log("# Error opening 230. perhaps wrong GPIB address.%d \n", 1);
-	delete hgpib230;
-	hgpib230 = NULL;
-	SET_DEBUG_STACK;    
-	return false;
-    }
-    LogPtr->Log("# Keithley 230 open at address: %d\n", address);
+    fStepNumber  = 0;
+    fSetVoltage  = fStartVoltage;
+    fVoltage     = 0.0;
+    fResult      = 0.0;
+    fCurrentStep = fStep;
+    fStepType    = 0;
+    fStdDev      = 0.0;
+    fNSamples    = 0;
+    fTimeStamp   = 0.0;
+    fPointType   = 0;
+    fPlateauCount = 0;
+    fLastResult   = 0.0;
+    fInCompliance = false;
+    fComplianceV  = NAN;
+    fEnded        = false;
+    fUpV.clear();
+    fUpType.clear();
+    fUpI.clear();
+    fUpDone       = false;
+    fDownLeft     = 0;
+    fDownIndex    = 0;
+    fBranch       = 0;
+    fPairIndex    = 0;
+    fNUp          = 0;
+    fLastUp       = 0.0;
+    fPrevUp       = 0.0;
+    fOverRanges   = 0;
+    fRefOwed      = false;
+    fSinceRef     = 0;
+    fRefStamp     = 0.0;
+    fNRef         = 0;
+    fLastRef      = 0.0;
     SET_DEBUG_STACK;
-    return true;
 }
 /**
  ******************************************************************
@@ -260,7 +342,7 @@ bool Instruments::Setup(bool Current)
     SET_DEBUG_STACK;
     CLogger *LogPtr = CLogger::GetThis();
 
-    if((hgpib196 == NULL) || (hgpib230 == NULL))
+    if(!SystemOn())
     {
 	LogPtr->Log("# Setup: Units are not open.\n");
 	return false;
@@ -271,27 +353,53 @@ bool Instruments::Setup(bool Current)
     if (Current)
     {
 	LogPtr->Log("# Read Keithley 196 DMM. Set to read DCA\n");
-	hgpib196->SetFunction(Keithley196::DCA);
+	fBackend->MeterFunction(true);
     }
     else
     {
 	LogPtr->Log("# Read Keithley 196 DMM. Set to read DCV\n");
-	hgpib196->SetFunction(Keithley196::DCV);
+	fBackend->MeterFunction(false);
+    }
+    fMeasureCurrent = Current;
+    // The function changed, nothing is locked on it yet.
+    fRange = kNoRange;
+    fRate  = kNoRange;
+    if (fAutoRange)
+    {
+	// The rate is left as it is, autorange is there to be fast.
+	fBackend->MeterRange(0);
+    }
+    else
+    {
+	LogPtr->Log("# 196DMM range locked per point, resolution %g\n",
+		    fNoiseTarget);
+    }
+    if (fPulsed)
+    {
+	// One conversion per X, fPulseDelay after it.
+	LogPtr->Log("# 196DMM one shot, %g s into the pulse.\n", fPulseDelay);
+	fBackend->MeterTrigger(true, fPulseDelay);
     }
-    LogPtr->Log("# 196DMM Initial read: %g status: %d Prefix: %s\n",
-		 hgpib196->GetData(), hgpib196->ReadStatus(), 
-		 hgpib196->Prefix());
+    else
+    {
+	fBackend->MeterTrigger(false, 0.0);
+    }
+    LogPtr->Log("# 196DMM Initial read: %g status: %d\n",
+		 fBackend->MeterRead(), fBackend->MeterStatus());
 
     // Setup 230 voltage source. 
     LogPtr->Log("# SETUP Keithley 230 voltage source. \n");
-    hgpib230->SetUnitType(Keithley::VoltageSource);
-    hgpib230->Operate();
-    // Set the current limit
-    hgpib230->SetCurrent(kCurrentLimit);
-    hgpib230->DisplaySource();
+    // Set the current limit, the one compliance is judged against.
+    fBackend->SourceOperate(fMaxI);
 
     LogPtr->Log("# Start: %f, Stop: %f, Step: %f, Fine: %f\n", 
 		fStartVoltage, fStopVoltage, fStep, fFine);
+    if (fPulsed)
+    {
+	LogPtr->Log("# Pulsed: %g s on, %g s at %g V, duty %.1f%%\n",
+		    fPulseWidth, fPulseOff, fPulseBase, 
+		    100.0*fPulseWidth/(fPulseWidth + fPulseOff));
+    }
     SET_DEBUG_STACK;
     return true;   
 }
@@ -301,7 +409,8 @@ bool Instruments::Setup(bool Current)
  * Function Name : MeasureAndAverage
  *
  * Description : Measure the result multiple times and return the
- *               Average. 
+ *               Average. The spread of the readings is kept, 
+ *               accumulated with Welford's method.
  *
  * Inputs : NONE
  *
@@ -318,17 +427,575 @@ bool Instruments::Setup(bool Current)
  */
 double Instruments::MeasureAndAverage(uint32_t navg)
 {
-    double AVG  = (double) navg;
-    const struct timespec sleeptime = {0L, 100000000};
+    double Mean = 0.0;
+    double M2   = 0.0;
+    double x, d;
 
-    double Result = 0.0;
+    if (navg == 0) navg = 1;
+    fTimeStamp = fBackend->Now();
 
     for (uint32_t i=0;i<navg;i++)
     {
-	Result += hgpib196->GetData();
-	nanosleep(&sleeptime, NULL);
+	x     = fBackend->MeterRead();
+	d     = x - Mean;
+	Mean += d/(i+1);
+	M2   += d*(x - Mean);
+	fBackend->Wait(kSample);
     }
-    return Result/AVG;
+    fNSamples = navg;
+    fStdDev   = (navg > 1) ? sqrt(M2/(navg - 1)) : 0.0;
+    return Mean;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PulseAndMeasure
+ *
+ * Description : Pulsed reading. The 230 is given a two location
+ *               program, the pulse voltage for fPulseWidth then the
+ *               base for fPulseOff, run once per trigger. The 196 is
+ *               one shot on X with fPulseDelay set at Setup, so the
+ *               read that triggers it right after the 230 is started
+ *               converts inside the pulse. The GPIB turn around is a
+ *               few ms, keep the delay well inside the width.
+ *
+ *               Each reading waits out the whole pulse and cool 
+ *               down before the next, the mean power in the part is
+ *               the duty cycle times the DC power.
+ *
+ * Inputs : V    - pulse voltage
+ *          navg - pulses to average
+ *
+ * Returns : Average result
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::PulseAndMeasure(double V, uint32_t navg)
+{
+    double Mean = 0.0;
+    double M2   = 0.0;
+    double x, d, start;
+
+    if (navg == 0) navg = 1;
+    /*
+     * Location 0 is the pulse, 1 the base the source rests at after
+     * the program ends. 
+     */
+    fBackend->SourceProgram(V, fPulseBase, fMaxI, fPulseWidth, fPulseOff);
+
+    fTimeStamp = fBackend->Now();
+
+    for (uint32_t i=0;i<navg;i++)
+    {
+	start = fBackend->Elapsed();
+	fBackend->SourceExecute();
+	x     = fBackend->MeterRead();
+	d     = x - Mean;
+	Mean += d/(i+1);
+	M2   += d*(x - Mean);
+
+	// Out of the pulse and through the cool down.
+	fBackend->Wait(fPulseWidth + fPulseOff - (fBackend->Elapsed() - start));
+    }
+    fNSamples = navg;
+    fStdDev   = (navg > 1) ? sqrt(M2/(navg - 1)) : 0.0;
+    return Mean;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Acquire
+ *
+ * Description : Lock the 196 for the reading expected, set the
+ *               voltage and read. An over range reading is taken
+ *               again a range up. A reading so far below what was
+ *               expected that the range and rate used do not
+ *               resolve it to the noise target is taken again on
+ *               the range that suits it, which is what happens on
+ *               the first point and after a compliance skip.
+ *
+ * Inputs : V        - voltage
+ *          Expected - magnitude of the reading expected
+ *
+ * Returns : Average result
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::Acquire(double V, double Expected)
+{
+    CLogger *LogPtr = CLogger::GetThis();
+    uint8_t Range, Rate, UsedRange, UsedRate;
+    double  x;
+
+    if (fAutoRange)
+    {
+	return SetAndRead(V);
+    }
+    ChooseRange(Expected, Range, Rate);
+    LockRange(Range, Rate, V);
+    x = SetAndRead(V);
+    while ((fabs(x) > kOverRange*FullScale(fRange)) && 
+	   (fRange+1 < NRanges()))
+    {
+	fOverRanges++;
+	LogPtr->Log("# 196DMM over range at %g V\n", V);
+	ChooseRange(kRangeFill*FullScale(fRange+1), Range, Rate);
+	LockRange(Range, Rate, V);
+	x = SetAndRead(V);
+    }
+    UsedRange = fRange;
+    UsedRate  = fRate;
+    ChooseRange(fabs(x), Range, Rate);
+    if (((Range != UsedRange) || (Rate != UsedRate)) &&
+	(FullScale(UsedRange)/kRateCounts[UsedRate] > 
+	 fNoiseTarget*fabs(x)))
+    {
+	LockRange(Range, Rate, V);
+	x = SetAndRead(V);
+    }
+    return x;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SetAndRead
+ *
+ * Description : Set the voltage and read, with the settle time for
+ *               DC or through a pulse.
+ *
+ * Inputs : V - voltage
+ *
+ * Returns : Average result
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::SetAndRead(double V)
+{
+    if (fPulsed)
+    {
+	return PulseAndMeasure(V, fNAVG);
+    }
+    fBackend->SourceVoltage(V);
+    // Settle time, sleep between set and read.
+    fBackend->Wait(fSettle);
+    // Read back value. 
+    //fResult = hgpib196->GetData();
+    return MeasureAndAverage(fNAVG);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ExpectedReading
+ *
+ * Description : Guess the next up reading. Reading voltage, it is
+ *               the voltage set. Reading current, nothing is known
+ *               before the first point so the limit is taken, after
+ *               that the last reading grown by the ratio of the last
+ *               two. A diode in forward bias grows by about the same
+ *               factor every step. Falling currents are not 
+ *               extrapolated, the range comes down a point late 
+ *               rather than over range.
+ *
+ * Inputs : V - voltage about to be set
+ *
+ * Returns : expected magnitude
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::ExpectedReading(double V) const
+{
+    double growth;
+
+    if (!fMeasureCurrent)
+    {
+	return fmax(fabs(V), fabs(fLastUp));
+    }
+    if (fNUp == 0)
+    {
+	return fMaxI;
+    }
+    growth = 1.0;
+    if ((fNUp > 1) && (fPrevUp != 0.0))
+    {
+	growth = fmin(fmax(fabs(fLastUp/fPrevUp), 1.0), kMaxGrowth);
+    }
+    return (fMaxI > 0.0) ? fmin(growth*fabs(fLastUp), fMaxI) : 
+	growth*fabs(fLastUp);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ChooseRange
+ *
+ * Description : Lowest range that holds the reading with some room,
+ *               then the fewest digits whose resolution on that
+ *               range is within the noise target of the reading. 
+ *               Pulsed, the integration has to fit in what is left
+ *               of the pulse after the delay.
+ *
+ * Inputs : Expected - magnitude of the reading
+ *          Range    - range index, filled
+ *          Rate     - rate index, filled
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Instruments::ChooseRange(double Expected, uint8_t &Range, 
+			      uint8_t &Rate) const
+{
+    Expected = fabs(Expected);
+    Range    = 0;
+    while ((Range+1 < NRanges()) && (Expected > kRangeFill*FullScale(Range)))
+    {
+	Range++;
+    }
+    Rate = 0;
+    while ((Rate+1 < kNRates) && 
+	   (FullScale(Range)/kRateCounts[Rate] > fNoiseTarget*Expected))
+    {
+	if (fPulsed && (kRateTime[Rate+1] > fPulseWidth - fPulseDelay))
+	{
+	    break;
+	}
+	Rate++;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : LockRange
+ *
+ * Description : Program the 196 range and rate, only when they 
+ *               change so a region of the sweep on one range costs
+ *               no GPIB traffic. Each change is logged, the log 
+ *               shows where the regions fall.
+ *
+ * Inputs : Range - range index, 0 the lowest
+ *          Rate  - rate index, 0 for 3.5 digits
+ *          V     - voltage, for the log
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Instruments::LockRange(uint8_t Range, uint8_t Rate, double V)
+{
+    CLogger *LogPtr = CLogger::GetThis();
+
+    if ((Range == fRange) && (Rate == fRate))
+    {
+	return;
+    }
+    if (Range != fRange)
+    {
+	// R0 is autorange, R1 the lowest.
+	fBackend->MeterRange(Range+1);
+    }
+    if (Rate != fRate)
+    {
+	fBackend->MeterRate(Rate);
+    }
+    fRange = Range;
+    fRate  = Rate;
+    LogPtr->Log("# 196DMM at %g V: range %g, %d.5 digits\n", 
+		V, FullScale(Range), Rate+3);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : FullScale
+ *
+ * Description : Full scale of a 196 range on the function set up.
+ *
+ * Inputs : Range - range index, 0 the lowest
+ *
+ * Returns : full scale, amps or volts. The top range past the end.
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::FullScale(uint8_t Range) const
+{
+    if (Range >= NRanges()) Range = NRanges() - 1;
+    return fMeasureCurrent ? kDCARange[Range] : kDCVRange[Range];
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NRanges
+ *
+ * Description : Number of 196 ranges on the function set up.
+ *
+ * Inputs : NONE
+ *
+ * Returns : ranges
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint8_t Instruments::NRanges(void) const
+{
+    return fMeasureCurrent ? kNDCARange : kNDCVRange;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NextStep
+ *
+ * Description : Pick the size of the next step. Near zero, or any
+ *               other value for that matter, step fine. Inside the
+ *               fine band step fine too, a coarse step that would
+ *               go into the band is cut short to land on its start.
+ *
+ * Inputs : V    - voltage just set
+ *          Last - last step
+ *          Type - step type, updated
+ *
+ * Returns : next step
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::NextStep(double V, double Last, uint8_t &Type) const
+{
+    if (fFINE_ONLY)
+    {
+	return fFine;
+    }
+    if (fBandTo > fBandFrom)
+    {
+	if ((V >= fBandFrom - 1.0e-9) && (V < fBandTo))
+	{
+	    Type = 1;
+	    return fFine;
+	}
+	if ((V < fBandFrom) && (V + fStep > fBandFrom + 1.0e-9))
+	{
+	    Type = 0;
+	    return fBandFrom - V;
+	}
+    }
+    if (fabs(V+Last)>=fWindow)
+    {
+	// Outside the window, or just crossed out of it.
+	Type = 0;
+	return fStep;
+    }
+    Type = 1;
+    return fFine;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeasureSettle
+ *
+ * Description : Step the source and watch the reading come in. The
+ *               final value and its spread are taken over the last
+ *               quarter of the readings. The settle time is that of
+ *               the first reading after the last one out of the 
+ *               band round the final value. Readings closer than
+ *               the integration time are not possible, the answer
+ *               is good to about one conversion.
+ *
+ * Inputs : From, To  - step
+ *          Expected  - reading at To, sets the range
+ *          Tolerance - fraction of the final value
+ *          MaxTime   - longest to watch
+ *
+ * Returns : settle time, s
+ *
+ * Error Conditions : NaN if the instruments are not open
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double Instruments::MeasureSettle(double From, double To, double Expected,
+				  double Tolerance, double MaxTime)
+{
+    SET_DEBUG_STACK;
+    CLogger *LogPtr = CLogger::GetThis();
+    std::vector<double> t, x;
+    double   Mean, M2, d, band, dt, start;
+    uint8_t  Range, Rate;
+    uint32_t i, n, q, last;
+
+    if(!SystemOn())
+    {
+	LogPtr->Log("# Setup: Units are not open.\n");
+	return NAN;
+    }
+    if (!fAutoRange)
+    {
+	ChooseRange(Expected, Range, Rate);
+	LockRange(Range, Rate, To);
+    }
+    fBackend->SourceVoltage(From);
+    fBackend->Wait(fSettle);
+
+    fBackend->SourceVoltage(To);
+    start = fBackend->Elapsed();
+    do
+    {
+	x.push_back(fBackend->MeterRead());
+	dt = fBackend->Elapsed() - start;
+	t.push_back(dt);
+    } while ((dt < MaxTime) && (x.size() < kMaxSettleReadings));
+
+    // Final value from the last quarter.
+    n    = x.size();
+    q    = (n > 4) ? n - n/4 : 0;
+    Mean = M2 = 0.0;
+    for (i=q; i<n; i++)
+    {
+	d     = x[i] - Mean;
+	Mean += d/(i - q + 1);
+	M2   += d*(x[i] - Mean);
+    }
+    band = fmax(Tolerance*fabs(Mean), 
+		(n - q > 1) ? 3.0*sqrt(M2/(n - q - 1)) : 0.0);
+    last = n;
+    for (i=0; i<n; i++)
+    {
+	if (fabs(x[i] - Mean) > band) last = i;
+    }
+    if (last == n)
+    {
+	// In the band from the first reading.
+	dt = t[0];
+    }
+    else if (last+1 >= q)
+    {
+	LogPtr->Log("# Settle from %g to %g V not seen in %g s\n", 
+		    From, To, MaxTime);
+	dt = MaxTime;
+    }
+    else
+    {
+	dt = t[last+1];
+    }
+    LogPtr->Log("# Settle from %g to %g V: %g s, %d readings, final %g\n",
+		From, To, dt, (int) n, Mean);
+    SET_DEBUG_STACK;
+    return dt;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : PlanPoints
+ *
+ * Description : Walk the sweep without the instruments and count
+ *               the points. The sweep stops on the first point 
+ *               beyond the stop voltage, that point is taken too.
+ *
+ * Inputs : NONE
+ *
+ * Returns : number of points, 0 if it never ends.
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t Instruments::PlanPoints(void) const
+{
+    double   V    = fStartVoltage;
+    double   Last = fStep;
+    double   used;
+    uint8_t  Type = 0;
+    uint32_t n    = 0;
+
+    while (n < kMaxPlanPoints)
+    {
+	n++;
+	used  = V;
+	Last  = NextStep(V, Last, Type);
+	if (Last <= 0.0) return 0;
+	V    += Last;
+	if (fabs(V)<1.0e-6) V = 0.0;
+	if (used > fStopVoltage) break;
+    }
+    if (n >= kMaxPlanPoints) return 0;
+    // Every voltage but the last again on the way down.
+    if (fDirection != kSweepUp) n = 2*n - 1;
+    // References at the ends and on the way, by time a guess.
+    if (fRefEvery > 0)
+    {
+	n += 1 + (n + fRefEvery - 1)/fRefEvery;
+    }
+    else if (DriftTracking())
+    {
+	n += 2;
+    }
+    return n;
 }
 /**
  ******************************************************************
@@ -355,71 +1022,243 @@ bool Instruments::StepAndAcquire(void)
 {
     SET_DEBUG_STACK;
     double StepSize = 0.0; 
-    /* Sleep between set and read. */
-    const struct timespec sleeptime = {0L, 250000000};
     //const struct timespec slough    = {1L, 000000000};
     CLogger *LogPtr = CLogger::GetThis();
     //int verbose = LogPtr->GetVerbose();
 
-    if((hgpib196 == NULL) || (hgpib230 == NULL))
+    if(!SystemOn())
     {
 	LogPtr->Log("# Setup: Units are not open.\n");
 	return false;
     }
     fStepNumber++;
-    hgpib230->SetVoltage(fSetVoltage);
-    fVoltage = fSetVoltage;
-    // Settle time
-    nanosleep(&sleeptime, NULL);
-    // Read back value. 
-    //fResult = hgpib196->GetData();
-    fResult = MeasureAndAverage(fNAVG);
-    LogPtr->Log("%g, %g\n", fVoltage, fResult);
-    if (fFINE_ONLY)
+    if (RefDue())
     {
-	StepSize = fFine;
+	// Back to the reference to see how far things have moved.
+	fBranch    = 2;
+	fPairIndex = fNRef;
+	fVoltage   = fRefV;
+	fResult    = Acquire(fRefV, (fNRef > 0) ? fabs(fLastRef) : 
+			     ExpectedReading(fRefV));
+	fPointType = 0;
+	fLastRef   = fResult;
+	fRefStamp  = fTimeStamp;
+	fRefOwed   = false;
+	fSinceRef  = 0;
+	fNRef++;
+	LogPtr->Log("# Drift reference %d at %g V: %g\n", fNRef, fVoltage,
+		    fResult);
+	SET_DEBUG_STACK;
+	return true;
     }
-    else
+    fSinceRef++;
+    fRefOwed = true;
+    if (fDownLeft > 0)
     {
-	/**
-	 * Step to next value. 
-	 * near zero or any other value for that matter step fine. 
-	 */
-	switch(fStepType)
-	{
-	case 0: /* coarse */
-	    if (fabs(fSetVoltage+fCurrentStep)>=fWindow)
-	    {
-		StepSize = fStep;
-	    }
-	    else
-	    {
-		fStepType = 1;
-		StepSize = fFine;
-	    }
-	    break;
-	case 1:
-	    if (fabs(fSetVoltage+fCurrentStep)>=fWindow)
-	    {
-		// Crossed the threshold
-		fStepType = 0;
-		StepSize = fStep;
-	    }
-	    else
-	    {
-		StepSize = fFine;
-	    }
-	    break;
-	}
+	// Coming down, a voltage already taken on the way up.
+	fBranch    = 1;
+	fPairIndex = fDownIndex;
+	fVoltage   = fUpV[fDownIndex];
+	fResult    = Acquire(fVoltage, fUpI[fDownIndex]);
+	fPointType = fUpType[fDownIndex];
+	fDownLeft--;
+	if (fDownIndex > 0) fDownIndex--;
+	LogPtr->Log("%g, %g\n", fVoltage, fResult);
+	SET_DEBUG_STACK;
+	return true;
     }
+    fBranch  = 0;
+    fVoltage = fSetVoltage;
+    fResult  = Acquire(fSetVoltage, ExpectedReading(fSetVoltage));
+    fPrevUp  = fLastUp;
+    fLastUp  = fResult;
+    fNUp++;
+    fPointType = fFINE_ONLY ? 1 : fStepType;
+    LogPtr->Log("%g, %g\n", fVoltage, fResult);
+    // Step to next value. 
+    StepSize = NextStep(fSetVoltage, fCurrentStep, fStepType);
     // This is now set to the next requested voltage.
     fCurrentStep = StepSize;
     fSetVoltage += StepSize;
     // Do a little rounding
     if (fabs(fSetVoltage)<1.0e-6) fSetVoltage = 0.0;
+    CheckCompliance();
+
+    fPairIndex = fUpV.size();
+    fUpDone    = fEnded || (fVoltage > fStopVoltage);
+    if (fDirection != kSweepUp)
+    {
+	fUpV.push_back(fVoltage);
+	fUpType.push_back(fPointType);
+	fUpI.push_back(fResult);
+	if ((fDirection == kSweepUpDown) && fUpDone && (fUpV.size() > 1))
+	{
+	    // Turn around, back down to the start.
+	    fDownLeft  = fUpV.size() - 1;
+	    fDownIndex = fUpV.size() - 2;
+	}
+	else if ((fDirection == kSweepInterleaved) && (fUpV.size() > 1))
+	{
+	    // The point before this one, now from above.
+	    fDownLeft  = 1;
+	    fDownIndex = fUpV.size() - 2;
+	}
+    }
     SET_DEBUG_STACK;
     return true;
 }
+/**
+ ******************************************************************
+ *
+ * Function Name : RefDue
+ *
+ * Description : A drift reference is due before the first point,
+ *               once Every points or Interval seconds have gone by
+ *               since the last one and after the last point.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true if the next point should be a reference.
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Instruments::RefDue(void) const
+{
+    if (!DriftTracking()) return false;
+    if (fNRef == 0)       return true;
+    if (!fRefOwed)        return false;
+    if (fUpDone && (fDownLeft == 0)) return true;
+    if ((fRefEvery > 0) && (fSinceRef >= fRefEvery)) return true;
+    return ((fRefInterval > 0.0) && 
+	    (fTimeStamp - fRefStamp >= fRefInterval));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CheckCompliance
+ *
+ * Description : Is the last reading in compliance, and if so what
+ *               now. Once the source holds its limit every further
+ *               point reads the limit, so there is no sense 
+ *               averaging them at the full step density.
+ *
+ *               At the limit   - |I| >= 98% of the programmed limit.
+ *                                The 230 driver has no compliance 
+ *                                status to read back, the limit 
+ *                                itself is the test.
+ *               Plateau        - the reading flat for PlateauPoints
+ *                                steps with |I| past half the limit.
+ *
+ *               Reading voltage the 196 has the DUT voltage, I is
+ *               the set voltage over the sense resistor, the current
+ *               the plot has on its x axis. Held at the limit the
+ *               DUT voltage goes flat. With no resistor, V:V, there
+ *               is no current to go by and nothing is taken as 
+ *               compliance: a diode's forward voltage is flat and 
+ *               short of the set voltage too.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Instruments::CheckCompliance(void)
+{
+    SET_DEBUG_STACK;
+    CLogger *LogPtr = CLogger::GetThis();
+    double  target, I;
+    bool    Limited, AtLimit, Near, Was = fInCompliance;
+
+    Limited = (fMaxI > 0.0) && (fMeasureCurrent || (fSenseR > 0.0));
+    I       = fMeasureCurrent ? fResult : 
+	((fSenseR > 0.0) ? fVoltage/fSenseR : 0.0);
+    AtLimit = Limited && (fabs(I) >= kAtLimit*fMaxI);
+    Near    = Limited && (fabs(I) >= kPlateauFloor*fMaxI);
+    if ((fStepNumber > 1) && Near && 
+	(fabs(fResult - fLastResult) <= fPlateauTol*fabs(fResult)))
+    {
+	fPlateauCount++;
+    }
+    else
+    {
+	fPlateauCount = 0;
+    }
+    fLastResult   = fResult;
+    fInCompliance = AtLimit || 
+	((fPlateauPoints > 0) && (fPlateauCount >= fPlateauPoints));
+    if (!fInCompliance)
+    {
+	return;
+    }
+    if (std::isnan(fComplianceV))
+    {
+	fComplianceV = fVoltage;
+    }
+    if (!Was)
+    {
+	LogPtr->Log("# Compliance at %g V, reading %g%s, policy %d\n", 
+		    fVoltage, fResult, AtLimit ? " at the limit" : " flat",
+		    (int) fPolicy);
+    }
+
+    switch (fPolicy)
+    {
+    case kComplianceEnd:
+	fEnded = true;
+	break;
+    case kComplianceSkip:
+	/*
+	 * Reverse breakdown, pick up again where the fine steps 
+	 * start, or at zero. Forward, there is nothing more to see.
+	 */
+	target = (fFINE_ONLY || (fWindow <= 0.0)) ? 0.0 : -fWindow;
+	if ((fVoltage < 0.0) && (target > fSetVoltage))
+	{
+	    LogPtr->Log("# Compliance skip from %g to %g V\n", 
+			fVoltage, target);
+	    fSetVoltage   = target;
+	    fCurrentStep  = fFine;
+	    fStepType     = fFINE_ONLY ? 1 : 0;
+	    fPlateauCount = 0;
+	}
+	else if (fVoltage >= 0.0)
+	{
+	    fEnded = true;
+	}
+	break;
+    case kComplianceCoarse:
+	// Never past where the normal walk would end.
+	if (fVoltage + kComplianceStride*fCurrentStep <= fStopVoltage)
+	{
+	    fCurrentStep *= kComplianceStride;
+	    fSetVoltage   = fVoltage + fCurrentStep;
+	    if (fabs(fSetVoltage)<1.0e-6) fSetVoltage = 0.0;
+	}
+	break;
+    default:
+	break;
+    }
+    if (fEnded)
+    {
+	LogPtr->Log("# Compliance, sweep ended at %g V\n", fVoltage);
+    }
+    SET_DEBUG_STACK;
+}
 /**
  ******************************************************************
  *
@@ -443,7 +1282,7 @@ bool Instruments::StepAndAcquire(void)
 uint8_t Instruments::MultimeterAddress(void) const 
 {
     SET_DEBUG_STACK;
-    return hgpib196->Address();
+    return fBackend->MeterAddress();
 }
 /**
  ******************************************************************
@@ -468,7 +1307,7 @@ uint8_t Instruments::MultimeterAddress(void) const
 uint8_t Instruments::VoltageSourceAddress(void) const 
 {
     SET_DEBUG_STACK;
-    return hgpib230->Address();
+    return fBackend->SourceAddress();
 }
 /**
  ******************************************************************
@@ -496,6 +1335,6 @@ void Instruments::SetCurrentLimit(double val)
     CLogger *LogPtr = CLogger::GetThis();
     LogPtr->Log("# Setting current limit to: %g\n", val);
     fMaxI = val;
-    hgpib230->SetCurrent(val);
+    fBackend->SourceLimit(val);
     SET_DEBUG_STACK;
 }
@@ -20,13 +20,37 @@
 #ifndef __INSTRUMENTS_hh_
 #define __INSTRUMENTS_hh_
 #include <stdint.h>
-
-class    Keithley196;
-class    Keithley2x0;
+#include <vector>
+#include "GpibBackend.hh"
 
 /// Instruments documentation here. 
 class Instruments {
 public:
+    /*!
+     * What to do once the source is in compliance.
+     *   Continue - keep stepping as before, the points are flagged
+     *   End      - stop the sweep
+     *   Skip     - in reverse bias jump ahead to the forward region,
+     *              in forward bias stop
+     *   Coarse   - keep going at kComplianceStride times the step
+     *              until the source comes out of compliance
+     */
+    enum CompliancePolicy {kComplianceContinue=0, kComplianceEnd,
+			   kComplianceSkip, kComplianceCoarse};
+
+    /*!
+     * Sweep direction.
+     *   Up          - Start to Stop
+     *   UpDown      - Start to Stop and back to Start
+     *   Interleaved - after each point on the way up, the one before
+     *                 it again coming down, so both branches are
+     *                 taken close together in time and drift hits
+     *                 them alike
+     * The down branch revisits exactly the voltages taken on the way
+     * up, the same instrument set up serves both. A compliance End
+     * in UpDown turns the sweep around rather than ending it.
+     */
+    enum SweepDirection {kSweepUp=0, kSweepUpDown, kSweepInterleaved};
 
     /*!
      * Description: 
@@ -44,6 +68,21 @@ public:
      */
     Instruments(uint8_t Keithley196_Address, uint8_t Keithley230_Address);
 
+    /*!
+     * Description: 
+     *    Run on another backend, a trace replay or a simulation.
+     *
+     * Arguments:
+     *   Backend - owned by the instruments from here on
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   If either instrument is not there, check Error() method. 
+     */
+    Instruments(GpibBackend *Backend);
+
     /*!
      * Description: 
      *   
@@ -85,7 +124,49 @@ public:
      * Errors:
      *
      */
-    inline bool Done(void) const{ return (fVoltage> fStopVoltage);};
+    inline bool Done(void) const
+	{ return (fUpDone && (fDownLeft == 0) && 
+		  !(DriftTracking() && fRefOwed));};
+
+    /*!
+     * Description: 
+     *   Number of points the sweep will take with the present start,
+     *   stop, step, fine step, window and direction. Used to size the
+     *   sample store before the start.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   points in the sweep, 0 if the steps would never reach stop.
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t PlanPoints(void) const;
+
+    /*!
+     * Description: 
+     *   Measure how long the reading takes to settle after a step.
+     *   The source is held at From for the settle time, stepped to
+     *   To and the 196 read as fast as it goes until MaxTime.
+     *
+     * Arguments:
+     *   From, To  - step, volts
+     *   Expected  - magnitude of the reading at To, for the range
+     *   Tolerance - settled within this fraction of the final value,
+     *               or three times the spread there if that is more
+     *   MaxTime   - longest to watch, s
+     *
+     * Returns:
+     *   seconds from the step to the first reading after which they
+     *   all stay settled. MaxTime if the readings never settled.
+     *
+     * Errors:
+     *   NaN if the instruments are not open.
+     */
+    double MeasureSettle(double From, double To, double Expected,
+			 double Tolerance = 1.0e-3, double MaxTime = 2.0);
 
     /* *****************************************************
      * Inline functions
@@ -103,7 +184,7 @@ public:
      * Errors:
      *
      */
-    inline bool Keithley196_OK(void) const {return (hgpib196!=NULL);};
+    inline bool Keithley196_OK(void) const {return fBackend->MeterOK();};
 
     /*!
      * Description: 
@@ -117,10 +198,27 @@ public:
      * Errors:
      *
      */
-    inline bool Keithley230_OK(void) const {return (hgpib230!=NULL);};
+    inline bool Keithley230_OK(void) const {return fBackend->SourceOK();};
 
-    inline bool SystemOn(void) const {return ((hgpib196!=NULL) && 
-					      (hgpib230!=NULL));};
+    inline bool SystemOn(void) const {return (fBackend->MeterOK() && 
+					      fBackend->SourceOK());};
+
+    /*!
+     * Description: 
+     *   Record all GPIB traffic from here on to a trace file that
+     *   TraceReplay can play back.
+     *
+     * Arguments:
+     *   File - trace, overwritten
+     *
+     * Returns:
+     *   true if the trace was opened
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Record(const char *File);
+    inline GpibBackend* Backend(void) {return fBackend;};
 
     void Reset(void);
 
@@ -161,6 +259,29 @@ public:
     void SetCurrentLimit(double val);
     inline double   CurrentLimit(void) const {return fMaxI;};
 
+    /*!
+     * Compliance detection. A point is in compliance if the current
+     * read is at the programmed limit, or if the reading has stayed
+     * flat to PlateauTolerance (relative) for PlateauPoints steps 
+     * while the set voltage kept moving. A plateau only counts near
+     * the limit, so reverse leakage is not mistaken for it. Reading
+     * voltage the current is the set voltage over SenseResistance,
+     * as plotted, with none there is no compliance test.
+     */
+    inline void     Policy(uint8_t p)  {fPolicy = p;};
+    inline uint8_t  Policy(void) const {return fPolicy;};
+    inline void     PlateauPoints(uint32_t n) {fPlateauPoints = n;};
+    inline uint32_t PlateauPoints(void) const {return fPlateauPoints;};
+    inline void     PlateauTolerance(double t) {fPlateauTol = t;};
+    inline double   PlateauTolerance(void) const {return fPlateauTol;};
+    /*! Ohms the set voltage drives the current through, 0 none. */
+    inline void     SenseResistance(double R) {fSenseR = R;};
+    inline double   SenseResistance(void) const {return fSenseR;};
+    /*! Last point was in compliance. */
+    inline bool     InCompliance(void) const {return fInCompliance;};
+    /*! Voltage where compliance was first seen this sweep, NaN if not.*/
+    inline double   ComplianceVoltage(void) const {return fComplianceV;};
+
 
     /*!
      * Description: 
@@ -192,6 +313,84 @@ public:
      */
     inline double   Result(void) const {return fResult;};
 
+    /*!
+     * Statistics of the readings behind the last Result: the
+     * standard deviation, 0 with a single reading, the number of
+     * readings, the time of the first reading (s since the epoch)
+     * and whether the point was on a coarse (0) or fine (1) step.
+     */
+    inline double   StdDev(void)    const {return fStdDev;};
+    inline uint32_t NSamples(void)  const {return fNSamples;};
+    inline double   TimeStamp(void) const {return fTimeStamp;};
+    inline uint8_t  PointType(void) const {return fPointType;};
+
+    /*! Time between setting the voltage and reading, seconds. */
+    inline void     SettleTime(double s) {fSettle = s;};
+    inline double   SettleTime(void) const {return fSettle;};
+
+    /*!
+     * Pulsed mode. Each reading is taken during a pulse of Width
+     * seconds at the step voltage, after which the source drops to
+     * Base for Off seconds to let the part cool. The 230 runs the
+     * pulse from its own two location program so the dwell times
+     * are the instrument's, the 196 is armed one shot with Delay 
+     * into the pulse. Takes effect at the next Setup.
+     */
+    inline void     Pulsed(bool set) {fPulsed = set;};
+    inline bool     Pulsed(void) const {return fPulsed;};
+    inline void     PulseWidth(double s) {fPulseWidth = s;};
+    inline double   PulseWidth(void) const {return fPulseWidth;};
+    inline void     PulseOff(double s) {fPulseOff = s;};
+    inline double   PulseOff(void) const {return fPulseOff;};
+    inline void     PulseBase(double V) {fPulseBase = V;};
+    inline double   PulseBase(void) const {return fPulseBase;};
+    inline void     PulseDelay(double s) {fPulseDelay = s;};
+    inline double   PulseDelay(void) const {return fPulseDelay;};
+    /*! Wait before the reading, the settle time or the pulse delay. */
+    inline double   SampleDelay(void) const 
+	{return fPulsed ? fPulseDelay : fSettle;};
+
+    /*!
+     * Range and rate of the 196. Unless AutoRange is set the range
+     * is locked before each point from the current expected there,
+     * the up reading at that voltage on the way down, otherwise the
+     * last readings going up carried forward. The rate is the fewest
+     * digits that resolve NoiseTarget, relative to the reading, on
+     * that range. Big readings convert fast, only the small ones
+     * integrate longer. A reading over range is taken again one
+     * range up, one far short of what was expected again on the
+     * range that suits it. Takes effect at the next Setup.
+     */
+    inline void     AutoRange(bool set) {fAutoRange = set;};
+    inline bool     AutoRange(void) const {return fAutoRange;};
+    inline void     NoiseTarget(double r) {fNoiseTarget = r;};
+    inline double   NoiseTarget(void) const {return fNoiseTarget;};
+    /*! Readings taken again after an over range this sweep. */
+    inline uint32_t OverRanges(void) const {return fOverRanges;};
+
+    /*!
+     * Drift tracking. The source goes back to the reference voltage
+     * before the first point, after every Every points or Interval
+     * seconds, whichever comes first, and after the last point. A 
+     * reference reading is a point of branch 2 whose pair index
+     * counts the references. Either of Every or Interval at zero 
+     * is not used, both at zero turns tracking off. Correct is 
+     * passed on to the sample store, see SampleStore::Correction.
+     */
+    inline void     DriftReference(double V) {fRefV = V;};
+    inline double   DriftReference(void) const {return fRefV;};
+    inline void     DriftEvery(uint32_t n) {fRefEvery = n;};
+    inline uint32_t DriftEvery(void) const {return fRefEvery;};
+    inline void     DriftInterval(double s) {fRefInterval = s;};
+    inline double   DriftInterval(void) const {return fRefInterval;};
+    inline void     DriftCorrect(uint8_t c) {fDriftCorrect = c;};
+    inline uint8_t  DriftCorrect(void) const {return fDriftCorrect;};
+    inline bool     DriftTracking(void) const 
+	{return (fRefEvery > 0) || (fRefInterval > 0.0);};
+    /*! References taken and the last reading there. */
+    inline uint32_t NReference(void) const {return fNRef;};
+    inline double   LastReference(void) const {return fLastRef;};
+
     inline void     Start(double Volts) {fStartVoltage = Volts;};
     inline double   Start(void) const   {return fStartVoltage;};
     inline void     Stop (double Volts) {fStopVoltage = Volts;};
@@ -202,6 +401,21 @@ public:
     inline double   Fine (void) const   {return fFine;};
     inline void     Window(double volts) {fWindow = volts;};
     inline double   Window(void) const  {return fWindow;};
+    /*! Fine steps from From to To as well, From == To for none. */
+    inline void     FineBand(double From, double To) 
+	{fBandFrom = From; fBandTo = To;};
+    inline double   FineFrom(void) const {return fBandFrom;};
+    inline double   FineTo(void)   const {return fBandTo;};
+
+    inline void     Direction(uint8_t d) {fDirection = d;};
+    inline uint8_t  Direction(void) const {return fDirection;};
+    /*!
+     * Branch of the last point, 0 up 1 down 2 drift reference, and
+     * its index in the voltages taken on the way up. A down point 
+     * has the same index as the up point at that voltage.
+     */
+    inline uint8_t  Branch(void)    const {return fBranch;};
+    inline uint32_t PairIndex(void) const {return fPairIndex;};
 
     inline bool     FineOnly(void) const {return fFINE_ONLY;};
     inline void     FineOnly(bool set) {fFINE_ONLY = set;};
@@ -230,38 +444,152 @@ private:
      * Errors:
      *
      */
-    bool OpenKeithley196(uint8_t address);
+    double MeasureAndAverage(uint32_t navg);
 
     /*!
      * Description: 
-     *   
+     *   Pulse the source navg times at V and read the 196 in each
+     *   pulse. Mean and spread as for MeasureAndAverage.
      *
      * Arguments:
-     *   
+     *   V    - pulse voltage
+     *   navg - pulses
+     *
+     * Returns:
+     *   Average result
+     *
+     * Errors:
+     *   NONE
+     */
+    double PulseAndMeasure(double V, uint32_t navg);
+
+    /*!
+     * Description: 
+     *   Set V and read, DC or pulsed.
+     *
+     * Arguments:
+     *   V - voltage
      *
      * Returns:
+     *   Average result
      *
      * Errors:
+     *   NONE
+     */
+    double Acquire(double V, double Expected);
+
+    /*!
+     * Description: 
+     *   Set V, wait and read, DC or pulsed, on whatever range and
+     *   rate the 196 is on.
      *
+     * Arguments:
+     *   V - voltage
+     *
+     * Returns:
+     *   Average result
+     *
+     * Errors:
+     *   NONE
      */
-    bool OpenKeithley230(uint8_t address);
+    double SetAndRead(double V);
 
     /*!
      * Description: 
-     *   
+     *   What the next up point should read, from the last two.
      *
      * Arguments:
-     *   
+     *   V - voltage about to be set
      *
      * Returns:
+     *   expected magnitude
      *
      * Errors:
+     *   NONE
+     */
+    double ExpectedReading(double V) const;
+
+    /*!
+     * Description: 
+     *   Pick the 196 range and rate for a reading.
+     *
+     * Arguments:
+     *   Expected - magnitude of the reading
+     *   Range    - range index, 0 the lowest
+     *   Rate     - rate index, 0 for 3.5 digits to 3 for 6.5
      *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
      */
-    double MeasureAndAverage(uint32_t navg);
+    void   ChooseRange(double Expected, uint8_t &Range, 
+		       uint8_t &Rate) const;
+
+    /*!
+     * Description: 
+     *   Send the range and rate to the 196 if they changed.
+     *
+     * Arguments:
+     *   Range, Rate - as from ChooseRange
+     *   V           - voltage, for the log
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void   LockRange(uint8_t Range, uint8_t Rate, double V);
+
+    /*! Full scale of a range on the present function. */
+    double FullScale(uint8_t Range) const;
+    /*! Number of ranges on the present function. */
+    uint8_t NRanges(void) const;
+
+    /*!
+     * Description: 
+     *   Size of the step after voltage V, coarse outside the window,
+     *   fine inside it or always fine if FineOnly.
+     *
+     * Arguments:
+     *   V    - voltage just set
+     *   Last - last step taken
+     *   Type - step type, updated
+     *
+     * Returns:
+     *   next step
+     *
+     * Errors:
+     *   NONE
+     */
+    double NextStep(double V, double Last, uint8_t &Type) const;
+
+    /*!
+     * Description: 
+     *   Decide whether the last reading is in compliance and act on
+     *   the policy. Called once the next voltage has been worked 
+     *   out, the policy may move it or end the sweep.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void CheckCompliance(void);
+
+    /*! Is a drift reference reading due before the next point. */
+    bool RefDue(void) const;
+
+    /*! Settings to their defaults and the state reset. */
+    void Init(void);
 
-    Keithley196*  hgpib196;
-    Keithley2x0*  hgpib230;
+    GpibBackend*  fBackend;
 
 
     /* Maintain the current status of the operation */
@@ -273,12 +601,60 @@ private:
     double   fSetVoltage;      /*! next Requested voltage value  */
     double   fVoltage;         /*! Voltage used this time.  */
     double   fWindow;          /*! Window where fine step kicks in. eg fabs(V)<window */
+    double   fBandFrom;        /*! Fine step band, the knee */
+    double   fBandTo;
     double   fMaxI;            /*! Maximum Current from voltage source */
     double   fResult;          /*! Last voltage or current measured    */
     double   fCurrentStep;     /*! checking. */
     uint8_t  fStepType;        /*! 0 - coarse, 1 - fine */
     uint32_t fNAVG;            /*! Number of averages to perform.*/
     bool     fFINE_ONLY;       /*! If true only step fine. */
+    double   fSettle;          /*! Settle time after a step, s. */
+    double   fStdDev;          /*! Spread of the last readings  */
+    uint32_t fNSamples;        /*! Readings in the last result  */
+    double   fTimeStamp;       /*! Time of the last reading     */
+    uint8_t  fPointType;       /*! Step type of the last point  */
+    bool     fMeasureCurrent;  /*! 196 set to DCA                */
+    uint8_t  fPolicy;          /*! CompliancePolicy              */
+    uint32_t fPlateauPoints;   /*! Flat steps that make a plateau*/
+    double   fPlateauTol;      /*! Relative flatness             */
+    double   fSenseR;          /*! Ohms for I = V/R, mode 2     */
+    uint32_t fPlateauCount;    /*! Flat steps so far             */
+    double   fLastResult;      /*! Reading before this one       */
+    bool     fInCompliance;
+    double   fComplianceV;
+    bool     fEnded;           /*! Stopped by the policy         */
+    bool     fPulsed;          /*! Pulsed rather than DC steps   */
+    double   fPulseWidth;      /*! s at the step voltage         */
+    double   fPulseOff;        /*! s at base between pulses      */
+    double   fPulseBase;       /*! V between pulses              */
+    double   fPulseDelay;      /*! s into the pulse to read      */
+    uint8_t  fDirection;       /*! SweepDirection                */
+    std::vector<double>  fUpV;    /*! Voltages taken going up    */
+    std::vector<uint8_t> fUpType; /*! and their step types       */
+    std::vector<double>  fUpI;    /*! and their readings         */
+    bool     fUpDone;          /*! Up branch finished            */
+    uint32_t fDownLeft;        /*! Down points still to take     */
+    uint32_t fDownIndex;       /*! Next down point in fUpV       */
+    uint8_t  fBranch;
+    uint32_t fPairIndex;
+    bool     fAutoRange;       /*! Leave the 196 to autorange    */
+    double   fNoiseTarget;     /*! Resolution relative to reading*/
+    uint8_t  fRange;           /*! Locked range, kNoRange if none*/
+    uint8_t  fRate;            /*! Locked rate                   */
+    uint32_t fNUp;             /*! Up readings so far            */
+    double   fLastUp;          /*! Last up reading               */
+    double   fPrevUp;          /*! and the one before            */
+    uint32_t fOverRanges;
+    double   fRefV;            /*! Drift reference voltage       */
+    uint32_t fRefEvery;        /*! Points between references     */
+    double   fRefInterval;     /*! s between references          */
+    uint8_t  fDriftCorrect;
+    bool     fRefOwed;         /*! Points since the last one     */
+    uint32_t fSinceRef;
+    double   fRefStamp;        /*! Time of the last reference    */
+    uint32_t fNRef;
+    double   fLastRef;         /*! Last reference reading        */
 
     bool     fError;           /*! did an error occur in the last call? */
 
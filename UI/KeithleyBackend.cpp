@@ -0,0 +1,519 @@
+/********************************************************************
+ *
+ * Module Name : KeithleyBackend.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Keithley 196 and 230 through the Keithley library.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+
+// GPIB control.
+#include "Keithley2x0.hh"
+#include "Keithley196.hh"
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "KeithleyBackend.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : KeithleyBackend constructor
+ *
+ * Description : Open up both instruments.
+ *
+ * Inputs : Keithley196_Address - Keithley 196 Multimeter GPIB address
+ *          Keithley230_Address - Keithley 230 Voltage Source GPIB address
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : an instrument that fails to open is left NULL
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+KeithleyBackend::KeithleyBackend(uint8_t Keithley196_Address, 
+				 uint8_t Keithley230_Address)
+{
+    SET_DEBUG_STACK;
+    hgpib196 = NULL;
+    hgpib230 = NULL;
+    if (OpenKeithley196(Keithley196_Address))
+    {
+	OpenKeithley230(Keithley230_Address);
+    }
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : KeithleyBackend destructor
+ *
+ * Description : Close the instruments.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+KeithleyBackend::~KeithleyBackend(void)
+{
+    delete hgpib196;
+    delete hgpib230;
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : OpenKeithley196
+ *
+ * Description : Open the multimeter in this case straight out 
+ *               of the box setup to measure voltage. 
+ *
+ * Inputs : address - gpib address to use.
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool KeithleyBackend::OpenKeithley196(uint8_t address)
+{
+    SET_DEBUG_STACK;
+    CLogger *LogPtr = CLogger::GetThis();
+    int verbose     = LogPtr->GetVerbose();
+    hgpib196        = new Keithley196( address, verbose);
+    if (hgpib196->CheckError())
+    {
+	LogPtr->Log("# Error opening device. perhaps wrong GPIB address.\n");
+	delete hgpib196;
+	hgpib196 = NULL;
+	SET_DEBUG_STACK;    
+	return false;
+    }
+    LogPtr->Log("# Keithley 196 open at address %d\n", address);
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : OpenKeithley230
+ *
+ * Description : open up the Keithley230 Voltage source
+ *
+ * Inputs : address - gpib address to use. 
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool KeithleyBackend::OpenKeithley230(uint8_t address)
+{
+    SET_DEBUG_STACK;
+    CLogger *LogPtr = CLogger::GetThis();
+    int verbose     = LogPtr->GetVerbose();
+    hgpib230        = new Keithley2x0( address, 'V', verbose);
+    if (hgpib230->CheckError())
+    {
+	LogPtr->Log("# Error opening 230. perhaps wrong GPIB address.%d \n", 1);
+	delete hgpib230;
+	hgpib230 = NULL;
+	SET_DEBUG_STACK;    
+	return false;
+    }
+    LogPtr->Log("# Keithley 230 open at address: %d\n", address);
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterAddress
+ *
+ * Description : GPIB address of the 196.
+ *
+ * Inputs : NONE
+ *
+ * Returns : address
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint8_t KeithleyBackend::MeterAddress(void) const
+{
+    return hgpib196->Address();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceAddress
+ *
+ * Description : GPIB address of the 230.
+ *
+ * Inputs : NONE
+ *
+ * Returns : address
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint8_t KeithleyBackend::SourceAddress(void) const
+{
+    return hgpib230->Address();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterFunction
+ *
+ * Description : 196 to DCA or DCV.
+ *
+ * Inputs : Current - DCA if true
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::MeterFunction(bool Current)
+{
+    hgpib196->SetFunction(Current ? Keithley196::DCA : Keithley196::DCV);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterRange
+ *
+ * Description : 196 range, R0 is autorange, R1 the lowest.
+ *
+ * Inputs : Range - range command
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::MeterRange(uint8_t Range)
+{
+    hgpib196->SetRange(Range);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterRate
+ *
+ * Description : 196 integration, as digits.
+ *
+ * Inputs : Rate - 0 for 3.5 digits up to 3 for 6.5
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::MeterRate(uint8_t Rate)
+{
+    switch (Rate)
+    {
+    case 0:
+	hgpib196->SetRate(Keithley196::Digit3_5);
+	break;
+    case 1:
+	hgpib196->SetRate(Keithley196::Digit4_5);
+	break;
+    case 2:
+	hgpib196->SetRate(Keithley196::Digit5_5);
+	break;
+    default:
+	hgpib196->SetRate(Keithley196::Digit6_5);
+	break;
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterTrigger
+ *
+ * Description : 196 trigger, one shot on X with a delay or 
+ *               continuous on talk.
+ *
+ * Inputs : OneShot - one shot on X
+ *          Delay   - s after X to convert
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::MeterTrigger(bool OneShot, double Delay)
+{
+    if (OneShot)
+    {
+	hgpib196->SetTrigger(Keithley196::OneShotOnX);
+	hgpib196->SetDelay((int) (Delay*1000.0 + 0.5));
+    }
+    else
+    {
+	hgpib196->SetTrigger(Keithley196::ContinuousOnTalk);
+	hgpib196->SetDelay(0);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterRead
+ *
+ * Description : One reading from the 196.
+ *
+ * Inputs : NONE
+ *
+ * Returns : reading
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double KeithleyBackend::MeterRead(void)
+{
+    return hgpib196->GetData();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterStatus
+ *
+ * Description : 196 status word.
+ *
+ * Inputs : NONE
+ *
+ * Returns : status
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int KeithleyBackend::MeterStatus(void)
+{
+    return hgpib196->ReadStatus();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceOperate
+ *
+ * Description : 230 as a voltage source, in operate with
+ *               the current limit set.
+ *
+ * Inputs : Limit - amps
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::SourceOperate(double Limit)
+{
+    hgpib230->SetUnitType(Keithley::VoltageSource);
+    hgpib230->Operate();
+    hgpib230->SetCurrent(Limit);
+    hgpib230->DisplaySource();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceLimit
+ *
+ * Description : 230 current limit.
+ *
+ * Inputs : A - amps
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::SourceLimit(double A)
+{
+    hgpib230->SetCurrent(A);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceVoltage
+ *
+ * Description : 230 DC output.
+ *
+ * Inputs : V - volts
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::SourceVoltage(double V)
+{
+    hgpib230->SetVoltage(V);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceProgram
+ *
+ * Description : Two location program on the 230. Location 0 is
+ *               the pulse, 1 the base the source rests at after the
+ *               program ends. Run once per X.
+ *
+ * Inputs : V, Width   - pulse, volts and s
+ *          Base, Off - after it
+ *          Limit     - amps
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::SourceProgram(double V, double Base, double Limit,
+				    double Width, double Off)
+{
+    hgpib230->SetBuffer(0);
+    hgpib230->Set(V,    Limit, Width, 0, 0);
+    hgpib230->Set(Base, Limit, Off,   1, 1);
+    hgpib230->SetBuffer(0);
+    hgpib230->ProgramSingle();
+    hgpib230->SetTrigger(Keithley2x0::StartOnX);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceExecute
+ *
+ * Description : Run the 230 program.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void KeithleyBackend::SourceExecute(void)
+{
+    hgpib230->Execute();
+}
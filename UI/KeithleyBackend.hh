@@ -0,0 +1,76 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : KeithleyBackend.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : The real Keithley 196 and 230 on the GPIB bus,
+ *               through the Keithley library. The only part of the
+ *               program that talks to the drivers.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __KEITHLEYBACKEND_hh_
+#define __KEITHLEYBACKEND_hh_
+#include "GpibBackend.hh"
+
+class    Keithley196;
+class    Keithley2x0;
+
+/// KeithleyBackend documentation here.
+class KeithleyBackend : public GpibBackend {
+public:
+    /*!
+     * Description:
+     *   Open both instruments.
+     *
+     * Arguments:
+     *   Keithley196_Address - Keithley 196 Multimeter GPIB address
+     *   Keithley230_Address - Keithley 230 Voltage Source GPIB address
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   An instrument that does not open is left NULL, see MeterOK
+     *   and SourceOK.
+     */
+    KeithleyBackend(uint8_t Keithley196_Address, uint8_t Keithley230_Address);
+    ~KeithleyBackend(void);
+
+    inline bool MeterOK(void)  const {return (hgpib196!=NULL);};
+    inline bool SourceOK(void) const {return (hgpib230!=NULL);};
+    uint8_t MeterAddress(void)  const;
+    uint8_t SourceAddress(void) const;
+
+    void    MeterFunction(bool Current);
+    void    MeterRange(uint8_t Range);
+    void    MeterRate(uint8_t Rate);
+    void    MeterTrigger(bool OneShot, double Delay);
+    double  MeterRead(void);
+    int     MeterStatus(void);
+
+    void    SourceOperate(double Limit);
+    void    SourceLimit(double A);
+    void    SourceVoltage(double V);
+    void    SourceProgram(double V, double Base, double Limit,
+			  double Width, double Off);
+    void    SourceExecute(void);
+
+private:
+    bool OpenKeithley196(uint8_t address);
+    bool OpenKeithley230(uint8_t address);
+
+    Keithley196*  hgpib196;
+    Keithley2x0*  hgpib230;
+};
+#endif
@@ -0,0 +1,327 @@
+/********************************************************************
+ *
+ * Module Name : MinMaxPyramid.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Min/max level of detail for drawing large data sets.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <algorithm>
+
+// Local Includes.
+#include "debug.h"
+#include "MinMaxPyramid.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : MinMaxPyramid constructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+MinMaxPyramid::MinMaxPyramid(void)
+{
+    SET_DEBUG_STACK;
+    Clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Clear
+ *
+ * Description : Forget everything.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void MinMaxPyramid::Clear(void)
+{
+    SET_DEBUG_STACK;
+    fN      = 0;
+    fSorted = true;
+    fLevel.clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Update
+ *
+ * Description : Fold any new points into the pyramid. Level 0 is
+ *               computed from the points, each level above from
+ *               pairs of buckets of the level below. Only buckets
+ *               from the one holding the first new point onwards
+ *               are recomputed.
+ *
+ * Inputs : x, y - data arrays, double or single precision
+ *          n    - number of points in the arrays
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void MinMaxPyramid::Update(const double *x, const double *y, uint32_t n)
+{
+    DoUpdate(x, y, n);
+}
+void MinMaxPyramid::Update(const float *x, const float *y, uint32_t n)
+{
+    DoUpdate(x, y, n);
+}
+template <class T> 
+void MinMaxPyramid::DoUpdate(const T *x, const T *y, uint32_t n)
+{
+    SET_DEBUG_STACK;
+    uint32_t level, b, first, nb, i, end;
+
+    if (n < fN)
+    {
+	Clear();
+    }
+    if (n == fN)
+    {
+	return;
+    }
+
+    // Keep track of whether we can bisect on x.
+    for (i = (fN>0) ? fN : 1; i<n && fSorted; i++)
+    {
+	if (x[i] < x[i-1]) fSorted = false;
+    }
+
+    level = 0;
+    first = fN;             // First point that changed.
+    while (n > Size(level))
+    {
+	if (fLevel.size() <= level)
+	{
+	    fLevel.push_back(std::vector<Bucket>());
+	}
+	std::vector<Bucket> &L = fLevel[level];
+	nb    = (n + Size(level) - 1)/Size(level);
+	b     = first/Size(level);
+	L.resize(nb);
+	for (; b<nb; b++)
+	{
+	    Bucket &B = L[b];
+	    if (level == 0)
+	    {
+		i   = b*Size(0);
+		end = std::min(i + Size(0), n);
+		B.imin = B.imax = i;
+		for (i++; i<end; i++)
+		{
+		    if (y[i] < y[B.imin]) B.imin = i;
+		    if (y[i] > y[B.imax]) B.imax = i;
+		}
+	    }
+	    else
+	    {
+		const std::vector<Bucket> &C = fLevel[level-1];
+		B = C[2*b];
+		if (2*b+1 < C.size())
+		{
+		    const Bucket &D = C[2*b+1];
+		    if (y[D.imin] < y[B.imin]) B.imin = D.imin;
+		    if (y[D.imax] > y[B.imax]) B.imax = D.imax;
+		}
+	    }
+	}
+	level++;
+    }
+    // Data may have shrunk below the top levels on a rebuild.
+    if (fLevel.size() > level)
+    {
+	fLevel.resize(level);
+    }
+    fN = n;
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Envelope
+ *
+ * Description : Fill ox, oy with the points to be drawn for the
+ *               range [lo, hi]. The coarsest level that still has
+ *               about two buckets per pixel column is used and for
+ *               each bucket its min and max points are emitted in
+ *               the order they were taken so the line is traced
+ *               as it was measured. One point either side of the
+ *               range is included such that lines run to the edge
+ *               of the frame. If there are few enough points they
+ *               are copied directly. Unsorted data has no range to
+ *               find, the pyramid buckets would mix points in and
+ *               out of view, so it is clipped point by point and 
+ *               bucketed as it goes. That costs of order N.
+ *
+ * Inputs : x, y   - data arrays, double or single precision
+ *          lo, hi - range in x
+ *          pixels - pixel columns available
+ *          ox, oy - output, at least MaxOut(pixels) long.
+ *
+ * Returns : number of points written.
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t MinMaxPyramid::Envelope(const double *x, const double *y,
+				 double lo, double hi, uint32_t pixels,
+				 double *ox, double *oy) const
+{
+    return DoEnvelope(x, y, lo, hi, pixels, ox, oy);
+}
+uint32_t MinMaxPyramid::Envelope(const float *x, const float *y,
+				 double lo, double hi, uint32_t pixels,
+				 double *ox, double *oy) const
+{
+    return DoEnvelope(x, y, lo, hi, pixels, ox, oy);
+}
+template <class T>
+uint32_t MinMaxPyramid::DoEnvelope(const T *x, const T *y,
+				   double lo, double hi, uint32_t pixels,
+				   double *ox, double *oy) const
+{
+    SET_DEBUG_STACK;
+    uint32_t i0 = 0;
+    uint32_t i1 = fN;
+    uint32_t level, b, b0, b1, count, nout;
+    uint32_t maxb = 2*pixels;
+
+    if (fN == 0) return 0;
+    if (maxb < 2) maxb = 2;
+
+    if (!fSorted)
+    {
+	uint32_t i, k = 0, step, last = 0, imin = 0, imax = 0;
+
+	count = 0;
+	for (i=0; i<fN; i++)
+	{
+	    if ((x[i] >= lo) && (x[i] <= hi))
+	    {
+		count++;
+		last = i;
+	    }
+	}
+	// In view points per bucket, 1 draws them all.
+	step = (count + maxb - 1)/maxb;
+	if (step < 1) step = 1;
+	nout = 0;
+	for (i=0; i<fN && nout+2<=MaxOut(pixels); i++)
+	{
+	    if ((x[i] < lo) || (x[i] > hi)) continue;
+	    if (k == 0) imin = imax = i;
+	    if (y[i] < y[imin]) imin = i;
+	    if (y[i] > y[imax]) imax = i;
+	    if ((++k == step) || (i == last))
+	    {
+		ox[nout] = x[std::min(imin, imax)];
+		oy[nout] = y[std::min(imin, imax)];
+		nout++;
+		if (imin != imax)
+		{
+		    ox[nout] = x[std::max(imin, imax)];
+		    oy[nout] = y[std::max(imin, imax)];
+		    nout++;
+		}
+		k = 0;
+	    }
+	}
+	return nout;
+    }
+
+    i0 = std::lower_bound(x, x+fN, (T) lo) - x;
+    i1 = std::upper_bound(x, x+fN, (T) hi) - x;
+    if (i0 > 0)  i0--;
+    if (i1 < fN) i1++;
+    count = i1 - i0;
+    nout  = 0;
+
+    if ((count <= 2*maxb) || fLevel.empty())
+    {
+	for (uint32_t i=i0; i<i1 && nout<MaxOut(pixels); i++, nout++)
+	{
+	    ox[nout] = x[i];
+	    oy[nout] = y[i];
+	}
+	return nout;
+    }
+
+    // Coarsest useful level.
+    level = 0;
+    while ((level+1 < fLevel.size()) && (count/Size(level) > maxb))
+    {
+	level++;
+    }
+
+    const std::vector<Bucket> &L = fLevel[level];
+    b0 = i0/Size(level);
+    b1 = (i1 - 1)/Size(level);
+    for (b=b0; b<=b1 && nout+2<=MaxOut(pixels); b++)
+    {
+	const Bucket &B = L[b];
+	uint32_t first  = std::min(B.imin, B.imax);
+	uint32_t second = std::max(B.imin, B.imax);
+	ox[nout] = x[first];
+	oy[nout] = y[first];
+	nout++;
+	if (second != first)
+	{
+	    ox[nout] = x[second];
+	    oy[nout] = y[second];
+	    nout++;
+	}
+    }
+    SET_DEBUG_STACK;
+    return nout;
+}
@@ -0,0 +1,138 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : MinMaxPyramid.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Level of detail for drawing large data sets. The
+ *               points are grouped into buckets of 4, 8, 16 ... and
+ *               for each bucket the index of the minimum and maximum
+ *               value is kept. To draw a range of the data on a pad
+ *               N pixels wide only the min/max envelope of about N
+ *               buckets is handed to the graphics, which looks the
+ *               same as drawing every point.
+ *
+ * Restrictions/Limitations :
+ *               The pyramid holds indices only, the data arrays are
+ *               passed in on each call and must be the same arrays
+ *               (or copies of them) that were used in Update.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __MINMAXPYRAMID_hh_
+#define __MINMAXPYRAMID_hh_
+#include <stdint.h>
+#include <vector>
+
+/// MinMaxPyramid documentation here.
+class MinMaxPyramid {
+public:
+
+    MinMaxPyramid(void);
+
+    /*!
+     * Description:
+     *   Forget all the data.
+     *
+     * Arguments:
+     *   NONE
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void Clear(void);
+
+    /*!
+     * Description:
+     *   Bring the pyramid up to date with the data. Points already
+     *   seen are not looked at again, only the buckets at the end
+     *   are recomputed, so calling this after every point of a live
+     *   sweep costs of order log(N).
+     *
+     * Arguments:
+     *   x, y - data arrays
+     *   n    - number of points now in the arrays
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   If n is less than the number of points previously seen the
+     *   pyramid is rebuilt from scratch.
+     */
+    void Update(const double *x, const double *y, uint32_t n);
+    void Update(const float  *x, const float  *y, uint32_t n);
+
+    /*!
+     * Description:
+     *   Produce the min/max envelope of the data with x in [lo,hi].
+     *   If the data is sorted in x the range is found by bisection,
+     *   otherwise the points outside it are dropped in one pass and
+     *   the rest bucketed in the order they were taken.
+     *
+     * Arguments:
+     *   x, y    - data arrays, as given to Update.
+     *   lo, hi  - x range to be displayed.
+     *   pixels  - number of pixel columns available.
+     *   ox, oy  - output arrays, at least MaxOut(pixels) long.
+     *
+     * Returns:
+     *   Number of points written into ox, oy.
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t Envelope(const double *x, const double *y,
+		      double lo, double hi, uint32_t pixels,
+		      double *ox, double *oy) const;
+    uint32_t Envelope(const float  *x, const float  *y,
+		      double lo, double hi, uint32_t pixels,
+		      double *ox, double *oy) const;
+
+    /*! Size the output arrays of Envelope must have. */
+    static inline uint32_t MaxOut(uint32_t pixels)
+	{return 4*pixels + 16;};
+
+    /*! Number of points seen. */
+    inline uint32_t N(void) const {return fN;};
+
+    /*! Is the data monotonic in x? */
+    inline bool Sorted(void) const {return fSorted;};
+
+    /*! Number of levels in the pyramid. */
+    inline uint32_t Levels(void) const {return fLevel.size();};
+
+private:
+    /*! One bucket, indices of the smallest and largest y. */
+    struct Bucket {
+	uint32_t imin;
+	uint32_t imax;
+    };
+
+    /*! Work for Update and Envelope, double or float data. */
+    template <class T> void DoUpdate(const T *x, const T *y, uint32_t n);
+    template <class T> uint32_t DoEnvelope(const T *x, const T *y,
+					   double lo, double hi,
+					   uint32_t pixels,
+					   double *ox, double *oy) const;
+
+    /*! Bucket size of a level in points. */
+    static inline uint32_t Size(uint32_t level)
+	{return (4U << level);};
+
+    uint32_t  fN;         /*! Points seen.          */
+    bool      fSorted;    /*! x non-decreasing?     */
+    /*! fLevel[0] has buckets of 4 points, each level above twice that.*/
+    std::vector< std::vector<Bucket> > fLevel;
+};
+#endif
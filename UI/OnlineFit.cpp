@@ -0,0 +1,304 @@
+/********************************************************************
+ *
+ * Module Name : OnlineFit.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Running diode fit during acquisition.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <cstring>
+
+// Local Includes.
+#include "debug.h"
+#include "OnlineFit.hh"
+
+/*
+ * Only points above this many kT/q go into the line, below it
+ * ln(I) goes as ln(V).
+ */
+const double kLineVt = 5.0;
+
+/* Stable also needs n known to this fraction. */
+const double kStableN = 0.01;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : OnlineFit constructor
+ *
+ * Description :
+ *
+ * Inputs : Temperature - Kelvin
+ *          K           - forward points between refinements
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+OnlineFit::OnlineFit(double Temperature, uint32_t K) : fFit(Temperature)
+{
+    SET_DEBUG_STACK;
+    RefineEvery(K);
+    Reset();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reset
+ *
+ * Description : Clear the sums and the stored points. The storage
+ *               is kept for the next sweep.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OnlineFit::Reset(void)
+{
+    SET_DEBUG_STACK;
+    memset(&fParams, 0, sizeof(fParams));
+    fParams.Rsh  = HUGE_VAL;
+    fSinceRefine = 0;
+    fRefined     = false;
+    fStableCount = 0;
+    fN   = 0;
+    fSx  = fSy = fSxx = fSxy = fSyy = 0.0;
+    fV.clear();
+    fI.clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Temperature
+ *
+ * Description : Change the junction temperature, takes effect on
+ *               the next point.
+ *
+ * Inputs : K - Kelvin
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OnlineFit::Temperature(double K)
+{
+    fFit.Temperature(K);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Take a point. Forward points above kLineVt kT/q
+ *               update the line, every fK forward points the full
+ *               model is refined.
+ *
+ * Inputs : V, I - the point
+ *
+ * Returns : true if the estimate was updated.
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool OnlineFit::Add(double V, double I)
+{
+    SET_DEBUG_STACK;
+    double y;
+
+    fV.push_back(V);
+    fI.push_back(I);
+    if ((V <= 0.0) || (I <= 0.0))
+    {
+	return false;
+    }
+    fSinceRefine++;
+    if (fSinceRefine >= fK)
+    {
+	fSinceRefine = 0;
+	Refine();
+	if (fRefined)
+	{
+	    return true;
+	}
+    }
+    if (fRefined || (V < kLineVt*fFit.ThermalVoltage()))
+    {
+	/*
+	 * Once refined the line is a poorer estimate than the last
+	 * refinement, keep showing that until the next one.
+	 */
+	return false;
+    }
+    y     = log(I);
+    fN++;
+    fSx  += V;
+    fSy  += y;
+    fSxx += V*V;
+    fSxy += V*y;
+    fSyy += y*y;
+    Line();
+    return (fN > 2);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Line
+ *
+ * Description : Closed form least squares for ln(I) = c + b V,
+ *               Is = exp(c), n = 1/(b Vt), errors from the residual
+ *               scatter.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OnlineFit::Line(void)
+{
+    double det, b, c, ss, s2;
+
+    if (fN < 3)
+    {
+	return;
+    }
+    det = fN*fSxx - fSx*fSx;
+    if (det <= 0.0)
+    {
+	return;
+    }
+    b = (fN*fSxy - fSx*fSy)/det;
+    c = (fSy - b*fSx)/fN;
+    if (b <= 0.0)
+    {
+	return;
+    }
+    // Residual sum of squares from the sums alone.
+    ss = fSyy - c*fSy - b*fSxy;
+    s2 = fmax(ss, 0.0)/(fN - 2);
+
+    fParams.Is       = exp(c);
+    fParams.n        = 1.0/(b*fFit.ThermalVoltage());
+    fParams.Rs       = 0.0;
+    fParams.Rsh      = HUGE_VAL;
+    memset(fParams.Error, 0, sizeof(fParams.Error));
+    memset(fParams.Cov,   0, sizeof(fParams.Cov));
+    fParams.Cov[0][0] = fParams.Is*fParams.Is*s2*fSxx/det;
+    fParams.Cov[1][1] = fParams.n*fParams.n*s2*fN/(det*b*b);
+    fParams.Cov[0][1] = fParams.Cov[1][0] = 
+	fParams.Is*(-fParams.n/b)*(-s2*fSx/det);
+    fParams.Error[0]  = sqrt(fParams.Cov[0][0]);
+    fParams.Error[1]  = sqrt(fParams.Cov[1][1]);
+    fParams.Chi2      = ss;
+    fParams.NDF       = fN - 2;
+    fParams.Converged = true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Refine
+ *
+ * Description : Full model fit over everything so far, warm started
+ *               from the previous refinement. Early in the sweep the
+ *               previous refinement may have seen nothing but the
+ *               shunt, so until the fit is stable a cold start is
+ *               tried as well and the better of the two kept. 
+ *               Tracks how far each refinement moves the parameters
+ *               for Stable.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : A failed fit leaves the estimate alone.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OnlineFit::Refine(void)
+{
+    SET_DEBUG_STACK;
+    DiodeParams p = fParams;
+    DiodeParams c;
+    bool        ok, quiet;
+
+    ok = fFit.FitFull(&fV[0], &fI[0], fV.size(), p, fRefined);
+    if (fRefined && !Stable())
+    {
+	if (fFit.FitFull(&fV[0], &fI[0], fV.size(), c, false) &&
+	    (!ok || (c.Chi2 < p.Chi2)))
+	{
+	    p  = c;
+	    ok = true;
+	}
+    }
+    if (!ok || !std::isfinite(p.Error[0]) || !std::isfinite(p.Error[1]))
+    {
+	return;
+    }
+    if (fRefined)
+    {
+	quiet = (fabs(p.Is - fParams.Is) < p.Error[0]) &&
+	    (fabs(p.n  - fParams.n)  < p.Error[1]) &&
+	    (fabs(p.Rs - fParams.Rs) < p.Error[2]) &&
+	    (p.Error[1] < kStableN*p.n);
+	fStableCount = quiet ? fStableCount + 1 : 0;
+    }
+    fParams  = p;
+    fRefined = true;
+    SET_DEBUG_STACK;
+}
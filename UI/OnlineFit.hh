@@ -0,0 +1,111 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : OnlineFit.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Running fit of the diode as the sweep comes in.
+ *               Every forward point above a few kT/q goes into the
+ *               sums for a straight line of ln(I) against V, which
+ *               gives Is and n, with errors, for the cost of a 
+ *               handful of adds. Every K forward points the full
+ *               model is refined with DiodeFit, warm started from 
+ *               the last refinement, which brings in Rs and Rsh.
+ *
+ *               The fit is called stable once two refinements in a
+ *               row move Is, n and Rs by less than their one sigma
+ *               errors and n is known to 1%. At that point there is little to gain from
+ *               the rest of the sweep.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __ONLINEFIT_hh_
+#define __ONLINEFIT_hh_
+#include <stdint.h>
+#include <vector>
+#include "DiodeFit.hh"
+
+/// OnlineFit documentation here.
+class OnlineFit {
+public:
+    /*!
+     * Description:
+     *   Create the running fit.
+     *
+     * Arguments:
+     *   Temperature - junction temperature, Kelvin
+     *   K           - forward points between full refinements.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    OnlineFit(double Temperature = 293.15, uint32_t K = 25);
+
+    /*! Forget everything, start of a new sweep. */
+    void Reset(void);
+
+    /*!
+     * Description:
+     *   Add a point as it is acquired.
+     *
+     * Arguments:
+     *   V - voltage
+     *   I - current
+     *
+     * Returns:
+     *   true if the estimate changed, i.e. the point was usable.
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Add(double V, double I);
+
+    /*! Current best estimate, Rs and Rsh are zero and infinite
+     *  until the first refinement. */
+    inline const DiodeParams& Params(void) const {return fParams;};
+    /*! True once at least one full refinement has succeeded. */
+    inline bool     Refined(void) const {return fRefined;};
+    /*! Refinement has settled, see above. */
+    inline bool     Stable(void) const {return (fStableCount >= 2);};
+    /*! Points taken and points used in the line. */
+    inline uint32_t NPoints(void) const {return fV.size();};
+    inline uint32_t NLine(void)   const {return fN;};
+
+    void            Temperature(double K);
+    inline void     RefineEvery(uint32_t K) {fK = (K > 0) ? K : 1;};
+    inline uint32_t RefineEvery(void) const {return fK;};
+
+private:
+    /*! Is and n, with errors, from the regression sums. */
+    void Line(void);
+    /*! Full model, warm started. */
+    void Refine(void);
+
+    DiodeFit            fFit;
+    DiodeParams         fParams;
+    uint32_t            fK;
+    uint32_t            fSinceRefine;   // Forward points since refine
+    bool                fRefined;
+    uint32_t            fStableCount;   // Quiet refinements in a row
+
+    // Regression sums of ln(I) against V.
+    uint32_t            fN;
+    double              fSx, fSy, fSxx, fSxy, fSyy;
+
+    // Everything so far, for the refinements.
+    std::vector<double> fV;
+    std::vector<double> fI;
+};
+#endif
@@ -0,0 +1,329 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : OverlayDialog.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Turn cached runs on and off in the overlay plot.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+// System includes.
+#include <iostream>
+using namespace std;
+#include <string>
+
+/// Root Includes
+#include <TROOT.h>
+#include <TGFrame.h>
+#include <TGButton.h>
+#include <TGCanvas.h>
+#include <RQ_OBJECT.h>
+
+/// Local Includes.
+#include "debug.h"
+#include "OverlayDialog.hh"
+#include "RunCache.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : OverlayDlg  Constructor
+ *
+ * Description : One check button per cached run in a scrolling
+ *               frame, there may be hundreds of them.
+ *
+ * Inputs : main    - parent window
+ *          runs    - the run cache
+ *          Changed - set true if the user pressed OK
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+OverlayDlg::OverlayDlg(const TGWindow *main, RunCache *runs, Bool_t *Changed)
+    : TGTransientFrame(gClient->GetRoot(), main, 60, 40)
+{
+    TGLayoutHints* fL1 = new 
+	TGLayoutHints(kLHintsTop | kLHintsLeft, 2, 2, 1, 1);
+    TGLayoutHints* fL2 = new 
+	TGLayoutHints(kLHintsTop | kLHintsExpandX | kLHintsExpandY, 
+		      2, 2, 5, 5);
+    TGCanvas         *scroll;
+    TGVerticalFrame  *list;
+    TGCheckButton    *cb;
+
+    Connect("CloseWindow()", "OverlayDlg", this, "CloseWindow()");
+    SetWindowName("Overlay Runs");
+    fRuns    = runs;
+    fChanged = Changed;
+    *fChanged = kFALSE;
+
+    scroll = new TGCanvas(this, 400, 300);
+    list   = new TGVerticalFrame(scroll->GetViewPort(), 400, 300);
+    scroll->SetContainer(list);
+    for (size_t i=0; i<fRuns->N(); i++)
+    {
+	cb = new TGCheckButton(list, fRuns->Label(i), i);
+	cb->SetState(fRuns->Visible(i) ? kButtonDown : kButtonUp);
+	list->AddFrame(cb, fL1);
+	fCheck.push_back(cb);
+    }
+    AddFrame(scroll, fL2);
+
+    BuildButtonBox();
+
+    MapSubwindows();
+    Resize();
+    MapWindow();
+    fClient->WaitFor(this);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : OverlayDlg  Destructor
+ *
+ * Description :
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+OverlayDlg::~OverlayDlg()
+{
+    Cleanup();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : BuildButtonBox
+ *
+ * Description : Creates the GUI buttons All, None, Ok and Cancel
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by:
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::BuildButtonBox()
+{
+    TGButton *tb;
+
+    // Create a frame to hold the buttons.
+    TGCompositeFrame *ButtonFrame = new 
+    TGCompositeFrame(this, 600, 20, kHorizontalFrame);
+
+    TGLayoutHints* fL2 = new 
+	TGLayoutHints(kLHintsBottom | kLHintsCenterX, 0, 0, 5, 5);
+
+    tb = new TGTextButton( ButtonFrame, "  &All  ");
+    tb->Connect("Clicked()", "OverlayDlg", this, "DoAll()");
+    ButtonFrame->AddFrame( tb, fL2);
+
+    tb = new TGTextButton( ButtonFrame, "  &None  ");
+    tb->Connect("Clicked()", "OverlayDlg", this, "DoNone()");
+    ButtonFrame->AddFrame( tb, fL2);
+
+    tb = new TGTextButton( ButtonFrame, "  &Ok  ");
+    tb->Connect("Clicked()", "OverlayDlg", this, "DoOK()");
+    ButtonFrame->AddFrame( tb, fL2);
+
+    tb = new TGTextButton( ButtonFrame, "  &Cancel  ");
+    tb->Connect("Clicked()", "OverlayDlg", this, "DoCancel()");
+    ButtonFrame->AddFrame( tb, fL2);
+
+    ButtonFrame->Resize();
+    AddFrame(ButtonFrame, new TGLayoutHints( kLHintsExpandX|kLHintsLeft, 
+					     2, 2, 2, 2));
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : CloseWindow
+ *
+ * Description :
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::CloseWindow()
+{
+    // Called when closed via window manager action.
+    delete this;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DoOK
+ *
+ * Description : User pressed the OK button - copy the check buttons
+ *               back to the run cache and close the window.
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by:
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::DoOK(void)
+{
+    for (size_t i=0; i<fCheck.size(); i++)
+    {
+	fRuns->Visible(i, fCheck[i]->IsOn());
+    }
+    *fChanged = kTRUE;
+    SendCloseMessage();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DoAll
+ *
+ * Description : Check all the runs.
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by:
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::DoAll(void)
+{
+    for (size_t i=0; i<fCheck.size(); i++)
+    {
+	fCheck[i]->SetState(kButtonDown);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DoNone
+ *
+ * Description : Uncheck all the runs.
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by:
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::DoNone(void)
+{
+    for (size_t i=0; i<fCheck.size(); i++)
+    {
+	fCheck[i]->SetState(kButtonUp);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DoCancel
+ *
+ * Description : Close the window
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::DoCancel()
+{
+    SendCloseMessage();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : DoClose
+ *
+ * Description :
+ *
+ * Inputs :
+ *
+ * Returns :
+ *
+ * Error Conditions :
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by:
+ *
+ *
+ *******************************************************************
+ */
+void OverlayDlg::DoClose()
+{
+   // Handle close button.
+    SendCloseMessage();
+}
@@ -0,0 +1,60 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : OverlayDialog.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Pick which of the cached runs are shown in the
+ *               overlay plot.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __OVERLAYDLG_hh_
+#define __OVERLAYDLG_hh_
+
+#  include <vector>
+#  include <TGFrame.h>
+#  include <RQ_OBJECT.h>
+class TGCheckButton;
+class RunCache;
+
+class OverlayDlg : public TGTransientFrame
+{
+    ClassDef( OverlayDlg, 0);
+
+public:
+    /// Constructor, Changed is set true if OK was pressed.
+    OverlayDlg (const TGWindow *parent, RunCache *runs, Bool_t *Changed);
+    ~OverlayDlg();
+
+    /// Close the window
+    void   CloseWindow();
+    /// User pressed the OK button, end the dialog
+    void   DoOK();
+    /// User pressed the Cancel button, end the dialog
+    void   DoCancel();
+    /// Close the window
+    void   DoClose();
+    /// Check or uncheck every run
+    void   DoAll();
+    void   DoNone();
+
+private:
+
+    /// Build the Ok and Cancel Buttons
+    void BuildButtonBox();
+    RunCache                    *fRuns;
+    Bool_t                      *fChanged;
+    std::vector<TGCheckButton*> fCheck;
+};
+
+#endif
@@ -0,0 +1,582 @@
+/********************************************************************
+ *
+ * Module Name : ProfileStore.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Part profiles learned from previous sweeps.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cctype>
+#include <unistd.h>
+
+/// Root includes http://root.cern.ch
+#include <TEnv.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "ProfileStore.hh"
+#include "SampleStore.hh"
+#include "RegionDetect.hh"
+#include "Recipe.hh"
+
+// Runs the running mean reaches back over.
+const uint32_t kProfileMemory = 5;
+// Settle measurements before the profile stops asking for them.
+const uint32_t kSettleRuns    = 3;
+// Averaged points needed to fit the noise.
+const uint32_t kNoisePoints   = 3;
+// Settle used is the one measured times this, and never below the floor.
+const double   kSettleMargin  = 1.5;
+const double   kMinSettle     = 0.005;
+// Fine steps across the knee.
+const double   kKneePoints    = 20.0;
+// Smallest fine step tuned to, volts.
+const double   kMinFine       = 1.0e-3;
+// Most averages tuned to.
+const uint32_t kMaxAverage    = 16;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : PartProfile constructor
+ *
+ * Description : Nothing known.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+PartProfile::PartProfile(void)
+{
+    Runs        = 0;
+    SettleRuns  = 0;
+    Settle      = 0.0;
+    NoiseFloor  = 0.0;
+    NoiseRel    = 0.0;
+    Knee        = 0.0;
+    KneeHi      = 0.0;
+    KneeCurrent = 0.0;
+    Compliance  = 0.0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ProfileStore constructor
+ *
+ * Description : Read the store if there is one.
+ *
+ * Inputs : File - store file
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ProfileStore::ProfileStore(const char *File)
+{
+    SET_DEBUG_STACK;
+    fFilename    = File;
+    fTemperature = 293.15;
+    fEnv         = new TEnv("");
+    if (access(File, R_OK) == 0)
+    {
+	fEnv->ReadFile(File, kEnvLocal);
+	CLogger::GetThis()->Log("# ProfileStore: %s\n", File);
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ProfileStore destructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ProfileStore::~ProfileStore(void)
+{
+    SET_DEBUG_STACK;
+    delete fEnv;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Prefix
+ *
+ * Description : Resource prefix for a part. TEnv names can not
+ *               hold spaces or colons, and a dot would split the
+ *               name, so everything but letters, digits, - and _
+ *               goes to _.
+ *
+ * Inputs : Part - part number or comment
+ *
+ * Returns : "Profile.<key>." or "" for no part
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+std::string ProfileStore::Prefix(const std::string &Part)
+{
+    std::string key;
+    char        c;
+
+    for (size_t i=0; i<Part.size(); i++)
+    {
+	c = Part[i];
+	if (!(isalnum((unsigned char) c) || (c == '-') || (c == '_')))
+	{
+	    c = '_';
+	}
+	key += c;
+    }
+    if (key.empty())
+    {
+	return key;
+    }
+    return "Profile." + key + ".";
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Find
+ *
+ * Description : Look a part up.
+ *
+ * Inputs : Part - part number or comment
+ *          p    - filled in
+ *
+ * Returns : true if the part has been seen
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::Find(const std::string &Part, PartProfile &p) const
+{
+    SET_DEBUG_STACK;
+    std::string pre = Prefix(Part);
+
+    if (pre.empty())
+    {
+	return false;
+    }
+    p.Runs        = fEnv->GetValue((pre + "Runs").c_str(),       0);
+    p.SettleRuns  = fEnv->GetValue((pre + "SettleRuns").c_str(), 0);
+    p.Settle      = fEnv->GetValue((pre + "Settle").c_str(),     0.0);
+    p.NoiseFloor  = fEnv->GetValue((pre + "NoiseFloor").c_str(), 0.0);
+    p.NoiseRel    = fEnv->GetValue((pre + "NoiseRel").c_str(),   0.0);
+    p.Knee        = fEnv->GetValue((pre + "Knee").c_str(),       0.0);
+    p.KneeHi      = fEnv->GetValue((pre + "KneeHi").c_str(),     0.0);
+    p.KneeCurrent = fEnv->GetValue((pre + "KneeCurrent").c_str(), 0.0);
+    p.Compliance  = fEnv->GetValue((pre + "Compliance").c_str(), 0.0);
+    return (p.Runs > 0);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Learn
+ *
+ * Description : Fold one sweep into a profile. The up branch is
+ *               segmented for the knee. The noise model is a least
+ *               squares fit of sigma^2 = A + B I^2 over the points
+ *               averaged more than once, sigma being the spread of
+ *               one reading. The new values go into a running mean,
+ *               weight 1/n over the first kProfileMemory runs and
+ *               1/kProfileMemory after that.
+ *
+ * Inputs : Part        - part number or comment
+ *          s           - sweep
+ *          Limit       - current limit, A
+ *          ComplianceV - first voltage in compliance, NaN if none
+ *          Settle      - measured settle, NaN if not measured
+ *
+ * Returns : true if the profile was updated
+ *
+ * Error Conditions : no part, too few points
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::Learn(const std::string &Part, const SampleStore &s,
+			 double Limit, double ComplianceV, double Settle)
+{
+    SET_DEBUG_STACK;
+    CLogger *log = CLogger::GetThis();
+    std::string         pre = Prefix(Part);
+    std::vector<double> V, I;
+    RegionDetect        rd(fTemperature);
+    PartProfile         p;
+    double   w, u, Vlo, Vhi, I2, S2, Sw, Sx, Sy, Sxx, Sxy, D, A, B, d, best;
+    uint32_t i, n;
+    bool     Knee;
+
+    if (pre.empty() || (s.N() < 2))
+    {
+	return false;
+    }
+    Find(Part, p);
+    p.Runs++;
+    w = 1.0/(double) ((p.Runs < kProfileMemory) ? p.Runs : kProfileMemory);
+
+    // The up branch is the curve, the down one only repeats it.
+    for (i=0; i<s.N(); i++)
+    {
+	if (s.BranchOf()[i] != SampleStore::kUp) continue;
+	V.push_back(s.SetV()[i]);
+	I.push_back(s.Mean()[i]);
+    }
+
+    /*
+     * The knee is the widest exponential region. Any number of points
+     * will do to say where it is, Window wants enough for a fit.
+     */
+    rd.Compliance(Limit);
+    Knee = false;
+    n    = 0;
+    if (rd.Analyze(&V[0], &I[0], V.size()))
+    {
+	for (i=0; i<rd.Regions().size(); i++)
+	{
+	    const RegionDetect::Region &g = rd.Regions()[i];
+	    if ((g.Type == RegionDetect::kExponential) && (g.NPoints > n))
+	    {
+		n    = g.NPoints;
+		Vlo  = g.Vlo;
+		Vhi  = g.Vhi;
+		Knee = true;
+	    }
+	}
+    }
+    if (Knee)
+    {
+	// Current at the point nearest the start of the knee.
+	best = HUGE_VAL;
+	d    = 0.0;
+	for (i=0; i<V.size(); i++)
+	{
+	    if (fabs(V[i] - Vlo) < best)
+	    {
+		best = fabs(V[i] - Vlo);
+		d    = fabs(I[i]);
+	    }
+	}
+	// Nothing to average with if no earlier run found the knee.
+	u = (p.KneeHi > p.Knee) ? w : 1.0;
+	p.Knee        += u*(Vlo - p.Knee);
+	p.KneeHi      += u*(Vhi - p.KneeHi);
+	p.KneeCurrent += u*(d - p.KneeCurrent);
+    }
+
+    /*
+     * Noise, sigma^2 against I^2. The currents span decades, so each
+     * point is weighted by 1/sigma^4 and the fit is to the relative
+     * residual, otherwise the floor is lost under the big currents.
+     */
+    n = 0;
+    Sw = Sx = Sy = Sxx = Sxy = 0.0;
+    for (i=0; i<s.N(); i++)
+    {
+	if ((s.NSamples()[i] < 2) || (s.Sigma()[i] <= 0.0) ||
+	    ((Limit > 0.0) && (fabs(s.Mean()[i]) >= 0.98*Limit)))
+	{
+	    continue;
+	}
+	I2   = (double) s.Mean()[i] * (double) s.Mean()[i];
+	S2   = (double) s.Sigma()[i] * (double) s.Sigma()[i];
+	d    = 1.0/(S2*S2);
+	Sw  += d;
+	Sx  += d*I2;
+	Sy  += d*S2;
+	Sxx += d*I2*I2;
+	Sxy += d*I2*S2;
+	n++;
+    }
+    if (n >= kNoisePoints)
+    {
+	D = Sw*Sxx - Sx*Sx;
+	if (D > 0.0)
+	{
+	    B = (Sw*Sxy - Sx*Sy)/D;
+	    A = (Sy - B*Sx)/Sw;
+	}
+	else
+	{
+	    // All at one current, call it floor.
+	    B = 0.0;
+	    A = Sy/Sw;
+	}
+	if (A < 0.0) A = 0.0;
+	if (B < 0.0) B = 0.0;
+	u = ((p.NoiseFloor > 0.0) || (p.NoiseRel > 0.0)) ? w : 1.0;
+	p.NoiseFloor += u*(sqrt(A) - p.NoiseFloor);
+	p.NoiseRel   += u*(sqrt(B) - p.NoiseRel);
+    }
+
+    if (!std::isnan(ComplianceV))
+    {
+	u = (p.Compliance != 0.0) ? w : 1.0;
+	p.Compliance += u*(ComplianceV - p.Compliance);
+    }
+    if (!std::isnan(Settle))
+    {
+	p.SettleRuns++;
+	u = 1.0/(double) ((p.SettleRuns < kProfileMemory) ? p.SettleRuns :
+			  kProfileMemory);
+	p.Settle += u*(Settle - p.Settle);
+    }
+
+    fEnv->SetValue((pre + "Runs").c_str(),        (int) p.Runs);
+    fEnv->SetValue((pre + "SettleRuns").c_str(),  (int) p.SettleRuns);
+    fEnv->SetValue((pre + "Settle").c_str(),      p.Settle);
+    fEnv->SetValue((pre + "NoiseFloor").c_str(),  p.NoiseFloor);
+    fEnv->SetValue((pre + "NoiseRel").c_str(),    p.NoiseRel);
+    fEnv->SetValue((pre + "Knee").c_str(),        p.Knee);
+    fEnv->SetValue((pre + "KneeHi").c_str(),      p.KneeHi);
+    fEnv->SetValue((pre + "KneeCurrent").c_str(), p.KneeCurrent);
+    fEnv->SetValue((pre + "Compliance").c_str(),  p.Compliance);
+    log->Log("# ProfileStore: %s run %d, knee %g to %g V at %g A, noise %g + %g I, settle %g s\n",
+	     Part.c_str(), (int) p.Runs, p.Knee, p.KneeHi, p.KneeCurrent,
+	     p.NoiseFloor, p.NoiseRel, p.Settle);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Tune
+ *
+ * Description : Fastest sweep the profile allows.
+ *
+ *               Settle - measured, times kSettleMargin.
+ *               NAVG   - averages that bring the spread of the mean
+ *                        at the knee current within NoiseTarget of
+ *                        it, up to kMaxAverage.
+ *               Steps  - coarse outside the knee, kKneePoints fine
+ *                        steps across it, the fine band is set from
+ *                        Knee to KneeHi. Window is left as it was.
+ *               Stop   - pulled in to where compliance starts, the
+ *                        points past it read the limit.
+ *
+ * Inputs : r - recipe, changed in place
+ *
+ * Returns : true if a profile was used
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::Tune(Recipe &r) const
+{
+    SET_DEBUG_STACK;
+    CLogger     *log = CLogger::GetThis();
+    PartProfile p;
+    double      sigma, fine, n;
+
+    if (!Find(r.PartKey(), p))
+    {
+	log->Log("# ProfileStore: nothing known of %s yet.\n",
+		 r.PartKey().c_str());
+	return false;
+    }
+    if (p.SettleRuns > 0)
+    {
+	r.Settle = fmax(kSettleMargin*p.Settle, kMinSettle);
+    }
+    if ((p.KneeCurrent > 0.0) && (r.NoiseTarget > 0.0))
+    {
+	sigma  = hypot(p.NoiseFloor, p.NoiseRel*p.KneeCurrent);
+	n      = ceil(pow(sigma/(r.NoiseTarget*p.KneeCurrent), 2.0));
+	r.NAVG = (n < 1.0) ? 1 : ((n > kMaxAverage) ? kMaxAverage :
+				  (uint32_t) n);
+    }
+    if (p.KneeHi > p.Knee)
+    {
+	fine = (p.KneeHi - p.Knee)/kKneePoints;
+	if (fine < kMinFine) fine = kMinFine;
+	if ((r.Step > 0.0) && (fine < r.Step))
+	{
+	    r.Fine     = fine;
+	    r.FineFrom = p.Knee;
+	    r.FineTo   = p.KneeHi;
+	    r.FineOnly = false;
+	}
+    }
+    if ((p.Compliance > r.Start) && (p.Compliance < r.Stop))
+    {
+	r.Stop = p.Compliance;
+    }
+    log->Log("# ProfileStore: %s tuned from %d runs, settle %g s, NAVG %d, fine %g from %g to %g V, stop %g V\n",
+	     r.PartKey().c_str(), (int) p.Runs, r.Settle, (int) r.NAVG,
+	     r.Fine, r.FineFrom, r.FineTo, r.Stop);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WantsSettle
+ *
+ * Description : Keep measuring the settle time for the first few
+ *               runs, after that it costs time on every part.
+ *
+ * Inputs : Part - part number or comment
+ *
+ * Returns : true if another settle measurement is wanted
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::WantsSettle(const std::string &Part) const
+{
+    PartProfile p;
+
+    if (Prefix(Part).empty())
+    {
+	return false;
+    }
+    Find(Part, p);
+    return (p.SettleRuns < kSettleRuns);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SettleStep
+ *
+ * Description : First two up points of a sweep.
+ *
+ * Inputs : s        - sweep
+ *          From, To - filled in
+ *          Expected - filled in
+ *
+ * Returns : false if there are not two up points
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::SettleStep(const SampleStore &s, double &From,
+			      double &To, double &Expected)
+{
+    uint32_t i, n = 0, k[2];
+
+    for (i=0; (i<s.N()) && (n<2); i++)
+    {
+	if (s.BranchOf()[i] == SampleStore::kUp) k[n++] = i;
+    }
+    if (n < 2)
+    {
+	return false;
+    }
+    From     = s.SetV()[k[0]];
+    To       = s.SetV()[k[1]];
+    Expected = fmax(fabs(s.Mean()[k[0]]), fabs(s.Mean()[k[1]]));
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Save
+ *
+ * Description : Write the store, through a temporary file so a
+ *               crash never leaves it half written.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : write or rename fails
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ProfileStore::Save(void)
+{
+    SET_DEBUG_STACK;
+    std::string tmp = fFilename + ".tmp";
+
+    if ((fEnv->WriteFile(tmp.c_str(), kEnvAll) != 0) ||
+	(rename(tmp.c_str(), fFilename.c_str()) != 0))
+    {
+	CLogger::GetThis()->Log("# ProfileStore: can not write %s\n",
+				fFilename.c_str());
+	return false;
+    }
+    return true;
+}
@@ -0,0 +1,200 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : ProfileStore.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : What has been learned about each kind of part, kept
+ *               between runs, and the sweep it suggests for the next
+ *               one. A profile is keyed by the part number, or the
+ *               comment if there is none, and holds
+ *
+ *                 Settle      - time for the reading to settle after
+ *                               a step, measured on the reverse
+ *                               bias step where the part is at its
+ *                               highest impedance
+ *                 NoiseFloor  - spread of a single reading at zero
+ *                 NoiseRel      current, and relative to the current
+ *                               well above it, sigma^2 = floor^2 +
+ *                               (rel I)^2 fit to the averaged points
+ *                 Knee        - where the exponential region starts
+ *                 KneeHi        and ends, and the current at Knee
+ *                 KneeCurrent
+ *                 Compliance  - voltage the source first hit its
+ *                               limit, 0 if it never did
+ *
+ *               Each run is folded in with a running mean over the
+ *               last kProfileMemory runs, so the profile follows a
+ *               slow change in the lot but one odd part does not
+ *               throw it off.
+ *
+ *               Tune turns a profile into the fastest sweep that
+ *               still meets the recipe's noise target: the settle
+ *               measured with some margin, just enough averages to
+ *               bring the spread at the knee current under the
+ *               target, fine steps only through the knee and no
+ *               further than compliance.
+ *
+ *               The store is a TEnv file,
+ *                   Profile.<key>.Runs: 4
+ *                   Profile.<key>.Settle: 0.035
+ *                   ...
+ *               where the key is the part with anything other than
+ *               letters, digits, - and _ made into _.
+ *
+ * Restrictions/Limitations :
+ *               Only I-V (mode 3) sweeps are learned from.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __PROFILESTORE_hh_
+#define __PROFILESTORE_hh_
+#include <stdint.h>
+#include <string>
+
+class TEnv;
+class SampleStore;
+struct Recipe;
+
+/// What is known about one kind of part.
+struct PartProfile {
+    uint32_t Runs;         /*! Sweeps learned from              */
+    uint32_t SettleRuns;   /*! Of those, with a settle measured */
+    double   Settle;       /*! s                                */
+    double   NoiseFloor;   /*! A, one reading                   */
+    double   NoiseRel;     /*! sigma/|I| at high current        */
+    double   Knee;         /*! V                                */
+    double   KneeHi;       /*! V                                */
+    double   KneeCurrent;  /*! A at Knee                        */
+    double   Compliance;   /*! V, 0 if never in compliance      */
+    PartProfile(void);
+};
+
+/// ProfileStore documentation here.
+class ProfileStore {
+public:
+    /*!
+     * Description:
+     *   Open a profile store. A missing file is an empty store.
+     *
+     * Arguments:
+     *   File - store file
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    ProfileStore(const char *File);
+    ~ProfileStore(void);
+
+    /*!
+     * Description:
+     *   Look up a part.
+     *
+     * Arguments:
+     *   Part - part number or comment
+     *   p    - filled in if found
+     *
+     * Returns:
+     *   true if there is a profile with at least one run.
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Find(const std::string &Part, PartProfile &p) const;
+
+    /*!
+     * Description:
+     *   Fold a finished sweep into the profile for a part.
+     *
+     * Arguments:
+     *   Part        - part number or comment
+     *   s           - the sweep, current readings
+     *   Limit       - source current limit, A
+     *   ComplianceV - first voltage in compliance, NaN if none
+     *   Settle      - settle time measured after the sweep, NaN if
+     *                 none was
+     *
+     * Returns:
+     *   true if the profile was updated.
+     *
+     * Errors:
+     *   No part name, too few points to say anything.
+     */
+    bool Learn(const std::string &Part, const SampleStore &s,
+	       double Limit, double ComplianceV, double Settle);
+
+    /*!
+     * Description:
+     *   Set a recipe up from the profile for its part. Only what the
+     *   profile knows is changed.
+     *
+     * Arguments:
+     *   r - recipe, changed in place. r.NoiseTarget is the target.
+     *
+     * Returns:
+     *   true if a profile was found and used.
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Tune(Recipe &r) const;
+
+    /*!
+     * Description:
+     *   Does the profile want another settle measurement.
+     *
+     * Arguments:
+     *   Part - part number or comment
+     *
+     * Returns:
+     *   true until kSettleRuns have been measured
+     *
+     * Errors:
+     *   NONE
+     */
+    bool WantsSettle(const std::string &Part) const;
+
+    /*!
+     * Description:
+     *   The step to measure the settle time on, the first up step of
+     *   the sweep, reverse bias if it starts there.
+     *
+     * Arguments:
+     *   s        - sweep just taken
+     *   From, To - step, volts
+     *   Expected - largest of the two readings
+     *
+     * Returns:
+     *   false if the sweep has fewer than two up points.
+     *
+     * Errors:
+     *   NONE
+     */
+    static bool SettleStep(const SampleStore &s, double &From,
+			   double &To, double &Expected);
+
+    /*! Write the store back, false on error. */
+    bool Save(void);
+
+    inline void   Temperature(double K) {fTemperature = K;};
+    inline const std::string& Filename(void) const {return fFilename;};
+
+private:
+    /*! Resource prefix for a part, "" if the name is empty. */
+    static std::string Prefix(const std::string &Part);
+
+    TEnv        *fEnv;
+    std::string fFilename;
+    double      fTemperature;
+};
+#endif
@@ -0,0 +1,473 @@
+/********************************************************************
+ *
+ * Module Name : Recipe.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Sweep settings shared by the GUI and headless runs.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+#include <cmath>
+
+/// Root Includes
+#include <TEnv.h>
+#include <TSystem.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "Recipe.hh"
+#include "Instruments.hh"
+
+/* Shortest dwell the 230 will program, seconds. */
+const double kMinDwell = 3.0e-3;
+/* Smallest reference, V, a gain correction is taken from. */
+const double kMinGainReference = 1.0e-3;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Recipe constructor
+ *
+ * Description : Defaults
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+Recipe::Recipe(void)
+{
+    Mode       = 0;
+    Resistance = 1000.0;
+    NAVG       = 1;
+    FineOnly   = true;
+    Start      = -1.0;
+    Stop       =  1.0;
+    Step       =  0.1;
+    Fine       =  0.01;
+    Window     =  0.1;
+    FineFrom   =  0.0;
+    FineTo     =  0.0;
+    MaxI       =  4.0e-3;
+    Settle     =  0.25;
+    Compliance = 0;
+    PlateauPoints = 3;
+    PlateauTol = 2.0e-3;
+    Direction  = 0;
+    Pulsed     = false;
+    PulseWidth = 0.05;
+    PulseOff   = 0.5;
+    PulseBase  = 0.0;
+    PulseDelay = 0.03;
+    DriftReference = 0.0;
+    DriftPoints    = 0;
+    DriftInterval  = 0.0;
+    DriftCorrect   = 0;
+    AutoRange  = false;
+    NoiseTarget = 1.0e-3;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Read
+ *
+ * Description : Keys from resources, absent keys keep their value.
+ *
+ * Inputs : env - resources
+ *
+ * Returns : true if the recipe makes sense
+ *
+ * Error Conditions : bad mode or steps
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Recipe::Read(TEnv *env)
+{
+    SET_DEBUG_STACK;
+    CLogger *log = CLogger::GetThis();
+
+    Mode       = env->GetValue("IVCurve.Mode",           (int) Mode);
+    Resistance = env->GetValue("IVCurve.Resistance",     Resistance);
+    NAVG       = env->GetValue("IVCurve.Average",        (int) NAVG);
+    FineOnly   = env->GetValue("IVCurve.FINE_ONLY",      (int) FineOnly);
+    Start      = env->GetValue("VoltageSource.Start",    Start);
+    Stop       = env->GetValue("VoltageSource.Stop",     Stop);
+    Step       = env->GetValue("VoltageSource.Step",     Step);
+    Fine       = env->GetValue("VoltageSource.FineStep", Fine);
+    Window     = env->GetValue("VoltageSource.Window",   Window);
+    FineFrom   = env->GetValue("VoltageSource.FineFrom", FineFrom);
+    FineTo     = env->GetValue("VoltageSource.FineTo",   FineTo);
+    MaxI       = env->GetValue("VoltageSource.MaxI",     MaxI);
+    Settle     = env->GetValue("VoltageSource.Settle",   Settle);
+    Compliance = env->GetValue("VoltageSource.Compliance", (int) Compliance);
+    PlateauPoints = env->GetValue("VoltageSource.PlateauPoints",
+				  (int) PlateauPoints);
+    PlateauTol = env->GetValue("VoltageSource.PlateauTolerance", PlateauTol);
+    Direction  = env->GetValue("VoltageSource.Direction", (int) Direction);
+    Pulsed     = env->GetValue("VoltageSource.Pulsed",   (int) Pulsed);
+    PulseWidth = env->GetValue("VoltageSource.PulseWidth", PulseWidth);
+    PulseOff   = env->GetValue("VoltageSource.PulseOff", PulseOff);
+    PulseBase  = env->GetValue("VoltageSource.PulseBase", PulseBase);
+    PulseDelay = env->GetValue("VoltageSource.PulseDelay", PulseDelay);
+    DriftReference = env->GetValue("VoltageSource.DriftReference",
+				   DriftReference);
+    DriftPoints    = env->GetValue("VoltageSource.DriftPoints",
+				   (int) DriftPoints);
+    DriftInterval  = env->GetValue("VoltageSource.DriftInterval",
+				   DriftInterval);
+    DriftCorrect   = env->GetValue("VoltageSource.DriftCorrect",
+				   (int) DriftCorrect);
+    AutoRange  = env->GetValue("Voltmeter.AutoRange",   (int) AutoRange);
+    NoiseTarget = env->GetValue("Voltmeter.NoiseTarget", NoiseTarget);
+    Comment    = env->GetValue("Recipe.Comment",         Comment.c_str());
+    Output     = env->GetValue("Recipe.Output",          Output.c_str());
+    Part       = env->GetValue("IVCurve.PartNumber",     Part.c_str());
+
+    if (Mode > 3)
+    {
+	log->Log("# Recipe: mode %d out of range.\n", (int) Mode);
+	return false;
+    }
+    if (Compliance > Instruments::kComplianceCoarse)
+    {
+	log->Log("# Recipe: compliance policy %d out of range.\n",
+		 (int) Compliance);
+	return false;
+    }
+    if ((Fine <= 0.0) || (!FineOnly && (Step <= 0.0)))
+    {
+	log->Log("# Recipe: steps must be positive.\n");
+	return false;
+    }
+    if (FineTo < FineFrom)
+    {
+	log->Log("# Recipe: fine band %g to %g V is backwards.\n",
+		 FineFrom, FineTo);
+	return false;
+    }
+    if (Direction > Instruments::kSweepInterleaved)
+    {
+	log->Log("# Recipe: direction %d out of range.\n", (int) Direction);
+	return false;
+    }
+    if (Pulsed && ((PulseWidth < kMinDwell) || (PulseOff < kMinDwell) ||
+		   (PulseDelay <= 0.0) || (PulseDelay >= PulseWidth)))
+    {
+	log->Log("# Recipe: pulse %g s, delay %g s, off %g s will not do.\n",
+		 PulseWidth, PulseDelay, PulseOff);
+	return false;
+    }
+    if ((DriftInterval < 0.0) || (DriftCorrect > 2))
+    {
+	log->Log("# Recipe: drift interval %g s, correction %d will not do.\n",
+		 DriftInterval, (int) DriftCorrect);
+	return false;
+    }
+    if ((DriftCorrect == 2) && (fabs(DriftReference) < kMinGainReference))
+    {
+	// The gain is a ratio to the reference reading, at 0 V noise.
+	log->Log("# Recipe: gain correction needs a reference away from 0 V,"
+		 " %g V will not do.\n", DriftReference);
+	return false;
+    }
+    if (NoiseTarget <= 0.0)
+    {
+	log->Log("# Recipe: noise target %g must be positive.\n", 
+		 NoiseTarget);
+	return false;
+    }
+    if ((Mode == 2) && (Resistance <= 0.0))
+    {
+	log->Log("# Recipe: no resistance for mode 2.\n");
+	return false;
+    }
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Read
+ *
+ * Description : Keys from a file in TEnv format.
+ *
+ * Inputs : File - recipe file
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file missing, bad recipe
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Recipe::Read(const char *File)
+{
+    SET_DEBUG_STACK;
+    TEnv env("");
+
+    if (gSystem->AccessPathName(File))
+    {
+	CLogger::GetThis()->Log("# Recipe: can not read %s\n", File);
+	return false;
+    }
+    env.ReadFile(File, kEnvLocal);
+    return Read(&env);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Write
+ *
+ * Description : All keys into resources.
+ *
+ * Inputs : env - resources
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Recipe::Write(TEnv *env) const
+{
+    SET_DEBUG_STACK;
+    env->SetValue("IVCurve.Mode",           (int) Mode);
+    env->SetValue("IVCurve.Resistance",     Resistance);
+    env->SetValue("IVCurve.Average",        (int) NAVG);
+    env->SetValue("IVCurve.FINE_ONLY",      (bool) FineOnly);
+    env->SetValue("VoltageSource.Start",    Start);
+    env->SetValue("VoltageSource.Stop",     Stop);
+    env->SetValue("VoltageSource.Step",     Step);
+    env->SetValue("VoltageSource.FineStep", Fine);
+    env->SetValue("VoltageSource.Window",   Window);
+    env->SetValue("VoltageSource.FineFrom", FineFrom);
+    env->SetValue("VoltageSource.FineTo",   FineTo);
+    env->SetValue("VoltageSource.MaxI",     MaxI);
+    env->SetValue("VoltageSource.Settle",   Settle);
+    env->SetValue("VoltageSource.Compliance", (int) Compliance);
+    env->SetValue("VoltageSource.PlateauPoints", (int) PlateauPoints);
+    env->SetValue("VoltageSource.PlateauTolerance", PlateauTol);
+    env->SetValue("VoltageSource.Direction", (int) Direction);
+    env->SetValue("VoltageSource.Pulsed",   (bool) Pulsed);
+    env->SetValue("VoltageSource.PulseWidth", PulseWidth);
+    env->SetValue("VoltageSource.PulseOff", PulseOff);
+    env->SetValue("VoltageSource.PulseBase", PulseBase);
+    env->SetValue("VoltageSource.PulseDelay", PulseDelay);
+    env->SetValue("VoltageSource.DriftReference", DriftReference);
+    env->SetValue("VoltageSource.DriftPoints",    (int) DriftPoints);
+    env->SetValue("VoltageSource.DriftInterval",  DriftInterval);
+    env->SetValue("VoltageSource.DriftCorrect",   (int) DriftCorrect);
+    env->SetValue("Voltmeter.AutoRange",   (bool) AutoRange);
+    env->SetValue("Voltmeter.NoiseTarget", NoiseTarget);
+    if (!Comment.empty())
+    {
+	env->SetValue("Recipe.Comment",     Comment.c_str());
+    }
+    if (!Output.empty())
+    {
+	env->SetValue("Recipe.Output",      Output.c_str());
+    }
+    if (!Part.empty())
+    {
+	env->SetValue("IVCurve.PartNumber", Part.c_str());
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Apply
+ *
+ * Description : Set the instruments up for this sweep.
+ *
+ * Inputs : inst - instruments
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Recipe::Apply(Instruments *inst) const
+{
+    SET_DEBUG_STACK;
+    inst->Start(Start);
+    inst->Stop( Stop);
+    inst->Step( Step);
+    inst->Fine( Fine);
+    inst->Window(Window);
+    inst->FineBand(FineFrom, FineTo);
+    inst->SettleTime(Settle);
+    inst->SetCurrentLimit(MaxI);
+    inst->FineOnly(FineOnly);
+    inst->NAVG(NAVG);
+    inst->Policy(Compliance);
+    inst->SenseResistance((Mode == 2) ? Resistance : 0.0);
+    inst->PlateauPoints(PlateauPoints);
+    inst->PlateauTolerance(PlateauTol);
+    inst->Direction(Direction);
+    inst->Pulsed(Pulsed);
+    inst->PulseWidth(PulseWidth);
+    inst->PulseOff(PulseOff);
+    inst->PulseBase(PulseBase);
+    inst->PulseDelay(PulseDelay);
+    inst->DriftReference(DriftReference);
+    inst->DriftEvery(DriftPoints);
+    inst->DriftInterval(DriftInterval);
+    inst->DriftCorrect(DriftCorrect);
+    inst->AutoRange(AutoRange);
+    inst->NoiseTarget(NoiseTarget);
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : From
+ *
+ * Description : Sweep settings as they are on the instruments, the
+ *               parameter dialog changes them there.
+ *
+ * Inputs : inst - instruments
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void Recipe::From(const Instruments *inst)
+{
+    Start    = inst->Start();
+    Stop     = inst->Stop();
+    Step     = inst->Step();
+    Fine     = inst->Fine();
+    Window   = inst->Window();
+    FineFrom = inst->FineFrom();
+    FineTo   = inst->FineTo();
+    Settle   = inst->SettleTime();
+    MaxI     = inst->CurrentLimit();
+    FineOnly = inst->FineOnly();
+    NAVG     = inst->NAVG();
+    Compliance    = inst->Policy();
+    PlateauPoints = inst->PlateauPoints();
+    PlateauTol    = inst->PlateauTolerance();
+    Direction     = inst->Direction();
+    Pulsed        = inst->Pulsed();
+    PulseWidth    = inst->PulseWidth();
+    PulseOff      = inst->PulseOff();
+    PulseBase     = inst->PulseBase();
+    PulseDelay    = inst->PulseDelay();
+    DriftReference = inst->DriftReference();
+    DriftPoints    = inst->DriftEvery();
+    DriftInterval  = inst->DriftInterval();
+    DriftCorrect   = inst->DriftCorrect();
+    AutoRange     = inst->AutoRange();
+    NoiseTarget   = inst->NoiseTarget();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Set
+ *
+ * Description : Change one setting by name. The change is read into
+ *               a copy through Read so it is checked the same way a
+ *               file would be.
+ *
+ * Inputs : Key   - resource name
+ *          Value - as text
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : unknown key, result does not validate.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool Recipe::Set(const char *Key, const char *Value)
+{
+    SET_DEBUG_STACK;
+    static const char *Keys[] = {
+	"IVCurve.Mode", "IVCurve.Resistance", "IVCurve.Average",
+	"IVCurve.FINE_ONLY", "VoltageSource.Start", "VoltageSource.Stop",
+	"VoltageSource.Step", "VoltageSource.FineStep", 
+	"VoltageSource.Window", "VoltageSource.FineFrom",
+	"VoltageSource.FineTo", "VoltageSource.MaxI", 
+	"VoltageSource.Settle", "VoltageSource.Compliance",
+	"VoltageSource.PlateauPoints", "VoltageSource.PlateauTolerance",
+	"VoltageSource.Direction",
+	"VoltageSource.Pulsed", "VoltageSource.PulseWidth",
+	"VoltageSource.PulseOff", "VoltageSource.PulseBase",
+	"VoltageSource.PulseDelay",
+	"VoltageSource.DriftReference", "VoltageSource.DriftPoints",
+	"VoltageSource.DriftInterval", "VoltageSource.DriftCorrect",
+	"Voltmeter.AutoRange", "Voltmeter.NoiseTarget",
+	"Recipe.Comment", "Recipe.Output", "IVCurve.PartNumber", NULL};
+    TEnv   env("");
+    Recipe r(*this);
+    size_t i;
+
+    for (i=0; Keys[i] && (strcmp(Keys[i], Key) != 0); i++);
+    if (Keys[i] == NULL)
+    {
+	CLogger::GetThis()->Log("# Recipe: no setting %s\n", Key);
+	return false;
+    }
+    env.SetValue(Key, Value);
+    if (!r.Read(&env))
+    {
+	return false;
+    }
+    *this = r;
+    SET_DEBUG_STACK;
+    return true;
+}
@@ -0,0 +1,175 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : Recipe.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Everything that describes one sweep, the mode, the
+ *               voltage steps, averaging, current limit and the 
+ *               comment. Read from and written to TEnv with the 
+ *               same keys as the .IVCurve resource file, so a recipe
+ *               file is just a resource file holding the keys that
+ *               differ. The GUI and the headless runner both set up
+ *               Instruments from here.
+ *
+ *               IVCurve.Mode           0 test, 1 V:V, 2 resistor, 3 I-V
+ *               IVCurve.Resistance     ohms, mode 2
+ *               IVCurve.Average        readings per point
+ *               IVCurve.FINE_ONLY      step fine everywhere
+ *               VoltageSource.Start    volts
+ *               VoltageSource.Stop
+ *               VoltageSource.Step     coarse step
+ *               VoltageSource.FineStep
+ *               VoltageSource.Window   fine step inside |V| < window
+ *               VoltageSource.FineFrom fine step from here
+ *               VoltageSource.FineTo   to here as well, equal for none
+ *               VoltageSource.MaxI     current limit, amps
+ *               VoltageSource.Settle   seconds after each step
+ *               VoltageSource.Compliance        0 continue, 1 end,
+ *                                      2 skip ahead, 3 coarse steps
+ *               VoltageSource.PlateauPoints     flat steps that mean
+ *                                      compliance, 0 limit test only
+ *               VoltageSource.PlateauTolerance  relative flatness
+ *               VoltageSource.Direction  0 up, 1 up and back down,
+ *                                        2 up and down interleaved
+ *               VoltageSource.Pulsed     pulse each point
+ *               VoltageSource.PulseWidth seconds at the step voltage
+ *               VoltageSource.PulseOff   seconds at base between
+ *               VoltageSource.PulseBase  volts between pulses
+ *               VoltageSource.PulseDelay seconds into the pulse to read
+ *               VoltageSource.DriftReference volts to go back to
+ *               VoltageSource.DriftPoints  points between references
+ *               VoltageSource.DriftInterval seconds between them, 
+ *                                      both 0 no drift tracking
+ *               VoltageSource.DriftCorrect  0 none, 1 offset, 2 gain,
+ *                                      gain needs a reference off 0 V
+ *               Voltmeter.AutoRange    leave the 196 range to itself
+ *               Voltmeter.NoiseTarget  resolution relative to the
+ *                                      reading, sets range and rate
+ *               Recipe.Comment         goes with the data
+ *               Recipe.Output          file for the data
+ *               IVCurve.PartNumber     kind of part, keys its profile
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __RECIPE_hh_
+#define __RECIPE_hh_
+#include <stdint.h>
+#include <string>
+
+class TEnv;
+class Instruments;
+
+/// One sweep worth of settings.
+struct Recipe {
+    uint8_t     Mode;
+    double      Resistance;
+    uint32_t    NAVG;
+    bool        FineOnly;
+    double      Start;
+    double      Stop;
+    double      Step;
+    double      Fine;
+    double      Window;
+    double      FineFrom;
+    double      FineTo;
+    double      MaxI;
+    double      Settle;
+    uint8_t     Compliance;
+    uint32_t    PlateauPoints;
+    double      PlateauTol;
+    uint8_t     Direction;
+    bool        Pulsed;
+    double      PulseWidth;
+    double      PulseOff;
+    double      PulseBase;
+    double      PulseDelay;
+    double      DriftReference;
+    uint32_t    DriftPoints;
+    double      DriftInterval;
+    uint8_t     DriftCorrect;
+    bool        AutoRange;
+    double      NoiseTarget;
+    std::string Comment;
+    std::string Output;
+    std::string Part;
+
+    /*! Defaults, the same as a missing .IVCurve. */
+    Recipe(void);
+
+    /*!
+     * Description:
+     *   Pick up the keys present in env, the rest keep their
+     *   present values. Reading a recipe file after the resource
+     *   file therefore overrides only what the recipe sets.
+     *
+     * Arguments:
+     *   env - resources
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   Mode out of range, a step that is not positive.
+     */
+    bool Read(TEnv *env);
+
+    /*! As above from a file in TEnv format. */
+    bool Read(const char *File);
+
+    /*!
+     * Description:
+     *   Change one setting by its resource name, as sent over the
+     *   control socket.
+     *
+     * Arguments:
+     *   Key   - resource name, VoltageSource.Stop for instance
+     *   Value - new value as text
+     *
+     * Returns:
+     *   true on success, otherwise the recipe is unchanged.
+     *
+     * Errors:
+     *   Not a recipe key, or the result would not validate.
+     */
+    bool Set(const char *Key, const char *Value);
+
+    /*! Put every key into env. */
+    void Write(TEnv *env) const;
+
+    /*!
+     * Description:
+     *   Configure the sweep on the instruments.
+     *
+     * Arguments:
+     *   inst - instruments, open
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Apply(Instruments *inst) const;
+
+    /*! Take the sweep settings back from the instruments. */
+    void From(const Instruments *inst);
+
+    /*! Readings against x are scaled by this, 1/R in mode 2. */
+    inline double XScale(void) const 
+	{return (Mode == 2) ? 1.0/Resistance : 1.0;};
+
+    /*! What the part profile is kept under, the comment if no part. */
+    inline const std::string& PartKey(void) const
+	{return Part.empty() ? Comment : Part;};
+};
+#endif
@@ -0,0 +1,315 @@
+/********************************************************************
+ *
+ * Module Name : RecipeQueue.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Queue of recipes with a checkpoint.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "RecipeQueue.hh"
+
+/* Longest line in a queue file. */
+const size_t kQueueLine = 1024;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : RecipeQueue constructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RecipeQueue::RecipeQueue(void)
+{
+    SET_DEBUG_STACK;
+    fNext   = 0;
+    fFailed = 0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Clear
+ *
+ * Description : Empty the queue.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void RecipeQueue::Clear(void)
+{
+    fRecipes.clear();
+    fFilename.clear();
+    fCheckpoint.clear();
+    fNext   = 0;
+    fFailed = 0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Load
+ *
+ * Description : Parse the queue file, read the recipes.
+ *
+ * Inputs : File - queue file
+ *          Base - starting recipe
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : missing or bad files
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RecipeQueue::Load(const char *File, const Recipe &Base)
+{
+    SET_DEBUG_STACK;
+    CLogger     *log = CLogger::GetThis();
+    FILE        *fp;
+    char        line[kQueueLine], name[kQueueLine], out[kQueueLine*2];
+    char        *p;
+    int         repeat, nf;
+    std::string dir, stem, path, rname;
+    size_t      slash, dot;
+    Recipe      r;
+
+    Clear();
+    if ((fp = fopen(File, "r")) == NULL)
+    {
+	log->Log("# RecipeQueue: can not open %s\n", File);
+	return false;
+    }
+    fFilename   = File;
+    fCheckpoint = fFilename + ".ckpt";
+    slash = fFilename.rfind('/');
+    dir   = (slash == std::string::npos) ? "" : fFilename.substr(0, slash+1);
+    stem  = fFilename.substr(dir.size());
+    if ((dot = stem.rfind('.')) != std::string::npos) stem.erase(dot);
+
+    while (fgets(line, sizeof(line), fp))
+    {
+	if ((p = strchr(line, '#')) != NULL) *p = 0;
+	repeat = 1;
+	nf = sscanf(line, "%1023s %d", name, &repeat);
+	if (nf < 1)
+	{
+	    continue;
+	}
+	path = (name[0] == '/') ? std::string(name) : dir + name;
+	r    = Base;
+	r.Output.clear();
+	if (!r.Read(path.c_str()))
+	{
+	    log->Log("# RecipeQueue: bad recipe %s\n", path.c_str());
+	    fclose(fp);
+	    Clear();
+	    return false;
+	}
+	rname = name;
+	if ((slash = rname.rfind('/')) != std::string::npos) 
+	    rname.erase(0, slash+1);
+	if ((dot = rname.rfind('.')) != std::string::npos) rname.erase(dot);
+	for (int k=0; k<repeat; k++)
+	{
+	    fRecipes.push_back(r);
+	    if (r.Output.empty())
+	    {
+		snprintf(out, sizeof(out), "%s%s_%04d_%s.csv", dir.c_str(),
+			 stem.c_str(), (int) fRecipes.size()-1, rname.c_str());
+		fRecipes.back().Output = out;
+	    }
+	    else if (repeat > 1)
+	    {
+		// Each repeat gets its own file, out_0000.csv and on.
+		std::string &o = fRecipes.back().Output;
+		slash = o.rfind('/');
+		dot   = o.rfind('.');
+		if ((dot == std::string::npos) || 
+		    ((slash != std::string::npos) && (dot < slash)))
+		    dot = o.size();
+		snprintf(out, sizeof(out), "_%04d", k);
+		o.insert(dot, out);
+	    }
+	}
+    }
+    fclose(fp);
+    ReadCheckpoint();
+    log->Log("# RecipeQueue: %s, %d sweeps, starting at %d.\n", File,
+	     (int) fRecipes.size(), (int) fNext);
+    SET_DEBUG_STACK;
+    return !fRecipes.empty();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadCheckpoint
+ *
+ * Description : Pick up the position of an interrupted run. 
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : no checkpoint, start at the top.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void RecipeQueue::ReadCheckpoint(void)
+{
+    FILE     *fp = fopen(fCheckpoint.c_str(), "r");
+    unsigned next = 0, failed = 0, n = 0;
+
+    fNext   = 0;
+    fFailed = 0;
+    if (fp == NULL)
+    {
+	return;
+    }
+    if ((fscanf(fp, "next %u failed %u of %u", &next, &failed, &n) == 3) &&
+	(n == fRecipes.size()) && (next <= n))
+    {
+	fNext   = next;
+	fFailed = failed;
+    }
+    else
+    {
+	CLogger::GetThis()->Log("# RecipeQueue: %s does not match the queue, starting over.\n",
+				fCheckpoint.c_str());
+    }
+    fclose(fp);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : WriteCheckpoint
+ *
+ * Description : Save the position, temporary file then rename.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : write failed
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RecipeQueue::WriteCheckpoint(void) const
+{
+    std::string tmp = fCheckpoint + ".tmp";
+    FILE        *fp = fopen(tmp.c_str(), "w");
+
+    if (fp == NULL)
+    {
+	CLogger::GetThis()->Log("# RecipeQueue: can not write %s\n", 
+				tmp.c_str());
+	return false;
+    }
+    fprintf(fp, "next %u failed %u of %u\n", fNext, fFailed, 
+	    (unsigned) fRecipes.size());
+    if ((fclose(fp) != 0) || (rename(tmp.c_str(), fCheckpoint.c_str()) != 0))
+    {
+	CLogger::GetThis()->Log("# RecipeQueue: error writing %s\n", 
+				fCheckpoint.c_str());
+	return false;
+    }
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Advance
+ *
+ * Description : Step past the current sweep.
+ *
+ * Inputs : ok - it completed
+ *
+ * Returns : true if the checkpoint was written
+ *
+ * Error Conditions : write failed
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RecipeQueue::Advance(bool ok)
+{
+    SET_DEBUG_STACK;
+    if (Finished())
+    {
+	return true;
+    }
+    if (!ok)
+    {
+	fFailed++;
+    }
+    fNext++;
+    if (Finished())
+    {
+	CLogger::GetThis()->Log("# RecipeQueue: %s done, %d of %d failed.\n",
+				fFilename.c_str(), (int) fFailed,
+				(int) fRecipes.size());
+	unlink(fCheckpoint.c_str());
+	return true;
+    }
+    return WriteCheckpoint();
+}
@@ -0,0 +1,110 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : RecipeQueue.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : A list of recipes to sweep back to back, for 
+ *               unattended runs. The queue file has one recipe file
+ *               per line, names relative to the queue file, with an
+ *               optional repeat count. # starts a comment.
+ *
+ *                   # overnight characterization
+ *                   forward.rcp   50
+ *                   reverse.rcp   10
+ *
+ *               Each recipe is read on top of a base recipe, the
+ *               resources in use when the queue is loaded, so a
+ *               recipe file only holds what changes. A recipe with
+ *               no Recipe.Output gets queue_NNNN_recipe.csv next to
+ *               the queue file. A repeated recipe that does name its
+ *               Output gets the repeat added, out_NNNN.csv.
+ *
+ *               The position in the queue is checkpointed to
+ *               queue.ckpt after every sweep, written to a temporary
+ *               file and renamed so it is never half written.
+ *               Loading the queue again picks up where it left off,
+ *               the checkpoint is removed when the queue finishes.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __RECIPEQUEUE_hh_
+#define __RECIPEQUEUE_hh_
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Recipe.hh"
+
+/// RecipeQueue documentation here.
+class RecipeQueue {
+public:
+    RecipeQueue(void);
+
+    /*!
+     * Description:
+     *   Read the queue file and every recipe in it, then the
+     *   checkpoint if there is one.
+     *
+     * Arguments:
+     *   File - queue file
+     *   Base - settings the recipes are read on top of
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   Queue file or a recipe missing or bad. Nothing is queued.
+     */
+    bool Load(const char *File, const Recipe &Base);
+
+    /*! Number of sweeps in the queue, repeats counted. */
+    inline uint32_t N(void)        const {return fRecipes.size();};
+    /*! Index of the sweep to run next. */
+    inline uint32_t Next(void)     const {return fNext;};
+    /*! Sweeps that did not complete. */
+    inline uint32_t NFailed(void)  const {return fFailed;};
+    inline bool     Finished(void) const {return fNext >= fRecipes.size();};
+    /*! Recipe to run next, only valid if not Finished. */
+    inline const Recipe& Current(void) const {return fRecipes[fNext];};
+    inline const Recipe& Entry(uint32_t i) const {return fRecipes[i];};
+    inline const std::string& Filename(void) const {return fFilename;};
+
+    /*!
+     * Description:
+     *   The current sweep is over, move on and checkpoint. When the
+     *   last one is done the checkpoint is removed.
+     *
+     * Arguments:
+     *   ok - the sweep completed
+     *
+     * Returns:
+     *   true if the checkpoint was written
+     *
+     * Errors:
+     *   Checkpoint could not be written.
+     */
+    bool Advance(bool ok);
+
+    /*! Forget the queue, the checkpoint stays. */
+    void Clear(void);
+
+private:
+    bool WriteCheckpoint(void) const;
+    void ReadCheckpoint(void);
+
+    std::string         fFilename;
+    std::string         fCheckpoint;
+    std::vector<Recipe> fRecipes;
+    uint32_t            fNext;
+    uint32_t            fFailed;
+};
+#endif
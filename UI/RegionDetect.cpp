@@ -0,0 +1,347 @@
+/********************************************************************
+ *
+ * Module Name : RegionDetect.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Segment an I-V curve into its operating regions.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+#include <algorithm>
+
+// Local Includes.
+#include "debug.h"
+#include "RegionDetect.hh"
+
+/* Boltzmann constant over electron charge, V/K */
+const double kBoltzmannOverQ = 8.617333262e-5;
+
+/* The exponential region holds the slope to this fraction of its peak. */
+const double kExpFraction = 0.85;
+
+/* No point below this many kT/q can be in the exponential region. */
+const double kExpMinVt = 3.0;
+
+/* |I| within this fraction of the limit is in compliance. */
+const double kComplianceFraction = 0.98;
+
+/* Without a known limit, a top run flat to this fraction. */
+const double kComplianceFlat = 2.0e-3;
+
+/* Fewest points we will call an exponential region. */
+const uint32_t kMinExpPoints = 5;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : RegionDetect constructor
+ *
+ * Description :
+ *
+ * Inputs : Temperature - Kelvin
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RegionDetect::RegionDetect(double Temperature)
+{
+    SET_DEBUG_STACK;
+    fTemperature = Temperature;
+    fLimit       = 0.0;
+    fMaxSlope    = 0.0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Name
+ *
+ * Description : Printable region name.
+ *
+ * Inputs : k - region
+ *
+ * Returns : name
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+const char* RegionDetect::Name(Kind k)
+{
+    static const char *names[] = {"Reverse", "LowForward", "Exponential",
+				  "Series", "Compliance", "Unknown"};
+    return names[(k < kNKinds) ? k : kNKinds];
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Analyze
+ *
+ * Description : 
+ *   1. Order the points by voltage.
+ *   2. Compliance: at the known limit, or failing that the flat run
+ *      of largest |I| at the top of the sweep.
+ *   3. Reverse: V <= 0 (or I <= 0, there is no log to take).
+ *   4. Local slope of ln(I) over the remaining forward points,
+ *      least squares over +/- h neighbours from prefix sums.
+ *   5. Peak slope above kExpMinVt kT/q, grow the exponential region
+ *      either side while the slope stays above kExpFraction of it.
+ *      Forward points below are low forward, above are series.
+ *   6. Collapse the per point labels into regions.
+ *
+ * Inputs : V, I - data
+ *          N    - number of points
+ *
+ * Returns : true if there is an exponential region
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RegionDetect::Analyze(const double *V, const double *I, uint32_t N)
+{
+    SET_DEBUG_STACK;
+    const double Vt = kBoltzmannOverQ*fTemperature;
+    std::vector<uint32_t> fwd;             // forward points, V order
+    std::vector<double>   Sx, Sy, Sxx, Sxy; // prefix sums over fwd
+    uint32_t i, k, nf, h, lo, hi, peak = 0, cnt;
+    double   Imax = 0.0, x, y, det;
+    Region   r;
+
+    fRegions.clear();
+    fMaxSlope = 0.0;
+    if (N == 0)
+    {
+	return false;
+    }
+    fOrder.resize(N);
+    fKind.assign(N, kReverse);
+    for (i=0; i<N; i++) fOrder[i] = i;
+    std::stable_sort(fOrder.begin(), fOrder.end(),
+		     [V](uint32_t a, uint32_t b) {return V[a] < V[b];});
+
+    // Compliance.
+    for (i=0; i<N; i++) Imax = fmax(Imax, fabs(I[i]));
+    if (fLimit > 0.0)
+    {
+	for (i=0; i<N; i++)
+	{
+	    if (fabs(I[fOrder[i]]) >= kComplianceFraction*fLimit)
+		fKind[i] = kCompliance;
+	}
+    }
+    else
+    {
+	// Walk down from the top while the current stays flat.
+	cnt = 0;
+	for (k=N; k-- > 0;)
+	{
+	    if (fabs(fabs(I[fOrder[k]]) - Imax) > kComplianceFlat*Imax)
+		break;
+	    cnt++;
+	}
+	if (cnt >= 3)
+	{
+	    for (k=N-cnt; k<N; k++) fKind[k] = kCompliance;
+	}
+    }
+
+    // Forward points.
+    for (i=0; i<N; i++)
+    {
+	if ((fKind[i] != kCompliance) && (V[fOrder[i]] > 0.0) && 
+	    (I[fOrder[i]] > 0.0))
+	{
+	    fKind[i] = kLowForward;
+	    fwd.push_back(i);
+	}
+    }
+    nf = fwd.size();
+
+    if (nf >= kMinExpPoints)
+    {
+	// Prefix sums for windowed least squares slopes.
+	Sx.assign(nf+1, 0.0); Sy.assign(nf+1, 0.0);
+	Sxx.assign(nf+1, 0.0); Sxy.assign(nf+1, 0.0);
+	for (k=0; k<nf; k++)
+	{
+	    x = V[fOrder[fwd[k]]];
+	    y = log(I[fOrder[fwd[k]]]);
+	    Sx[k+1]  = Sx[k]  + x;
+	    Sy[k+1]  = Sy[k]  + y;
+	    Sxx[k+1] = Sxx[k] + x*x;
+	    Sxy[k+1] = Sxy[k] + x*y;
+	}
+	h = std::max<uint32_t>(2, nf/50);
+	fSlope.assign(nf, 0.0);
+	for (k=0; k<nf; k++)
+	{
+	    lo  = (k > h) ? k - h : 0;
+	    hi  = std::min(nf, k + h + 1);
+	    cnt = hi - lo;
+	    det = cnt*(Sxx[hi]-Sxx[lo]) - (Sx[hi]-Sx[lo])*(Sx[hi]-Sx[lo]);
+	    if (det > 0.0)
+	    {
+		fSlope[k] = (cnt*(Sxy[hi]-Sxy[lo]) - 
+			     (Sx[hi]-Sx[lo])*(Sy[hi]-Sy[lo]))/det;
+	    }
+	    if ((V[fOrder[fwd[k]]] > kExpMinVt*Vt) && (fSlope[k] > fMaxSlope))
+	    {
+		fMaxSlope = fSlope[k];
+		peak      = k;
+	    }
+	}
+	if (fMaxSlope > 0.0)
+	{
+	    lo = hi = peak;
+	    while ((lo > 0) && (fSlope[lo-1] >= kExpFraction*fMaxSlope) &&
+		   (V[fOrder[fwd[lo-1]]] > kExpMinVt*Vt)) lo--;
+	    while ((hi+1 < nf) && (fSlope[hi+1] >= kExpFraction*fMaxSlope))
+		hi++;
+	    for (k=lo; k<=hi; k++) fKind[fwd[k]] = kExponential;
+	    for (k=hi+1; k<nf; k++) fKind[fwd[k]] = kSeries;
+	}
+    }
+
+    // Collapse into regions.
+    for (i=0; i<N; i++)
+    {
+	x = V[fOrder[i]];
+	if (fRegions.empty() || (fRegions.back().Type != fKind[i]))
+	{
+	    r.Type    = (Kind) fKind[i];
+	    r.NPoints = 0;
+	    r.Vlo     = x;
+	    fRegions.push_back(r);
+	}
+	fRegions.back().NPoints++;
+	fRegions.back().Vhi = x;
+    }
+    SET_DEBUG_STACK;
+    return (fMaxSlope > 0.0);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Window
+ *
+ * Description : Voltage window for a fit. The Shockley fit gets the
+ *               largest exponential region, the full model every 
+ *               forward region short of compliance.
+ *
+ * Inputs : Full     - which fit
+ *          Vlo, Vhi - output
+ *
+ * Returns : true if there is a window with enough points.
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RegionDetect::Window(bool Full, double &Vlo, double &Vhi) const
+{
+    double   lo = HUGE_VAL, hi = -HUGE_VAL;
+    uint32_t n = 0, best = 0;
+
+    for (size_t k=0; k<fRegions.size(); k++)
+    {
+	const Region &r = fRegions[k];
+	if (Full)
+	{
+	    if ((r.Type == kLowForward) || (r.Type == kExponential) ||
+		(r.Type == kSeries))
+	    {
+		lo = fmin(lo, r.Vlo);
+		hi = fmax(hi, r.Vhi);
+		n += r.NPoints;
+	    }
+	}
+	else if ((r.Type == kExponential) && (r.NPoints > best))
+	{
+	    best = n = r.NPoints;
+	    lo   = r.Vlo;
+	    hi   = r.Vhi;
+	}
+    }
+    if (n < kMinExpPoints)
+    {
+	return false;
+    }
+    Vlo = lo;
+    Vhi = hi;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Select
+ *
+ * Description : Points with Vlo <= V <= Vhi.
+ *
+ * Inputs : V, I     - data
+ *          N        - number of points
+ *          Vlo, Vhi - window
+ *          v, i     - output
+ *
+ * Returns : number of points
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t RegionDetect::Select(const double *V, const double *I, uint32_t N,
+			      double Vlo, double Vhi,
+			      std::vector<double> &v, std::vector<double> &i)
+{
+    v.clear();
+    i.clear();
+    for (uint32_t k=0; k<N; k++)
+    {
+	if ((V[k] >= Vlo) && (V[k] <= Vhi))
+	{
+	    v.push_back(V[k]);
+	    i.push_back(I[k]);
+	}
+    }
+    return v.size();
+}
@@ -0,0 +1,148 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : RegionDetect.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Split an I-V curve into the regions a diode goes
+ *               through and hand out the voltage windows each fit
+ *               should look at.
+ *
+ *               Reverse     - V <= 0, leakage.
+ *               Low forward - V > 0 below the exponential, shunt and
+ *                             recombination current.
+ *               Exponential - steepest ln(I) against V, the Shockley
+ *                             region.
+ *               Series      - above the exponential where Rs bends
+ *                             ln(I) over.
+ *               Compliance  - the source hit its current limit, the
+ *                             points say nothing about the diode.
+ *
+ *               The tests are cheap. The slope of ln(I) against V is
+ *               a least squares over a few neighbouring points, from
+ *               running sums so the whole pass is O(N). The
+ *               exponential region is the run of points around the
+ *               steepest slope that stay within kExpFraction (85%)
+ *               of it.
+ *               Compliance is any |I| at the known limit, or if the
+ *               limit is not known a flat run at the very top.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __REGIONDETECT_hh_
+#define __REGIONDETECT_hh_
+#include <stdint.h>
+#include <vector>
+
+/// RegionDetect documentation here.
+class RegionDetect {
+public:
+    enum Kind {kReverse=0, kLowForward, kExponential, kSeries,
+	       kCompliance, kNKinds};
+
+    /// One contiguous region, in voltage order.
+    struct Region {
+	Kind     Type;
+	uint32_t NPoints;
+	double   Vlo, Vhi;
+    };
+
+    /*!
+     * Description:
+     *   Create a detector.
+     *
+     * Arguments:
+     *   Temperature - junction temperature, Kelvin
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    RegionDetect(double Temperature = 293.15);
+
+    /*!
+     * Description:
+     *   Segment a curve. The points need not be in voltage order.
+     *
+     * Arguments:
+     *   V, I - data
+     *   N    - number of points
+     *
+     * Returns:
+     *   true if an exponential region was found.
+     *
+     * Errors:
+     *   Too few forward points.
+     */
+    bool Analyze(const double *V, const double *I, uint32_t N);
+
+    /*!
+     * Description:
+     *   Voltage window for a fit, from the last Analyze.
+     *
+     * Arguments:
+     *   Full     - false for the Shockley fit, just the exponential
+     *              region. true for the full model, all the forward
+     *              points short of compliance.
+     *   Vlo, Vhi - window returned.
+     *
+     * Returns:
+     *   false if there is no usable window, Vlo and Vhi untouched.
+     *
+     * Errors:
+     *   NONE
+     */
+    bool Window(bool Full, double &Vlo, double &Vhi) const;
+
+    /*!
+     * Description:
+     *   Copy the points inside a window.
+     *
+     * Arguments:
+     *   V, I     - data
+     *   N        - number of points
+     *   Vlo, Vhi - window
+     *   v, i     - points inside, replaces any contents.
+     *
+     * Returns:
+     *   number of points copied
+     *
+     * Errors:
+     *   NONE
+     */
+    static uint32_t Select(const double *V, const double *I, uint32_t N,
+			   double Vlo, double Vhi,
+			   std::vector<double> &v, std::vector<double> &i);
+
+    /*! Source current limit, 0 if unknown. */
+    inline void   Compliance(double Limit) {fLimit = Limit;};
+    inline void   Temperature(double K) {fTemperature = K;};
+
+    inline const std::vector<Region>& Regions(void) const {return fRegions;};
+    /*! Steepest ln(I) slope found, 1/(n Vt). */
+    inline double MaxSlope(void) const {return fMaxSlope;};
+    static const char* Name(Kind k);
+
+private:
+    double              fTemperature;
+    double              fLimit;
+    double              fMaxSlope;
+    std::vector<Region> fRegions;
+
+    // Scratch, in voltage order.
+    std::vector<uint32_t> fOrder;
+    std::vector<uint8_t>  fKind;
+    std::vector<double>   fSlope;
+};
+#endif
@@ -0,0 +1,313 @@
+/********************************************************************
+ *
+ * Module Name : RunCache.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Cache of parsed runs and their graphics for the
+ *               overlay display.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+
+/// Root Includes
+#include <TGraph.h>
+#include <TColor.h>
+#include <TSystem.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "RunCache.hh"
+#include "SweepFile.hh"
+#include "MinMaxPyramid.hh"
+
+/*
+ * Overlay graphs are first built from the envelope at this many 
+ * pixel columns across the full range of the run.
+ */
+const uint32_t kOverlayColumns = 1024;
+
+/* Colors to cycle through for the runs. */
+static const Color_t kRunColors[] = {
+    kBlack, kRed, kBlue, kGreen+2, kMagenta, kCyan+2, kOrange+7,
+    kViolet+1, kAzure+2, kPink+9, kSpring-5, kGray+2 };
+static const size_t kNRunColors = sizeof(kRunColors)/sizeof(Color_t);
+
+/**
+ ******************************************************************
+ *
+ * Function Name : RunCache constructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RunCache::RunCache(void)
+{
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : RunCache destructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RunCache::~RunCache(void)
+{
+    SET_DEBUG_STACK;
+    Clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Clear
+ *
+ * Description : Delete all runs and their graphs.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void RunCache::Clear(void)
+{
+    SET_DEBUG_STACK;
+    for (size_t i=0; i<fRuns.size(); i++)
+    {
+	delete fRuns[i]->Graph;
+	delete fRuns[i];
+    }
+    fRuns.clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Read and parse a run, unless we already have it.
+ *               The points are kept in single precision, that is
+ *               plenty for display.
+ *
+ * Inputs : Filename - sweep file
+ *
+ * Returns : index of the run, -1 on error.
+ *
+ * Error Conditions : file could not be read.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+int RunCache::Add(const char *Filename)
+{
+    SET_DEBUG_STACK;
+    std::vector<double> x, y;
+    std::string         comment;
+    Run                 *run;
+
+    for (size_t i=0; i<fRuns.size(); i++)
+    {
+	if (fRuns[i]->File == Filename)
+	{
+	    return (int) i;
+	}
+    }
+    if (!SweepFile::Read(Filename, x, y, &comment))
+    {
+	return -1;
+    }
+
+    run          = new Run;
+    run->File    = Filename;
+    run->Label   = gSystem->BaseName(Filename);
+    if (!comment.empty() && (comment != "NONE"))
+    {
+	run->Label += " ";
+	run->Label += comment;
+    }
+    run->x.assign(x.begin(), x.end());
+    run->y.assign(y.begin(), y.end());
+    run->Pyramid.Update(&run->x[0], &run->y[0], run->x.size());
+    run->Graph   = NULL;
+    run->Visible = true;
+    fRuns.push_back(run);
+
+    CLogger::GetThis()->Log("# RunCache: %s, %d points.\n", Filename,
+			    (int) x.size());
+    SET_DEBUG_STACK;
+    return (int) fRuns.size() - 1;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Graph
+ *
+ * Description : Return the graph for a run, making it the first
+ *               time. The graph is the min/max envelope of the run
+ *               so it never has more than a few thousand points.
+ *
+ * Inputs : i - run index
+ *
+ * Returns : graph or NULL
+ *
+ * Error Conditions : index out of range.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+TGraph* RunCache::Graph(size_t i)
+{
+    SET_DEBUG_STACK;
+    Run           *run;
+    TGraph        *g;
+    char          name[32];
+
+    if (i >= fRuns.size())
+    {
+	return NULL;
+    }
+    run = fRuns[i];
+    if (run->Graph)
+    {
+	return run->Graph;
+    }
+
+    g = new TGraph();
+    run->Graph = g;
+    // Full range, the pyramid widens it by a point either side.
+    Refine(i, -1.0e30, 1.0e30, kOverlayColumns);
+
+    sprintf(name, "Run%d", (int) i);
+    g->SetName(name);
+    g->SetTitle(run->Label.c_str());
+    g->SetLineColor(kRunColors[i % kNRunColors]);
+    g->SetMarkerColor(kRunColors[i % kNRunColors]);
+    g->SetMarkerStyle(20 + (i/kNRunColors) % 14);
+    g->SetMarkerSize(0.5);
+    SET_DEBUG_STACK;
+    return g;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Refine
+ *
+ * Description : Fill the graph of a run with its envelope over the
+ *               range on show. A run with no graph yet is left to
+ *               Graph.
+ *
+ * Inputs : i      - run index
+ *          lo, hi - x range
+ *          pixels - pixel columns
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : index out of range.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void RunCache::Refine(size_t i, double lo, double hi, uint32_t pixels)
+{
+    SET_DEBUG_STACK;
+    Run      *run;
+    uint32_t n;
+
+    if ((i >= fRuns.size()) || (fRuns[i]->Graph == NULL))
+    {
+	return;
+    }
+    run = fRuns[i];
+    run->Graph->Set(MinMaxPyramid::MaxOut(pixels));
+    n = run->Pyramid.Envelope(&run->x[0], &run->y[0], lo, hi, pixels,
+			      run->Graph->GetX(), run->Graph->GetY());
+    run->Graph->Set(n);
+    SET_DEBUG_STACK;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : NVisible
+ *
+ * Description : Count the runs turned on.
+ *
+ * Inputs : NONE
+ *
+ * Returns : number of visible runs
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+size_t RunCache::NVisible(void) const
+{
+    size_t n = 0;
+    for (size_t i=0; i<fRuns.size(); i++)
+    {
+	if (fRuns[i]->Visible) n++;
+    }
+    return n;
+}
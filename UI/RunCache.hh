@@ -0,0 +1,117 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : RunCache.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Hold many runs for overlay display. Each file is
+ *               read and parsed once. A single precision copy of the
+ *               points is kept with its min/max pyramid, and a graph
+ *               made from the envelope for the range on show, so the
+ *               points drawn per run are bounded no matter how long
+ *               the run. A zoom makes the envelope again from the
+ *               pyramid for the new range. Turning a run on and off
+ *               in the overlay just changes a flag.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __RUNCACHE_hh_
+#define __RUNCACHE_hh_
+#include <vector>
+#include <string>
+#include "MinMaxPyramid.hh"
+class TGraph;
+
+/// RunCache documentation here.
+class RunCache {
+public:
+    RunCache(void);
+    ~RunCache(void);
+
+    /*!
+     * Description:
+     *   Add a run to the cache. If the file is already in the cache
+     *   it is not read again.
+     *
+     * Arguments:
+     *   Filename - sweep file, any format SweepFile can read.
+     *
+     * Returns:
+     *   index of the run, -1 on failure
+     *
+     * Errors:
+     *   File could not be read.
+     */
+    int  Add(const char *Filename);
+
+    /*!
+     * Description:
+     *   Graph for the run, made on first use and kept.
+     *   The cache owns the graph.
+     *
+     * Arguments:
+     *   i - run index
+     *
+     * Returns:
+     *   graph, NULL if i is out of range.
+     *
+     * Errors:
+     *   NONE
+     */
+    TGraph* Graph(size_t i);
+
+    /*!
+     * Description:
+     *   Make the graph of a run again from its envelope over a 
+     *   range, when the overlay is zoomed.
+     *
+     * Arguments:
+     *   i      - run index
+     *   lo, hi - x range shown
+     *   pixels - pixel columns across it
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   i out of range, nothing is done.
+     */
+    void    Refine(size_t i, double lo, double hi, uint32_t pixels);
+
+    /*! Delete all runs. */
+    void Clear(void);
+
+    inline size_t N(void) const {return fRuns.size();};
+    const char*   File(size_t i)  const {return fRuns[i]->File.c_str();};
+    const char*   Label(size_t i) const {return fRuns[i]->Label.c_str();};
+    inline bool   Visible(size_t i) const {return fRuns[i]->Visible;};
+    inline void   Visible(size_t i, bool set) {fRuns[i]->Visible = set;};
+    size_t        NVisible(void) const;
+
+    /*! Single precision points of the run. */
+    inline size_t       NPoints(size_t i) const {return fRuns[i]->x.size();};
+    inline const float* X(size_t i) const {return &fRuns[i]->x[0];};
+    inline const float* Y(size_t i) const {return &fRuns[i]->y[0];};
+
+private:
+    struct Run {
+	std::string        File;
+	std::string        Label;
+	std::vector<float> x;
+	std::vector<float> y;
+	MinMaxPyramid      Pyramid;
+	TGraph*            Graph;
+	bool               Visible;
+    };
+    std::vector<Run*> fRuns;
+};
+#endif
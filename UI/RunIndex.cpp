@@ -0,0 +1,299 @@
+/********************************************************************
+ *
+ * Module Name : RunIndex.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Archive index with fit results.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "RunIndex.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : RunIndex constructor
+ *
+ * Description :
+ *
+ * Inputs : Filename - index file
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RunIndex::RunIndex(const char *Filename)
+{
+    SET_DEBUG_STACK;
+    fFilename = Filename;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Parse
+ *
+ * Description : File name up to the first comma then the numbers.
+ *
+ * Inputs : Line - text, modified
+ *          e    - output
+ *
+ * Returns : true if the whole line parsed
+ *
+ * Error Conditions : too few fields
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RunIndex::Parse(char *Line, RunIndexEntry &e)
+{
+    char   *p = strchr(Line, ',');
+    char   *q;
+    double v[13 + kDiodeParameters*kDiodeParameters];
+    const size_t nv = sizeof(v)/sizeof(double);
+
+    if (p == NULL)
+    {
+	return false;
+    }
+    *p++ = 0;
+    e.File = Line;
+    for (size_t i=0; i<nv; i++)
+    {
+	v[i] = strtod(p, &q);
+	if (q == p)
+	{
+	    return false;
+	}
+	p = q;
+	while ((*p == ',') || (*p == ' ')) p++;
+    }
+    e.Model          = (int) v[0];
+    e.Fit.Is         = v[1];
+    e.Fit.n          = v[2];
+    e.Fit.Rs         = v[3];
+    e.Fit.Rsh        = v[4];
+    for (uint32_t i=0; i<kDiodeParameters; i++) e.Fit.Error[i] = v[5+i];
+    e.Fit.Chi2       = v[9];
+    e.Fit.NDF        = (uint32_t) v[10];
+    e.Fit.Iterations = (uint32_t) v[11];
+    e.Fit.Converged  = (v[12] != 0.0);
+    for (uint32_t i=0; i<kDiodeParameters; i++)
+	for (uint32_t j=0; j<kDiodeParameters; j++)
+	    e.Fit.Cov[i][j] = v[13 + i*kDiodeParameters + j];
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Read
+ *
+ * Description : Load the index, a missing file is an empty index.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : bad lines are skipped.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RunIndex::Read(void)
+{
+    SET_DEBUG_STACK;
+    FILE          *fp = fopen(fFilename.c_str(), "r");
+    char          line[2048];
+    RunIndexEntry e;
+    int           bad = 0;
+
+    fEntries.clear();
+    fByFile.clear();
+    if (fp == NULL)
+    {
+	return true;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+	line[strcspn(line, "\r\n")] = 0;
+	if ((line[0] == '#') || (line[0] == 0))
+	{
+	    continue;
+	}
+	if (Parse(line, e))
+	{
+	    // A run listed twice keeps the later fit.
+	    Update(e.File.c_str(), e.Model, e.Fit);
+	}
+	else
+	{
+	    bad++;
+	}
+    }
+    fclose(fp);
+    if (bad > 0)
+    {
+	CLogger::GetThis()->Log("# RunIndex: %d bad lines in %s\n", bad,
+				fFilename.c_str());
+    }
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Write
+ *
+ * Description : Write to Filename.tmp then rename.
+ *
+ * Inputs : NONE
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : can not write or rename.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool RunIndex::Write(void)
+{
+    SET_DEBUG_STACK;
+    std::string tmp = fFilename + ".tmp";
+    FILE        *fp = fopen(tmp.c_str(), "w");
+
+    if (fp == NULL)
+    {
+	CLogger::GetThis()->Log("# RunIndex: can not write %s\n", tmp.c_str());
+	return false;
+    }
+    fprintf(fp, "# IVCurve run index\n");
+    fprintf(fp, "# File,Model,Is,n,Rs,Rsh,eIs,en,eRs,eRsh,Chi2,NDF,"
+	    "Iterations,Converged,Cov[Is n Rs Rsh][Is n Rs Rsh]\n");
+    for (size_t k=0; k<fEntries.size(); k++)
+    {
+	const RunIndexEntry &e = fEntries[k];
+	fprintf(fp, "%s,%d,%.9g,%.9g,%.9g,%.9g", e.File.c_str(), e.Model,
+		e.Fit.Is, e.Fit.n, e.Fit.Rs, e.Fit.Rsh);
+	for (uint32_t i=0; i<kDiodeParameters; i++)
+	    fprintf(fp, ",%.6g", e.Fit.Error[i]);
+	fprintf(fp, ",%.9g,%u,%u,%d", e.Fit.Chi2, e.Fit.NDF,
+		e.Fit.Iterations, (int) e.Fit.Converged);
+	for (uint32_t i=0; i<kDiodeParameters; i++)
+	    for (uint32_t j=0; j<kDiodeParameters; j++)
+		fprintf(fp, ",%.6g", e.Fit.Cov[i][j]);
+	fprintf(fp, "\n");
+    }
+    if (fclose(fp) != 0)
+    {
+	CLogger::GetThis()->Log("# RunIndex: error writing %s\n", tmp.c_str());
+	return false;
+    }
+    if (rename(tmp.c_str(), fFilename.c_str()) != 0)
+    {
+	CLogger::GetThis()->Log("# RunIndex: can not rename %s\n", tmp.c_str());
+	return false;
+    }
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Find
+ *
+ * Description : Look a run up by name.
+ *
+ * Inputs : File - run name
+ *
+ * Returns : entry or NULL
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+RunIndexEntry* RunIndex::Find(const char *File)
+{
+    std::map<std::string, size_t>::const_iterator it = fByFile.find(File);
+
+    return (it == fByFile.end()) ? NULL : &fEntries[it->second];
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Update
+ *
+ * Description : Record a fit.
+ *
+ * Inputs : File  - run name
+ *          Model - DiodeFit::Model
+ *          p     - result
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void RunIndex::Update(const char *File, int Model, const DiodeParams &p)
+{
+    RunIndexEntry *e = Find(File);
+
+    if (e == NULL)
+    {
+	fByFile[File] = fEntries.size();
+	fEntries.push_back(RunIndexEntry());
+	e = &fEntries.back();
+	e->File = File;
+    }
+    e->Model = Model;
+    e->Fit   = p;
+}
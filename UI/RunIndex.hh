@@ -0,0 +1,107 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : RunIndex.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Index of the runs in a sweep archive along with the
+ *               result of the last fit of each. Kept as a comma 
+ *               separated text file, index.csv by default, in the 
+ *               archive directory so it can be read back with a
+ *               spreadsheet or a ROOT TTree::ReadFile. One line per
+ *               run:
+ *
+ *   File,Model,Is,n,Rs,Rsh,eIs,en,eRs,eRsh,Chi2,NDF,Iterations,
+ *   Converged,Cov00,Cov01,...,Cov33
+ *
+ *               The covariance is of Is, n, Rs, Rsh in that order.
+ *
+ * Restrictions/Limitations :
+ *               File names may not contain commas.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __RUNINDEX_hh_
+#define __RUNINDEX_hh_
+#include <vector>
+#include <string>
+#include <map>
+#include "DiodeFit.hh"
+
+/// One line of the index.
+struct RunIndexEntry {
+    std::string File;   /*! Run name as SweepFile::Read takes it */
+    int         Model;  /*! DiodeFit::Model used                */
+    DiodeParams Fit;
+};
+
+/// RunIndex documentation here.
+class RunIndex {
+public:
+    /*!
+     * Description:
+     *   Attach to an index file. Nothing is read until Read.
+     *
+     * Arguments:
+     *   Filename - index file
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    RunIndex(const char *Filename);
+
+    /*!
+     * Description:
+     *   Load the index. A missing file is an empty index.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   Malformed lines are logged and skipped.
+     */
+    bool Read(void);
+
+    /*!
+     * Description:
+     *   Write the index. It goes to a temporary file which is then
+     *   renamed over the old one so a crash never leaves half an
+     *   index behind.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   File can not be written.
+     */
+    bool Write(void);
+
+    /*! Entry for a run, NULL if there is none. */
+    RunIndexEntry* Find(const char *File);
+
+    /*! Set the fit of a run, adding it if need be. */
+    void Update(const char *File, int Model, const DiodeParams &p);
+
+    inline size_t               N(void) const {return fEntries.size();};
+    inline const RunIndexEntry& Entry(size_t i) const {return fEntries[i];};
+    inline const char*          Filename(void) const {return fFilename.c_str();};
+
+private:
+    /*! Parse one line into e, false if malformed. */
+    static bool Parse(char *Line, RunIndexEntry &e);
+
+    std::string                fFilename;
+    std::vector<RunIndexEntry> fEntries;
+    std::map<std::string, size_t> fByFile; /*! Run name to entry */
+};
+#endif
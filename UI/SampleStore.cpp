@@ -0,0 +1,408 @@
+/********************************************************************
+ *
+ * Module Name : SampleStore.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Structure of arrays store of the sweep points.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cmath>
+
+/// Root Includes
+#include <TGraphErrors.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "SampleStore.hh"
+
+const uint32_t SampleStore::kNoPair;
+const double   SampleStore::kGainSigmas = 10.0;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : SampleStore constructor
+ *
+ * Description :
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+SampleStore::SampleStore(void)
+{
+    SET_DEBUG_STACK;
+    fCorrection = kNoCorrection;
+    Clear();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reserve
+ *
+ * Description : Empty and size for the sweep.
+ *
+ * Inputs : n - expected points
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SampleStore::Reserve(uint32_t n)
+{
+    SET_DEBUG_STACK;
+    Clear();
+    fSetV.reserve(n);
+    fMean.reserve(n);
+    fSigma.reserve(n);
+    fN.reserve(n);
+    fSettle.reserve(n);
+    fTime.reserve(n);
+    fStep.reserve(n);
+    fBranch.reserve(n);
+    fPartner.reserve(n);
+    fDrift.reserve(n);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Clear
+ *
+ * Description : Drop the points.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SampleStore::Clear(void)
+{
+    fT0 = 0.0;
+    fSetV.clear();
+    fMean.clear();
+    fSigma.clear();
+    fN.clear();
+    fSettle.clear();
+    fTime.clear();
+    fStep.clear();
+    fBranch.clear();
+    fPartner.clear();
+    fDrift.clear();
+    for (uint32_t b=0; b<kNBranches; b++) fIndex[b].clear();
+    fUpAt.clear();
+    fNPairs  = 0;
+    fArea    = 0.0;
+    fMaxDev  = 0.0;
+    fVMaxDev = 0.0;
+    fLastV   = 0.0;
+    fLastD   = 0.0;
+    fLastRef = kNoPair;
+    fRef0    = 0.0;
+    fGainOK  = true;
+    // fCorrection is a setting, kept across sweeps.
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Add
+ *
+ * Description : Append a point. A down point is linked to the up 
+ *               point at the same voltage and the area between the
+ *               branches grows by the strip back to the last pair.
+ *
+ * Inputs : see header
+ *
+ * Returns : number of points
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SampleStore::Add(double SetV, double Mean, double Sigma, 
+			  uint32_t N, double Settle, double Time, 
+			  uint8_t Type, uint8_t Branch, uint32_t Pair)
+{
+    const uint32_t n = fSetV.size();
+    uint32_t       u, k;
+    double         d, t0, t1;
+
+    if (fSetV.empty())
+    {
+	fT0 = Time;
+    }
+    fSetV.push_back(SetV);
+    fMean.push_back(Mean);
+    fSigma.push_back(Sigma);
+    fN.push_back((N < 0xFFFF) ? N : 0xFFFF);
+    fSettle.push_back(Settle);
+    fTime.push_back(Time - fT0);
+    fStep.push_back(Type);
+    fBranch.push_back(Branch);
+    fPartner.push_back(kNoPair);
+    fIndex[(Branch < kNBranches) ? Branch : kUp].push_back(n);
+
+    if (Branch == kReference)
+    {
+	fDrift.push_back(Mean);
+	if (fGainOK && (fCorrection == kGain) &&
+	    ((Mean == 0.0) || (fabs(Mean) < kGainSigmas*Sigma)))
+	{
+	    // A ratio to noise is no correction at all.
+	    fGainOK = false;
+	    CLogger::GetThis()->Log(
+		"# SampleStore: reference %g +/- %g too near zero for a gain,"
+		" using the offset.\n", Mean, Sigma);
+	}
+	if (fLastRef == kNoPair)
+	{
+	    // Points before the first reference get its reading.
+	    fRef0 = Mean;
+	    for (k=0; k<n; k++) fDrift[k] = Mean;
+	}
+	else
+	{
+	    // Straight line in time back to the last reference.
+	    t0 = fTime[fLastRef];
+	    t1 = fTime[n];
+	    for (k=fLastRef+1; k<n; k++)
+	    {
+		d = (t1 > t0) ? (fTime[k] - t0)/(t1 - t0) : 1.0;
+		fDrift[k] = fMean[fLastRef] + d*(Mean - fMean[fLastRef]);
+	    }
+	}
+	fLastRef = n;
+	return fSetV.size();
+    }
+    // Held at the last reference until the next one comes in.
+    fDrift.push_back((fLastRef == kNoPair) ? NAN : fMean[fLastRef]);
+
+    if (Pair == kNoPair)
+    {
+	return fSetV.size();
+    }
+    if (Branch != kDown)
+    {
+	if (Pair >= fUpAt.size()) fUpAt.resize(Pair+1, kNoPair);
+	fUpAt[Pair] = n;
+    }
+    else if ((Pair < fUpAt.size()) && (fUpAt[Pair] != kNoPair))
+    {
+	// Link the pair and add the strip back to the last pair.
+	u           = fUpAt[Pair];
+	fPartner[n] = u;
+	fPartner[u] = n;
+	d = (double) fMean[u] - (double) fMean[n];
+	if (fNPairs > 0)
+	{
+	    fArea += 0.5*(d + fLastD)*fabs(SetV - fLastV);
+	}
+	if (fabs(d) > fMaxDev)
+	{
+	    fMaxDev  = fabs(d);
+	    fVMaxDev = SetV;
+	}
+	fLastV = SetV;
+	fLastD = d;
+	fNPairs++;
+    }
+    return fSetV.size();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : View
+ *
+ * Description : Copy the new points into the display graph. If the
+ *               graph has more points than the store it was filled
+ *               from something else and is refilled.
+ *
+ * Inputs : g      - graph
+ *          XScale - x scale
+ *
+ * Returns : points in the graph
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SampleStore::View(TGraphErrors *g, double XScale) const
+{
+    const uint32_t n = fSetV.size();
+    uint32_t       i = g->GetN();
+
+    if (i > n)
+    {
+	i = 0;
+	g->Set(0);
+    }
+    // SetPoint grows the arrays by doubling.
+    for (; i<n; i++)
+    {
+	g->SetPoint(i, XScale*fSetV[i], Value(i));
+	g->SetPointError(i, 0.0, 
+			 (fN[i] > 0) ? fSigma[i]/sqrt((double) fN[i]) : 0.0);
+    }
+    return n;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Write
+ *
+ * Description : One point as comma separated text.
+ *
+ * Inputs : out    - stream
+ *          i      - point
+ *          XScale - x scale
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SampleStore::Write(std::ostream &out, uint32_t i, double XScale) const
+{
+    out << XScale*fSetV[i] << "," << fMean[i] << "," << fSigma[i] << ","
+	<< fN[i] << "," << fSettle[i] << "," << fTime[i] << ","
+	<< (int) fStep[i] << "," << (int) fBranch[i] << "," 
+	<< fDrift[i] << endl;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Value
+ *
+ * Description : The reading at a point less the drift of the
+ *               reference since the first reference, as an offset
+ *               or a gain. A point with no drift known yet is left
+ *               as read. A gain with a reference in the noise is
+ *               taken as an offset.
+ *
+ * Inputs : i - point
+ *
+ * Returns : corrected reading
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double SampleStore::Value(uint32_t i) const
+{
+    const double drift = fDrift[i];
+
+    if (std::isnan(drift)) return fMean[i];
+    switch (fCorrection)
+    {
+    case kOffset:
+	return fMean[i] - (drift - fRef0);
+    case kGain:
+	if (fGainOK) return fMean[i]*fRef0/drift;
+	return fMean[i] - (drift - fRef0);
+    }
+    return fMean[i];
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : View
+ *
+ * Description : Copy the new points of one branch into a display
+ *               graph, as for the whole store.
+ *
+ * Inputs : g      - graph
+ *          XScale - x scale
+ *          Branch - kUp or kDown
+ *
+ * Returns : points in the graph
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t SampleStore::View(TGraphErrors *g, double XScale, 
+			   uint8_t Branch) const
+{
+    const std::vector<uint32_t> &index = 
+	fIndex[(Branch == kDown) ? kDown : kUp];
+    const uint32_t n = index.size();
+    uint32_t       i = g->GetN();
+    uint32_t       k;
+
+    if (i > n)
+    {
+	i = 0;
+	g->Set(0);
+    }
+    for (; i<n; i++)
+    {
+	k = index[i];
+	g->SetPoint(i, XScale*fSetV[k], Value(k));
+	g->SetPointError(i, 0.0, 
+			 (fN[k] > 0) ? fSigma[k]/sqrt((double) fN[k]) : 0.0);
+    }
+    return n;
+}
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : SampleStore.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : The acquired points of a sweep, one array per
+ *               quantity. This is the owner of the data, the graph
+ *               on the screen is filled from it.
+ *
+ *               SetV    - voltage asked of the source
+ *               Mean    - mean of the readings at that voltage
+ *               Sigma   - standard deviation of those readings
+ *               N       - number of readings
+ *               Settle  - time allowed between set and read, s
+ *               Time    - time of the reading from the start, s
+ *               Step    - coarse or fine step
+ *               Branch  - up or down in a bidirectional sweep, or
+ *                         a reading at the drift reference
+ *               Partner - the point at the same voltage on the 
+ *                         other branch, kNoPair if none yet
+ *               Drift   - the reference reading at the time of the
+ *                         point, NaN before the first reference
+ *
+ *               As each down point is linked to its up partner the
+ *               area between the branches is added to, a trapezoid
+ *               from the last pair, so the hysteresis is known
+ *               while the sweep runs. The area is in SetV times
+ *               reading units, positive if the up branch reads 
+ *               higher.
+ *
+ *               The drift channel is filled in as the references
+ *               come in. A point between two references gets the
+ *               straight line between them in time, one after the
+ *               last reference holds it until the next arrives. With
+ *               a correction set the graphs show the reading less
+ *               the change in the reference since the first one, or
+ *               scaled by the ratio of the first reference to it.
+ *               A gain needs every reference well clear of zero, 
+ *               when one is lost in the noise the sweep falls back
+ *               to the offset.
+ *               The file always has the raw reading and the drift.
+ *
+ *               Single precision is plenty, the meter gives 5 1/2
+ *               digits. Time is kept from T0 so a float holds it to
+ *               the millisecond over a long run. The arrays are
+ *               sized from the sweep plan before the start so adding
+ *               a point does not allocate.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __SAMPLESTORE_hh_
+#define __SAMPLESTORE_hh_
+#include <stdint.h>
+#include <vector>
+#include <iosfwd>
+
+class TGraphErrors;
+
+/// SampleStore documentation here.
+class SampleStore {
+public:
+    /*! Step type of a point. */
+    enum Step {kCoarse=0, kFine};
+    /*! Branch of a point. */
+    enum Branch {kUp=0, kDown, kReference, kNBranches};
+    /*! Drift correction. */
+    enum Correction {kNoCorrection=0, kOffset, kGain};
+    /*! No partner point. */
+    static const uint32_t kNoPair = 0xFFFFFFFF;
+    /*! A reference within this many sigma of zero can not scale. */
+    static const double   kGainSigmas;
+
+    SampleStore(void);
+
+    /*!
+     * Description:
+     *   Empty the store and make room for a sweep.
+     *
+     * Arguments:
+     *   n - points the sweep plan expects.
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void Reserve(uint32_t n);
+
+    /*! Drop all points, keep the space. */
+    void Clear(void);
+
+    /*!
+     * Description:
+     *   Add a point. The first point sets T0.
+     *
+     * Arguments:
+     *   SetV   - voltage set
+     *   Mean   - mean reading
+     *   Sigma  - standard deviation of the readings
+     *   N      - number of readings
+     *   Settle - settle time, s
+     *   Time   - time of the reading, s since the epoch
+     *   Type   - kCoarse or kFine
+     *   Branch - kUp, kDown or kReference
+     *   Pair   - index of the voltage in the up branch, a down point
+     *            is linked to the up point with the same index.
+     *
+     * Returns:
+     *   number of points
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t Add(double SetV, double Mean, double Sigma, uint32_t N,
+		 double Settle, double Time, uint8_t Type,
+		 uint8_t Branch = kUp, uint32_t Pair = kNoPair);
+
+    /*!
+     * Description:
+     *   Bring a display graph up to date. Only the points the graph
+     *   does not have yet are copied, so calling this after every
+     *   point costs one point. The error bar is the standard error
+     *   of the mean, Sigma/sqrt(N). The reading is drift corrected
+     *   if a correction is set, to redo the graph after the drift
+     *   is filled in empty it first.
+     *
+     * Arguments:
+     *   g      - graph to fill
+     *   XScale - x on the graph is SetV*XScale
+     *
+     * Returns:
+     *   points in the graph
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t View(TGraphErrors *g, double XScale = 1.0) const;
+
+    /*! As above for the points of one branch only. */
+    uint32_t View(TGraphErrors *g, double XScale, uint8_t Branch) const;
+
+    /*!
+     * Description:
+     *   Write one point as a line of text
+     *       x, mean, sigma, N, settle, time, step, branch, drift
+     *   Files readers look at the first two columns only.
+     *
+     * Arguments:
+     *   out    - stream
+     *   i      - point
+     *   XScale - x is SetV*XScale
+     *
+     * Returns:
+     *   NONE
+     *
+     * Errors:
+     *   NONE
+     */
+    void     Write(std::ostream &out, uint32_t i, double XScale = 1.0) const;
+
+    inline uint32_t N(void)        const {return fSetV.size();};
+    inline double   T0(void)       const {return fT0;};
+    inline const float*    SetV(void)     const {return &fSetV[0];};
+    inline const float*    Mean(void)     const {return &fMean[0];};
+    inline const float*    Sigma(void)    const {return &fSigma[0];};
+    inline const uint16_t* NSamples(void) const {return &fN[0];};
+    inline const float*    Settle(void)   const {return &fSettle[0];};
+    inline const float*    Time(void)     const {return &fTime[0];};
+    inline const uint8_t*  StepType(void) const {return &fStep[0];};
+    inline const uint8_t*  BranchOf(void) const {return &fBranch[0];};
+    inline const uint32_t* Partner(void)  const {return &fPartner[0];};
+    inline const float*    Drift(void)    const {return &fDrift[0];};
+    /*! Points on a branch. */
+    inline uint32_t NBranch(uint8_t b) const {return fIndex[b].size();};
+
+    /*! Reading at point i, drift corrected as set. */
+    double   Value(uint32_t i) const;
+    inline void    DriftCorrection(uint8_t c) {fCorrection = c;};
+    inline uint8_t DriftCorrection(void) const {return fCorrection;};
+    /*! Change in the reference from the first to the last. */
+    inline double  ReferenceDrift(void) const 
+	{return (fLastRef == kNoPair) ? 0.0 : fMean[fLastRef] - fRef0;};
+
+    /*! Hysteresis so far, see above. */
+    inline uint32_t NPairs(void)        const {return fNPairs;};
+    inline double   HysteresisArea(void) const {return fArea;};
+    /*! Largest |up - down| and where. */
+    inline double   MaxDeviation(void)  const {return fMaxDev;};
+    inline double   VMaxDeviation(void) const {return fVMaxDev;};
+
+private:
+    double                fT0;
+    std::vector<float>    fSetV;
+    std::vector<float>    fMean;
+    std::vector<float>    fSigma;
+    std::vector<uint16_t> fN;
+    std::vector<float>    fSettle;
+    std::vector<float>    fTime;
+    std::vector<uint8_t>  fStep;
+    std::vector<uint8_t>  fBranch;
+    std::vector<uint32_t> fPartner;
+    std::vector<float>    fDrift;
+    std::vector<uint32_t> fIndex[kNBranches]; /*! Points per branch */
+    std::vector<uint32_t> fUpAt;   /*! Up pair index to point      */
+    uint32_t              fNPairs;
+    double                fArea;
+    double                fMaxDev;
+    double                fVMaxDev;
+    double                fLastV;  /*! Last pair linked            */
+    double                fLastD;
+    uint8_t               fCorrection;
+    bool                  fGainOK;  /*! References clear of noise */
+    uint32_t              fLastRef; /*! Last reference point      */
+    double                fRef0;    /*! First reference reading   */
+};
+#endif
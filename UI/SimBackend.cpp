@@ -0,0 +1,417 @@
+/********************************************************************
+ *
+ * Module Name : SimBackend.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Simulated instruments and diode.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <cstring>
+#include <cmath>
+
+/// Root includes http://root.cern.ch
+#include <TEnv.h>
+
+// Local Includes.
+#include "debug.h"
+#include "SimBackend.hh"
+
+/* 196 ranges, R1 up, and counts per rate. */
+const double  kSimDCARange[] = {300.0e-6, 3.0e-3, 30.0e-3, 300.0e-3, 3.0};
+const uint8_t kSimNDCARange  = 5;
+const double  kSimDCVRange[] = {0.3, 3.0, 30.0, 300.0};
+const uint8_t kSimNDCVRange  = 4;
+const double  kSimCounts[]   = {3.0e3, 3.0e4, 3.0e5, 3.0e6};
+/* Seconds per reading at each rate. */
+const double  kSimConvert[]  = {3.0e-3, 1.0e-2, 5.0e-2, 3.3e-1};
+const uint8_t kSimNRates     = 4;
+/* What the 196 sends for an over range. */
+const double  kSimOverflow   = 9.99e9;
+
+const double  SimBackend::kSimBus = 1.0e-3;
+
+/*
+ * SplitMix64 as in Bootstrap, the top 53 bits make a uniform double.
+ */
+static inline uint64_t SplitMix64(uint64_t &s)
+{
+    uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ ******************************************************************
+ *
+ * Function Name : SimBackend constructor
+ *
+ * Description : Part, noise and instruments at their power on state.
+ *
+ * Inputs : p           - diode
+ *          Temperature - Kelvin
+ *          Seed        - noise seed
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+SimBackend::SimBackend(const DiodeParams &p, double Temperature,
+		       uint64_t Seed) : fFit(Temperature)
+{
+    SET_DEBUG_STACK;
+    fPart       = p;
+    fNoiseFloor = 1.0e-11;
+    fNoiseRel   = 1.0e-4;
+    fCurrent    = false;
+    fRange      = 0;
+    fRate       = kSimNRates - 1;
+    fLimit      = 4.0e-3;
+    fV          = 0.0;
+    fPulseV     = 0.0;
+    fPulseBase  = 0.0;
+    fPulseWidth = 0.0;
+    fPulseStart = 0.0;
+    fPulseEnd   = 0.0;
+    fOneShot    = false;
+    fDelay      = 0.0;
+    fTau        = 0.0;
+    fNow        = 0.0;
+    fStepAt     = 0.0;
+    fFinal      = fFit.Full(0.0, fPart);
+    fFrom       = fFinal;
+    fWaited     = 0.0;
+    fNReads     = 0;
+    fState      = Seed;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SmallSignal
+ *
+ * Description : Parameters close to a 1N4148.
+ *
+ * Inputs : NONE
+ *
+ * Returns : diode
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+DiodeParams SimBackend::SmallSignal(void)
+{
+    DiodeParams p;
+
+    memset(&p, 0, sizeof(p));
+    p.Is  = 2.5e-9;
+    p.n   = 1.75;
+    p.Rs  = 0.6;
+    p.Rsh = 1.0e9;
+    return p;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Open
+ *
+ * Description : Simulator from the Simulate resources.
+ *
+ * Inputs : env - resources
+ *
+ * Returns : simulator
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+SimBackend* SimBackend::Open(TEnv *env)
+{
+    SET_DEBUG_STACK;
+    DiodeParams p = SmallSignal();
+    SimBackend  *sim;
+
+    p.Is  = env->GetValue("Simulate.Is",  p.Is);
+    p.n   = env->GetValue("Simulate.n",   p.n);
+    p.Rs  = env->GetValue("Simulate.Rs",  p.Rs);
+    p.Rsh = env->GetValue("Simulate.Rsh", p.Rsh);
+    sim = new SimBackend(p, env->GetValue("IVCurve.Temperature", 293.15),
+			 (uint64_t) env->GetValue("Simulate.Seed", 1));
+    sim->SettleTau(env->GetValue("Simulate.SettleTau", 0.02));
+    sim->NoiseFloor(env->GetValue("Simulate.NoiseFloor", 1.0e-11));
+    sim->NoiseRel(env->GetValue("Simulate.NoiseRel", 1.0e-4));
+    return sim;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Advance
+ *
+ * Description : Move the clock on. A pulse that ends on the way
+ *               steps the source back to its base then.
+ *
+ * Inputs : s - seconds
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SimBackend::Advance(double s)
+{
+    double t = fNow + s;
+
+    if ((fPulseEnd > 0.0) && (t >= fPulseEnd))
+    {
+	fNow      = fPulseEnd;
+	fPulseEnd = 0.0;
+	Step(fPulseBase);
+    }
+    fNow = t;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Step
+ *
+ * Description : Source to V now. The current starts from where it
+ *               is and heads for the part's current at V.
+ *
+ * Inputs : V - volts
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SimBackend::Step(double V)
+{
+    if (V == fV) return;
+    fFrom   = Present();
+    fV      = V;
+    fFinal  = fFit.Full(V, fPart);
+    fStepAt = fNow;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Present
+ *
+ * Description : Current at this moment, settled with SettleTau.
+ *
+ * Inputs : NONE
+ *
+ * Returns : amps
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double SimBackend::Present(void) const
+{
+    if (fTau <= 0.0)
+    {
+	return fFinal;
+    }
+    return fFinal + (fFrom - fFinal)*exp(-(fNow - fStepAt)/fTau);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceProgram
+ *
+ * Description : The two location program, run by SourceExecute.
+ *
+ * Inputs : V     - pulse volts
+ *          Base  - volts after the pulse
+ *          Limit - amps
+ *          Width - pulse s
+ *          Off   - after the pulse s, not needed here
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SimBackend::SourceProgram(double V, double Base, double Limit,
+			       double Width, double Off)
+{
+    Advance(kSimBus);
+    fPulseV     = V;
+    fPulseBase  = Base;
+    fPulseWidth = Width;
+    fLimit      = Limit;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : SourceExecute
+ *
+ * Description : Start the pulse, it ends on the clock.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void SimBackend::SourceExecute(void)
+{
+    Advance(kSimBus);
+    Step(fPulseV);
+    fPulseStart = fNow;
+    fPulseEnd   = fNow + fPulseWidth;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Gauss
+ *
+ * Description : Box-Muller, one of the pair is used.
+ *
+ * Inputs : NONE
+ *
+ * Returns : standard normal deviate
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double SimBackend::Gauss(void)
+{
+    double u1 = ((SplitMix64(fState) >> 11) + 1.0) * (1.0/9007199254740993.0);
+    double u2 =  (SplitMix64(fState) >> 11)        * (1.0/9007199254740992.0);
+
+    return sqrt(-2.0*log(u1)) * cos(2.0*M_PI*u2);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : MeterRead
+ *
+ * Description : One reading of the part at the voltage set, with
+ *               noise, the source limit and the 196 range. On one
+ *               shot in a pulse it is taken the trigger delay into
+ *               the pulse, otherwise at the end of the conversion.
+ *
+ * Inputs : NONE
+ *
+ * Returns : reading, kSimOverflow over range
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double SimBackend::MeterRead(void)
+{
+    const double conv = kSimConvert[(fRate < kSimNRates) ? fRate : 
+				    kSimNRates - 1];
+    double  x, fs, q;
+    uint8_t r;
+
+    fNReads++;
+    Advance(kSimBus);
+    if (fOneShot && (fPulseEnd > 0.0))
+    {
+	Advance(fmax(fPulseStart + fDelay - fNow, 0.0));
+	x = Present();
+	Advance(conv);
+    }
+    else
+    {
+	Advance(conv);
+	x = Present();
+    }
+    if (fCurrent)
+    {
+	x += (fNoiseFloor + fNoiseRel*fabs(x))*Gauss();
+	x  = fmax(fmin(x, fLimit), -fLimit);
+    }
+    else
+    {
+	x  = fV;
+    }
+    if (fRange == 0)
+    {
+	return x;
+    }
+    r  = fRange - 1;
+    if (fCurrent)
+	fs = kSimDCARange[(r < kSimNDCARange) ? r : kSimNDCARange - 1];
+    else
+	fs = kSimDCVRange[(r < kSimNDCVRange) ? r : kSimNDCVRange - 1];
+    if (fabs(x) > 1.01*fs)
+    {
+	return kSimOverflow;
+    }
+    q = fs/kSimCounts[(fRate < kSimNRates) ? fRate : kSimNRates - 1];
+    return q*floor(x/q + 0.5);
+}
@@ -0,0 +1,164 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : SimBackend.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : A diode on a simulated 196 and 230. The current is
+ *               the full diode model of DiodeFit with a spread of
+ *               NoiseFloor plus NoiseRel times the current added,
+ *               held to the source limit. On a locked range the
+ *               reading is rounded to the counts of the rate set
+ *               and an over range reads 9.99e9, as the 196 does.
+ *               Reading volts it is the voltage set.
+ *
+ *               Nothing takes real time. The simulator keeps its own
+ *               clock from 0, Wait moves it on by what was asked,
+ *               each command by kSimBus and each reading by the
+ *               conversion time of the 196 at the rate set. After a
+ *               step the current goes to its new value with one time
+ *               constant, SettleTau, so a settle time that is too
+ *               short reads short here as it would on the bench. A
+ *               pulse lasts its width on the same clock.
+
+ *               The noise comes from a seeded generator so a sweep
+ *               gives the same readings every time.
+ *
+ * Restrictions/Limitations :
+ *               No self heating, a pulse only differs from DC by
+ *               how far the current has settled when it is read.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __SIMBACKEND_hh_
+#define __SIMBACKEND_hh_
+#include "GpibBackend.hh"
+#include "DiodeFit.hh"
+class TEnv;
+
+/// SimBackend documentation here.
+class SimBackend : public GpibBackend {
+public:
+    /*!
+     * Description:
+     *   Build the simulated part and instruments.
+     *
+     * Arguments:
+     *   p           - diode, Is, n, Rs and Rsh
+     *   Temperature - Kelvin
+     *   Seed        - noise generator seed
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    SimBackend(const DiodeParams &p, double Temperature = 293.15,
+	       uint64_t Seed = 1);
+
+    /*! A 1N4148 like part at room temperature. */
+    static DiodeParams SmallSignal(void);
+
+    /*!
+     * Description:
+     *   A simulator set from the Simulate resources, the part from
+     *   Simulate.Is, .n, .Rs and .Rsh, SmallSignal by default, and
+     *   Simulate.SettleTau, .NoiseFloor, .NoiseRel and .Seed. The
+     *   temperature is IVCurve.Temperature.
+     *
+     * Arguments:
+     *   env - resources
+     *
+     * Returns:
+     *   simulator, for Instruments to own
+     *
+     * Errors:
+     *   None
+     */
+    static SimBackend* Open(TEnv *env);
+
+    inline void   NoiseFloor(double A) {fNoiseFloor = A;};
+    inline void   NoiseRel(double r)   {fNoiseRel = r;};
+    /*! Time constant of the current after a step, s, 0 for none. */
+    inline void   SettleTau(double s)  {fTau = s;};
+    inline double SettleTau(void) const {return fTau;};
+    /*! Time the instruments were asked to wait, s. */
+    inline double Waited(void) const  {return fWaited;};
+    inline uint64_t NReads(void) const {return fNReads;};
+
+    inline bool    MeterOK(void)  const {return true;};
+    inline bool    SourceOK(void) const {return true;};
+    inline uint8_t MeterAddress(void)  const {return 3;};
+    inline uint8_t SourceAddress(void) const {return 14;};
+
+    inline void    MeterFunction(bool Current) 
+	{Advance(kSimBus); fCurrent = Current;};
+    inline void    MeterRange(uint8_t Range) 
+	{Advance(kSimBus); fRange = Range;};
+    inline void    MeterRate(uint8_t Rate)
+	{Advance(kSimBus); fRate = Rate;};
+    inline void    MeterTrigger(bool OneShot, double Delay) 
+	{Advance(kSimBus); fOneShot = OneShot; fDelay = Delay;};
+    double         MeterRead(void);
+    inline int     MeterStatus(void) {Advance(kSimBus); return 0;};
+
+    inline void    SourceOperate(double Limit) 
+	{Advance(kSimBus); fLimit = Limit;};
+    inline void    SourceLimit(double A) {Advance(kSimBus); fLimit = A;};
+    inline void    SourceVoltage(double V) {Advance(kSimBus); Step(V);};
+    void           SourceProgram(double V, double Base, double Limit,
+				 double Width, double Off);
+    void           SourceExecute(void);
+
+    inline void    Wait(double s) {if (s > 0.0) {fWaited += s; Advance(s);}};
+    inline double  Now(void) {return fNow;};
+    inline double  Elapsed(void) {return fNow;};
+    inline bool    Virtual(void) const {return true;};
+
+    /*! Time one GPIB command takes, s. */
+    static const double kSimBus;
+
+private:
+    /*! Standard normal deviate. */
+    double Gauss(void);
+    /*! Move the clock on, ending a pulse that runs out. */
+    void   Advance(double s);
+    /*! Set the source to V now, the current starts to follow. */
+    void   Step(double V);
+    /*! Current through the part at this moment, no noise. */
+    double Present(void) const;
+
+    DiodeFit    fFit;
+    DiodeParams fPart;
+    double   fNoiseFloor;
+    double   fNoiseRel;
+    bool     fCurrent;
+    uint8_t  fRange;
+    uint8_t  fRate;
+    double   fLimit;
+    double   fV;
+    double   fPulseV;
+    double   fPulseBase;
+    double   fPulseWidth;
+    double   fPulseStart;
+    double   fPulseEnd;  /*! Clock at the end of a pulse, 0 if none */
+    bool     fOneShot;
+    double   fDelay;     /*! One shot trigger delay                 */
+    double   fTau;
+    double   fFinal;     /*! Current the part settles to at fV      */
+    double   fFrom;      /*! Current at the last step               */
+    double   fStepAt;    /*! Clock at the last step                 */
+    double   fNow;
+    double   fWaited;
+    uint64_t fNReads;
+    uint64_t fState;    /*! Generator */
+};
+#endif
@@ -0,0 +1,335 @@
+/********************************************************************
+ *
+ * Module Name : SweepFile.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Read sweep files into plain arrays.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+/// Root Includes
+#include <TFile.h>
+#include <TGraph.h>
+#include <TNamed.h>
+#include <TKey.h>
+#include <TClass.h>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "SweepFile.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : Read
+ *
+ * Description : Pick the reader from the file name.
+ *
+ * Inputs : Filename - file to read
+ *          x, y     - output points
+ *          Comment  - output comment, may be NULL
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file can not be read or is empty.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SweepFile::Read(const char *Filename,
+		     std::vector<double> &x, std::vector<double> &y,
+		     std::string *Comment)
+{
+    SET_DEBUG_STACK;
+    bool        rc;
+    const char  *member;
+    std::string file;
+
+    x.clear();
+    y.clear();
+    if (Comment) Comment->clear();
+
+    if ((member = strstr(Filename, ".root:")) != NULL)
+    {
+	file.assign(Filename, member + 5);
+	rc = ReadROOT(file.c_str(), x, y, Comment, member + 6);
+    }
+    else if (IsROOT(Filename))
+    {
+	rc = ReadROOT(Filename, x, y, Comment);
+    }
+    else
+    {
+	rc = ReadText(Filename, x, y, Comment);
+    }
+    if (rc && x.empty())
+    {
+	CLogger::GetThis()->Log("# SweepFile: no points in %s\n", Filename);
+	rc = false;
+    }
+    SET_DEBUG_STACK;
+    return rc;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : IsROOT
+ *
+ * Description : Test the extension. A directory such as /root or 
+ *               rootdata must not make a text file look like ROOT.
+ *
+ * Inputs : Filename - file name or path
+ *
+ * Returns : true for name.root
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SweepFile::IsROOT(const char *Filename)
+{
+    const char *dot = strrchr(Filename, '.');
+
+    return (dot != NULL) && (strcmp(dot, ".root") == 0);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadText
+ *
+ * Description : Parse a text sweep. The whole file is read into
+ *               memory and walked with strtod, which is a good deal
+ *               faster than the scanf based TGraph reader for large
+ *               files. Any mix of comma, tab and space separators is
+ *               accepted.
+ *
+ * Inputs : Filename - file to read
+ *          x, y     - output points
+ *          Comment  - output comment, may be NULL
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file can not be opened
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SweepFile::ReadText(const char *Filename,
+			 std::vector<double> &x, std::vector<double> &y,
+			 std::string *Comment)
+{
+    SET_DEBUG_STACK;
+    FILE   *fp = fopen(Filename, "r");
+    long    size;
+    char   *buffer, *p, *end, *q;
+    double  a, b;
+
+    if (fp == NULL)
+    {
+	CLogger::GetThis()->Log("# SweepFile: can not open %s\n", Filename);
+	return false;
+    }
+    fseek(fp, 0L, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    buffer = new char[size+1];
+    size   = fread(buffer, 1, size, fp);
+    buffer[size] = 0;
+    fclose(fp);
+
+    // A rough guess at the number of lines saves regrowing.
+    x.reserve(size/16);
+    y.reserve(size/16);
+
+    p = buffer;
+    while (*p)
+    {
+	end = strchr(p, '\n');
+	if (end) *end = 0;
+	while ((*p == ' ') || (*p == '\t')) p++;
+	if (*p == '#')
+	{
+	    if (Comment && Comment->empty())
+	    {
+		p++;
+		while (*p == ' ') p++;
+		*Comment = p;
+	    }
+	}
+	else if (*p)
+	{
+	    a = strtod(p, &q);
+	    if (q != p)
+	    {
+		p = q;
+		while ((*p == ',') || (*p == ' ') || (*p == '\t')) p++;
+		b = strtod(p, &q);
+		if (q != p)
+		{
+		    x.push_back(a);
+		    y.push_back(b);
+		}
+	    }
+	}
+	if (end == NULL) break;
+	p = end + 1;
+    }
+    delete[] buffer;
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ReadROOT
+ *
+ * Description : Pull the graph written by IVCurve::Save, or any
+ *               other named graph, out of a ROOT file.
+ *
+ * Inputs : Filename - file to read
+ *          x, y     - output points
+ *          Comment  - output comment, may be NULL
+ *          Key      - graph name
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : file can not be opened, no such key
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SweepFile::ReadROOT(const char *Filename,
+			 std::vector<double> &x, std::vector<double> &y,
+			 std::string *Comment, const char *Key)
+{
+    SET_DEBUG_STACK;
+    TFile   myin(Filename, "READ");
+    TGraph  *g;
+    TNamed  *n;
+
+    if (myin.IsZombie())
+    {
+	CLogger::GetThis()->Log("# SweepFile: can not open %s\n", Filename);
+	return false;
+    }
+    g = dynamic_cast<TGraph *>(myin.Get(Key));
+    if (g == NULL)
+    {
+	CLogger::GetThis()->Log("# SweepFile: no %s in %s\n", Key, Filename);
+	myin.Close();
+	return false;
+    }
+    x.assign(g->GetX(), g->GetX() + g->GetN());
+    y.assign(g->GetY(), g->GetY() + g->GetN());
+    delete g;
+
+    if (Comment)
+    {
+	n = (TNamed *) myin.Get("Comment");
+	if (n)
+	{
+	    *Comment = n->GetTitle();
+	    delete n;
+	}
+    }
+    myin.Close();
+    SET_DEBUG_STACK;
+    return true;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : List
+ *
+ * Description : Name the runs held in a file.
+ *
+ * Inputs : Filename - file to look at
+ *          Runs     - names appended
+ *
+ * Returns : true on success
+ *
+ * Error Conditions : ROOT file can not be opened.
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool SweepFile::List(const char *Filename, std::vector<std::string> &Runs)
+{
+    SET_DEBUG_STACK;
+    TKey   *key;
+    TClass *cl;
+    size_t n0 = Runs.size();
+
+    if (!IsROOT(Filename))
+    {
+	Runs.push_back(Filename);
+	return true;
+    }
+
+    TFile myin(Filename, "READ");
+    if (myin.IsZombie())
+    {
+	CLogger::GetThis()->Log("# SweepFile: can not open %s\n", Filename);
+	return false;
+    }
+    if (myin.GetListOfKeys()->FindObject("IVCurve") != NULL)
+    {
+	// A single run written by IVCurve::Save
+	Runs.push_back(Filename);
+	myin.Close();
+	return true;
+    }
+    TIter next(myin.GetListOfKeys());
+    while ((key = (TKey *) next()) != NULL)
+    {
+	cl = TClass::GetClass(key->GetClassName());
+	if (cl && cl->InheritsFrom(TGraph::Class()))
+	{
+	    Runs.push_back(std::string(Filename) + ":" + key->GetName());
+	}
+    }
+    myin.Close();
+    CLogger::GetThis()->Log("# SweepFile: archive %s, %d runs.\n", Filename,
+			    (int) (Runs.size() - n0));
+    SET_DEBUG_STACK;
+    return true;
+}
@@ -0,0 +1,121 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : SweepFile.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Read the files written by IVCurve::Save into plain
+ *               arrays. Text files (csv, tsv, txt) are parsed
+ *               directly, ROOT files are opened and the IVCurve
+ *               graph and Comment are pulled out.
+ *
+ *               A ROOT file may also be an archive of many runs, one
+ *               TGraph per key. A member is named file.root:key.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __SWEEPFILE_hh_
+#define __SWEEPFILE_hh_
+#include <vector>
+#include <string>
+
+/// SweepFile documentation here.
+class SweepFile {
+public:
+
+    /*!
+     * Description:
+     *   Read a sweep from disk. The format is picked from the file
+     *   name's extension, see IsROOT.
+     *
+     * Arguments:
+     *   Filename - file to read, or file.root:key for one run out
+     *              of an archive.
+     *   x, y     - filled with the points, any previous contents
+     *              are discarded.
+     *   Comment  - if not NULL, filled with the first comment line
+     *              of a text file or the Comment key of a ROOT file.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   File can not be opened, or has no points in it.
+     */
+    static bool Read(const char *Filename,
+		     std::vector<double> &x, std::vector<double> &y,
+		     std::string *Comment = NULL);
+
+    /*! Does the name end in .root? Not just root anywhere in it. */
+    static bool IsROOT(const char *Filename);
+
+    /*!
+     * Description:
+     *   Parse comma, tab or space separated x,y pairs. Lines
+     *   starting with '#' are comments.
+     *
+     * Arguments:
+     *   Filename - file to read
+     *   x, y     - filled with the points
+     *   Comment  - if not NULL, filled with the first comment.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   File can not be opened
+     */
+    static bool ReadText(const char *Filename,
+			 std::vector<double> &x, std::vector<double> &y,
+			 std::string *Comment = NULL);
+
+    /*!
+     * Description:
+     *   Pull a graph out of a ROOT file.
+     *
+     * Arguments:
+     *   Filename - file to read
+     *   x, y     - filled with the points
+     *   Comment  - if not NULL, filled with the Comment key.
+     *   Key      - name of the graph.
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   File can not be opened or has no such key.
+     */
+    static bool ReadROOT(const char *Filename,
+			 std::vector<double> &x, std::vector<double> &y,
+			 std::string *Comment = NULL,
+			 const char *Key = "IVCurve");
+
+    /*!
+     * Description:
+     *   List the runs in a file. A text file or a ROOT file holding
+     *   a single IVCurve graph is one run, named by the file. Any
+     *   other ROOT file is taken as an archive and every TGraph in 
+     *   it is a run, named file.root:key.
+     *
+     * Arguments:
+     *   Filename - file to look at
+     *   Runs     - names are appended here, each can be given to Read
+     *
+     * Returns:
+     *   true on success
+     *
+     * Errors:
+     *   ROOT file can not be opened.
+     */
+    static bool List(const char *Filename, std::vector<std::string> &Runs);
+};
+#endif
@@ -0,0 +1,264 @@
+/********************************************************************
+ *
+ * Module Name : ThreadPool.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Work stealing thread pool.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+
+// Local Includes.
+#include "debug.h"
+#include "ThreadPool.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : ThreadPool constructor
+ *
+ * Description : Make the queues and start the workers.
+ *
+ * Inputs : NThreads - 0 for std::thread::hardware_concurrency
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ThreadPool::ThreadPool(uint32_t NThreads) : fNext(0)
+{
+    SET_DEBUG_STACK;
+    if (NThreads == 0)
+    {
+	NThreads = std::thread::hardware_concurrency();
+	if (NThreads == 0) NThreads = 1;
+    }
+    fPending = 0;
+    fQueued  = 0;
+    fStop    = false;
+    for (uint32_t i=0; i<NThreads; i++)
+    {
+	fQueues.push_back(new Queue);
+    }
+    for (uint32_t i=0; i<NThreads; i++)
+    {
+	fWorkers.push_back(std::thread(&ThreadPool::Run, this, i));
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : ThreadPool destructor
+ *
+ * Description : Finish up, stop and join the workers.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+ThreadPool::~ThreadPool(void)
+{
+    SET_DEBUG_STACK;
+    Wait();
+    {
+	std::lock_guard<std::mutex> lk(fLock);
+	fStop = true;
+    }
+    fWork.notify_all();
+    for (size_t i=0; i<fWorkers.size(); i++)
+    {
+	fWorkers[i].join();
+    }
+    for (size_t i=0; i<fQueues.size(); i++)
+    {
+	delete fQueues[i];
+    }
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Submit
+ *
+ * Description : Deal the task to the next queue round robin and
+ *               wake a worker.
+ *
+ * Inputs : t - task
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ThreadPool::Submit(const Task &t)
+{
+    Queue *q = fQueues[fNext++ % fQueues.size()];
+    {
+	// Counted and queued together, a worker waking sees both.
+	std::lock_guard<std::mutex> lk(fLock);
+	fPending++;
+	fQueued++;
+	std::lock_guard<std::mutex> lq(q->Lock);
+	q->Tasks.push_back(t);
+    }
+    fWork.notify_one();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Wait
+ *
+ * Description : Block until nothing is pending.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ThreadPool::Wait(void)
+{
+    std::unique_lock<std::mutex> lk(fLock);
+    fIdle.wait(lk, [this] {return fPending == 0;});
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Take
+ *
+ * Description : Newest task from our own queue, failing that the
+ *               oldest from someone else's.
+ *
+ * Inputs : Me - worker index
+ *          t  - returned task
+ *
+ * Returns : true if a task was found
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+bool ThreadPool::Take(uint32_t Me, Task &t)
+{
+    const size_t n = fQueues.size();
+    Queue        *q;
+
+    for (size_t k=0; k<n; k++)
+    {
+	q = fQueues[(Me + k) % n];
+	std::lock_guard<std::mutex> lk(q->Lock);
+	if (!q->Tasks.empty())
+	{
+	    if (k == 0)
+	    {
+		t = q->Tasks.back();
+		q->Tasks.pop_back();
+	    }
+	    else
+	    {
+		t = q->Tasks.front();
+		q->Tasks.pop_front();
+	    }
+	    return true;
+	}
+    }
+    return false;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Run
+ *
+ * Description : Worker loop. Run tasks while there are any, sleep
+ *               until one is submitted or the pool stops.
+ *
+ * Inputs : Me - worker index
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ *
+ * Unit Tested on:
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void ThreadPool::Run(uint32_t Me)
+{
+    Task t;
+
+    while (true)
+    {
+	if (Take(Me, t))
+	{
+	    {
+		std::lock_guard<std::mutex> lk(fLock);
+		fQueued--;
+	    }
+	    t(Me);
+	    std::lock_guard<std::mutex> lk(fLock);
+	    if (--fPending == 0)
+	    {
+		fIdle.notify_all();
+	    }
+	    continue;
+	}
+	/*
+	 * Nothing to take. fQueued is counted under fLock with the
+	 * push, so a Submit between the look and the wait is not lost.
+	 */
+	std::unique_lock<std::mutex> lk(fLock);
+	fWork.wait(lk, [this] {return fStop || (fQueued > 0);});
+	if (fStop && (fQueued == 0))
+	{
+	    return;
+	}
+    }
+}
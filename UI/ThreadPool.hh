@@ -0,0 +1,97 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : ThreadPool.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Small work stealing thread pool. Each worker has 
+ *               its own queue. Submit deals tasks round robin onto
+ *               the queues, a worker takes from the back of its own
+ *               queue and when that is empty steals from the front 
+ *               of another. Fits take very different times, a 
+ *               clean curve converges in a few iterations and a bad
+ *               one runs to the limit, stealing keeps every core 
+ *               busy until the last task is done.
+ *
+ *               Each task is handed the index of the worker running
+ *               it so per thread scratch, a DiodeFit for example,
+ *               can be kept in an array indexed by worker.
+ *
+ * Restrictions/Limitations :
+ *               Tasks must not throw.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __THREADPOOL_hh_
+#define __THREADPOOL_hh_
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/// ThreadPool documentation here.
+class ThreadPool {
+public:
+    /*! Task, given the index of the worker running it. */
+    typedef std::function<void(uint32_t)> Task;
+
+    /*!
+     * Description:
+     *   Start the workers.
+     *
+     * Arguments:
+     *   NThreads - number of workers, 0 for one per core.
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   None
+     */
+    ThreadPool(uint32_t NThreads = 0);
+    /*! Waits for outstanding tasks then stops the workers. */
+    ~ThreadPool(void);
+
+    /*! Queue a task. */
+    void Submit(const Task &t);
+
+    /*! Block until every task submitted so far has finished. */
+    void Wait(void);
+
+    inline uint32_t NThreads(void) const {return fWorkers.size();};
+
+private:
+    /*! Worker main loop. */
+    void Run(uint32_t Me);
+    /*! Pop from our own queue or steal, false if there is nothing.*/
+    bool Take(uint32_t Me, Task &t);
+
+    struct Queue {
+	std::mutex       Lock;
+	std::deque<Task> Tasks;
+    };
+
+    std::vector<std::thread> fWorkers;
+    std::vector<Queue*>      fQueues;
+    std::atomic<uint32_t>    fNext;      // Round robin for Submit
+
+    // Sleeping and waking.
+    std::mutex               fLock;
+    std::condition_variable  fWork;      // Something was submitted
+    std::condition_variable  fIdle;      // Pending reached zero
+    uint64_t                 fPending;   // Submitted, not finished
+    uint64_t                 fQueued;    // Submitted, not taken
+    bool                     fStop;
+};
+#endif
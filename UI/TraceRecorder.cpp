@@ -0,0 +1,319 @@
+/********************************************************************
+ *
+ * Module Name : TraceRecorder.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Write each backend call to a trace.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cstring>
+#include <cmath>
+#include <ctime>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "GpibTrace.hh"
+#include "TraceRecorder.hh"
+
+/**
+ ******************************************************************
+ *
+ * Function Name : TraceRecorder constructor
+ *
+ * Description : Open the trace and write its header.
+ *
+ * Inputs : Inner - backend, owned from here on
+ *          File  - trace file
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : file could not be opened
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+TraceRecorder::TraceRecorder(GpibBackend *Inner, const char *File)
+{
+    SET_DEBUG_STACK;
+    CLogger         *LogPtr = CLogger::GetThis();
+    GpibTraceHeader head;
+
+    fInner    = Inner;
+    fNRecords = 0;
+    fLast     = Clock();
+    fStart    = fLast;
+    fFile     = fopen(File, "wb");
+    if (fFile == NULL)
+    {
+	LogPtr->Log("# TraceRecorder: can not open %s\n", File);
+	return;
+    }
+    memset(&head, 0, sizeof(head));
+    memcpy(head.Magic, "IVGT", 4);
+    head.Version       = kGpibTraceVersion;
+    head.MeterAddress  = fInner->MeterOK()  ? fInner->MeterAddress()  : 0;
+    head.SourceAddress = fInner->SourceOK() ? fInner->SourceAddress() : 0;
+    head.T0            = fInner->Now();
+    fwrite(&head, sizeof(head), 1, fFile);
+    LogPtr->Log("# TraceRecorder: GPIB traffic to %s\n", File);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : TraceRecorder destructor
+ *
+ * Description : Close the trace and the backend behind it.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+TraceRecorder::~TraceRecorder(void)
+{
+    SET_DEBUG_STACK;
+    if (fFile)
+    {
+	fclose(fFile);
+	CLogger::GetThis()->Log("# TraceRecorder: %d calls recorded.\n",
+				(int) fNRecords);
+    }
+    delete fInner;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Begin
+ *
+ * Description : Note the time a call starts.
+ *
+ * Inputs : NONE
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceRecorder::Begin(void)
+{
+    fStart = Clock();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Clock
+ *
+ * Description : Time to take call lengths from, the inner backend's
+ *               interval clock. That is its own clock if it keeps
+ *               one, so a simulated run records the times it 
+ *               simulated.
+ *
+ * Inputs : NONE
+ *
+ * Returns : seconds
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double TraceRecorder::Clock(void)
+{
+    return fInner->Elapsed();
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Record
+ *
+ * Description : Write the call begun last. Times are in us and
+ *               saturate rather than wrap.
+ *
+ * Inputs : Call   - GpibBackend::Call
+ *          N      - values
+ *          Values - arguments or answer
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceRecorder::Record(uint8_t Call, uint8_t N, const double *Values)
+{
+    GpibTraceRecord rec;
+    double          delta, duration;
+
+    delta    = 1.0e6*(fStart - fLast);
+    duration = 1.0e6*(Clock() - fStart);
+    fLast    = fStart;
+    if (fFile == NULL) return;
+
+    rec.Call     = Call;
+    rec.N        = N;
+    rec.Spare    = 0;
+    rec.Delta    = (delta < 4.0e9) ? (uint32_t) delta : 0xFFFFFFFF;
+    rec.Duration = (duration < 4.0e9) ? (uint32_t) duration : 0xFFFFFFFF;
+    fwrite(&rec, sizeof(rec), 1, fFile);
+    if (N > 0) fwrite(Values, sizeof(double), N, fFile);
+    fNRecords++;
+    if (Call == kMeterRead) fflush(fFile);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Commands
+ *
+ * Description : Each is passed on to the backend and recorded
+ *               with its arguments.
+ *
+ * Inputs : as GpibBackend
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceRecorder::MeterFunction(bool Current)
+{
+    double v = Current;
+    Begin();
+    fInner->MeterFunction(Current);
+    Record(kMeterFunction, 1, &v);
+}
+void TraceRecorder::MeterRange(uint8_t Range)
+{
+    double v = Range;
+    Begin();
+    fInner->MeterRange(Range);
+    Record(kMeterRange, 1, &v);
+}
+void TraceRecorder::MeterRate(uint8_t Rate)
+{
+    double v = Rate;
+    Begin();
+    fInner->MeterRate(Rate);
+    Record(kMeterRate, 1, &v);
+}
+void TraceRecorder::MeterTrigger(bool OneShot, double Delay)
+{
+    double v[2] = {(double) OneShot, Delay};
+    Begin();
+    fInner->MeterTrigger(OneShot, Delay);
+    Record(kMeterTrigger, 2, v);
+}
+void TraceRecorder::SourceOperate(double Limit)
+{
+    Begin();
+    fInner->SourceOperate(Limit);
+    Record(kSourceOperate, 1, &Limit);
+}
+void TraceRecorder::SourceLimit(double A)
+{
+    Begin();
+    fInner->SourceLimit(A);
+    Record(kSourceLimit, 1, &A);
+}
+void TraceRecorder::SourceVoltage(double V)
+{
+    Begin();
+    fInner->SourceVoltage(V);
+    Record(kSourceVoltage, 1, &V);
+}
+void TraceRecorder::SourceExecute(void)
+{
+    Begin();
+    fInner->SourceExecute();
+    Record(kSourceExecute, 0, NULL);
+}
+void TraceRecorder::SourceProgram(double V, double Base, double Limit,
+				  double Width, double Off)
+{
+    double v[5] = {V, Base, Limit, Width, Off};
+    Begin();
+    fInner->SourceProgram(V, Base, Limit, Width, Off);
+    Record(kSourceProgram, 5, v);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reads
+ *
+ * Description : Passed on, the answer is recorded.
+ *
+ * Inputs : NONE
+ *
+ * Returns : as GpibBackend
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double TraceRecorder::MeterRead(void)
+{
+    double v;
+    Begin();
+    v = fInner->MeterRead();
+    Record(kMeterRead, 1, &v);
+    return v;
+}
+int TraceRecorder::MeterStatus(void)
+{
+    double v;
+    Begin();
+    v = fInner->MeterStatus();
+    Record(kMeterStatus, 1, &v);
+    return (int) v;
+}
@@ -0,0 +1,91 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : TraceRecorder.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Sits in front of a backend, passes each call on and
+ *               writes it to a trace file, see GpibTrace.hh, with
+ *               how long the instrument took over it. The file is
+ *               flushed after every read so a crash keeps all but
+ *               the last few commands.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __TRACERECORDER_hh_
+#define __TRACERECORDER_hh_
+#include <cstdio>
+#include "GpibBackend.hh"
+
+/// TraceRecorder documentation here.
+class TraceRecorder : public GpibBackend {
+public:
+    /*!
+     * Description:
+     *   Start a trace.
+     *
+     * Arguments:
+     *   Inner - backend doing the work, now owned by the recorder
+     *   File  - trace file, overwritten
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   Error() if the file could not be opened, the calls still go
+     *   through to Inner.
+     */
+    TraceRecorder(GpibBackend *Inner, const char *File);
+    ~TraceRecorder(void);
+
+    inline bool     Error(void)    const {return (fFile == NULL);};
+    inline uint32_t NRecords(void) const {return fNRecords;};
+
+    inline bool    MeterOK(void)  const {return fInner->MeterOK();};
+    inline bool    SourceOK(void) const {return fInner->SourceOK();};
+    inline uint8_t MeterAddress(void)  const {return fInner->MeterAddress();};
+    inline uint8_t SourceAddress(void) const {return fInner->SourceAddress();};
+
+    void    MeterFunction(bool Current);
+    void    MeterRange(uint8_t Range);
+    void    MeterRate(uint8_t Rate);
+    void    MeterTrigger(bool OneShot, double Delay);
+    double  MeterRead(void);
+    int     MeterStatus(void);
+
+    void    SourceOperate(double Limit);
+    void    SourceLimit(double A);
+    void    SourceVoltage(double V);
+    void    SourceProgram(double V, double Base, double Limit,
+			  double Width, double Off);
+    void    SourceExecute(void);
+
+    inline void   Wait(double s) {fInner->Wait(s);};
+    inline double Now(void)      {return fInner->Now();};
+    inline double Elapsed(void)  {return fInner->Elapsed();};
+    inline bool   Virtual(void) const {return fInner->Virtual();};
+
+private:
+    /*! Mark the start of a call. */
+    void Begin(void);
+    /*! Write the call begun last with its values. */
+    void Record(uint8_t Call, uint8_t N, const double *Values);
+    /*! Seconds, monotonic or the inner backend's virtual clock. */
+    double Clock(void);
+
+    GpibBackend     *fInner;
+    FILE            *fFile;
+    double          fStart;    /*! Start of the call in hand   */
+    double          fLast;     /*! Start of the one before     */
+    uint32_t        fNRecords;
+};
+#endif
@@ -0,0 +1,343 @@
+/********************************************************************
+ *
+ * Module Name : TraceReplay.cpp
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : Answer backend calls from a GPIB trace.
+ *
+ * Restrictions/Limitations :
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ ********************************************************************/
+// System includes.
+
+#include <iostream>
+using namespace std;
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+// Local Includes.
+#include "debug.h"
+#include "CLogger.hh"
+#include "GpibTrace.hh"
+#include "TraceReplay.hh"
+
+/*! Arguments that differ by less than this, relative, match. */
+const double kReplayMatch = 1.0e-9;
+
+/**
+ ******************************************************************
+ *
+ * Function Name : TraceReplay constructor
+ *
+ * Description : Read the whole trace into memory. A record cut
+ *               short, the recorder stopped mid write, ends the
+ *               trace there.
+ *
+ * Inputs : File     - trace
+ *          RealTime - keep the recorded timing
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : not readable, not a trace or a later version
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+TraceReplay::TraceReplay(const char *File, bool RealTime)
+{
+    SET_DEBUG_STACK;
+    CLogger         *LogPtr = CLogger::GetThis();
+    FILE            *fp;
+    GpibTraceHeader head;
+    GpibTraceRecord rec;
+    double          v[kGpibTraceMaxN];
+
+    fError         = true;
+    fRealTime      = RealTime;
+    fExhausted     = false;
+    fMeterAddress  = 0;
+    fSourceAddress = 0;
+    fT0            = 0.0;
+    fNow           = 0.0;
+    fNext          = 0;
+    fDiverged      = 0;
+
+    if ((fp = fopen(File, "rb")) == NULL)
+    {
+	LogPtr->Log("# TraceReplay: can not open %s\n", File);
+	return;
+    }
+    if ((fread(&head, sizeof(head), 1, fp) != 1) || 
+	(memcmp(head.Magic, "IVGT", 4) != 0) ||
+	(head.Version > kGpibTraceVersion))
+    {
+	LogPtr->Log("# TraceReplay: %s is not a trace this can read.\n", File);
+	fclose(fp);
+	return;
+    }
+    fMeterAddress  = head.MeterAddress;
+    fSourceAddress = head.SourceAddress;
+    fT0            = head.T0;
+    fNow           = head.T0;
+
+    while (fread(&rec, sizeof(rec), 1, fp) == 1)
+    {
+	if ((rec.N > kGpibTraceMaxN) || 
+	    (fread(v, sizeof(double), rec.N, fp) != rec.N))
+	{
+	    LogPtr->Log("# TraceReplay: %s cut short after %d records.\n",
+			File, (int) fCall.size());
+	    break;
+	}
+	fCall.push_back(rec.Call);
+	fDuration.push_back(1.0e-6*rec.Duration);
+	fFirst.push_back(fValue.size());
+	fN.push_back(rec.N);
+	fValue.insert(fValue.end(), v, v + rec.N);
+    }
+    fclose(fp);
+    fError = false;
+    LogPtr->Log("# TraceReplay: %d calls from %s, %s\n", (int) fCall.size(),
+		File, fRealTime ? "real time" : "fast");
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Serve
+ *
+ * Description : The next record if it is this call, with the same
+ *               arguments for a command. A read that does not come
+ *               next in the trace is answered by the next read of
+ *               its kind, a command not in the trace is let go.
+ *
+ * Inputs : Call   - GpibBackend::Call
+ *          N      - arguments
+ *          Values - arguments
+ *
+ * Returns : record served, NRecords() if none
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+uint32_t TraceReplay::Serve(uint8_t Call, uint8_t N, const double *Values)
+{
+    const uint32_t n    = fCall.size();
+    const bool     read = (Call == kMeterRead) || (Call == kMeterStatus);
+    uint32_t       i    = fNext;
+    uint8_t        k;
+
+    if ((i < n) && (fCall[i] == Call))
+    {
+	for (k=0; k<N; k++)
+	{
+	    if ((k >= fN[i]) || 
+		(fabs(fValue[fFirst[i]+k] - Values[k]) > 
+		 kReplayMatch*fmax(1.0, fabs(Values[k]))))
+	    {
+		Diverge(i, Call);
+		break;
+	    }
+	}
+    }
+    else
+    {
+	Diverge(i, Call);
+	if (!read)
+	{
+	    return n;
+	}
+	while ((i < n) && (fCall[i] != Call)) i++;
+    }
+    if (i >= n)
+    {
+	if (!fExhausted)
+	{
+	    CLogger::GetThis()->Log("# TraceReplay: end of the trace.\n");
+	}
+	fExhausted = true;
+	return n;
+    }
+    fNext = i + 1;
+    if (fRealTime)
+    {
+	GpibBackend::Wait(fDuration[i]);
+    }
+    else
+    {
+	fNow += fDuration[i];
+    }
+    return i;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Diverge
+ *
+ * Description : Count a call the trace did not expect, log the
+ *               first.
+ *
+ * Inputs : Record - record the trace had next
+ *          Call   - call made
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceReplay::Diverge(uint32_t Record, uint8_t Call)
+{
+    if (fDiverged == 0)
+    {
+	CLogger::GetThis()->Log("# TraceReplay: diverged at record %d, call %d where the trace has %d\n",
+				(int) Record, (int) Call, 
+				(Record < fCall.size()) ? (int) fCall[Record] : -1);
+    }
+    fDiverged++;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Commands
+ *
+ * Description : Checked against the trace, nothing else to do.
+ *
+ * Inputs : as GpibBackend
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceReplay::MeterFunction(bool Current)
+{
+    double v = Current;
+    Serve(kMeterFunction, 1, &v);
+}
+void TraceReplay::MeterRange(uint8_t Range)
+{
+    double v = Range;
+    Serve(kMeterRange, 1, &v);
+}
+void TraceReplay::MeterRate(uint8_t Rate)
+{
+    double v = Rate;
+    Serve(kMeterRate, 1, &v);
+}
+void TraceReplay::MeterTrigger(bool OneShot, double Delay)
+{
+    double v[2] = {(double) OneShot, Delay};
+    Serve(kMeterTrigger, 2, v);
+}
+void TraceReplay::SourceOperate(double Limit)
+{
+    Serve(kSourceOperate, 1, &Limit);
+}
+void TraceReplay::SourceLimit(double A)
+{
+    Serve(kSourceLimit, 1, &A);
+}
+void TraceReplay::SourceVoltage(double V)
+{
+    Serve(kSourceVoltage, 1, &V);
+}
+void TraceReplay::SourceExecute(void)
+{
+    Serve(kSourceExecute, 0, NULL);
+}
+void TraceReplay::SourceProgram(double V, double Base, double Limit,
+				double Width, double Off)
+{
+    double v[5] = {V, Base, Limit, Width, Off};
+    Serve(kSourceProgram, 5, v);
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Reads
+ *
+ * Description : The recorded answer.
+ *
+ * Inputs : NONE
+ *
+ * Returns : reading, NaN past the end of the trace
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+double TraceReplay::MeterRead(void)
+{
+    uint32_t i = Serve(kMeterRead, 0, NULL);
+    return ((i < fCall.size()) && (fN[i] > 0)) ? fValue[fFirst[i]] : NAN;
+}
+int TraceReplay::MeterStatus(void)
+{
+    uint32_t i = Serve(kMeterStatus, 0, NULL);
+    return ((i < fCall.size()) && (fN[i] > 0)) ? (int) fValue[fFirst[i]] : 0;
+}
+/**
+ ******************************************************************
+ *
+ * Function Name : Wait
+ *
+ * Description : Sleep in real time, move the clock on when fast.
+ *
+ * Inputs : s - seconds
+ *
+ * Returns : NONE
+ *
+ * Error Conditions : NONE
+ * 
+ * Unit Tested on: 
+ *
+ * Unit Tested by: CBL
+ *
+ *
+ *******************************************************************
+ */
+void TraceReplay::Wait(double s)
+{
+    if (fRealTime)
+    {
+	GpibBackend::Wait(s);
+    }
+    else if (s > 0.0)
+    {
+	fNow += s;
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ ******************************************************************
+ *
+ * Module Name : TraceReplay.hh
+ *
+ * Author/Date : C.B. Lirakis / 18-Oct-26
+ *
+ * Description : A backend that answers from a GPIB trace instead of
+ *               the instruments. The trace is read into memory at
+ *               the start and served in order, each read gets the
+ *               reading recorded for it.
+ *
+ *               Real time - each call takes as long as it did when
+ *                           recorded and waits sleep, the run goes
+ *                           as it went in the lab.
+ *               Fast      - no call or wait takes any time, for
+ *                           benchmarks and tests. The clock starts
+ *                           at the start of the recording and each
+ *                           call moves it on by as long as it took
+ *                           then, each wait by what was asked.
+ *
+ *               The same recipe gives the same calls, so a replay
+ *               follows the trace exactly. If the program asks for
+ *               something else, a changed recipe or code, the
+ *               replay has diverged: that is logged once, commands
+ *               are let go and each read is answered from the next
+ *               read in the trace. Past the end of the trace reads
+ *               are NaN and Exhausted() is set.
+ *
+ * Restrictions/Limitations :
+ *               Fast replay times are those of the recording only
+ *               as long as the replay follows it.
+ *
+ * Change Descriptions :
+ *
+ * Classification : Unclassified
+ *
+ * References :
+ *
+ *******************************************************************
+ */
+#ifndef __TRACEREPLAY_hh_
+#define __TRACEREPLAY_hh_
+#include <vector>
+#include "GpibBackend.hh"
+
+/// TraceReplay documentation here.
+class TraceReplay : public GpibBackend {
+public:
+    /*!
+     * Description:
+     *   Read a trace.
+     *
+     * Arguments:
+     *   File     - trace from TraceRecorder
+     *   RealTime - keep the recorded timing, otherwise as fast as
+     *              possible
+     *
+     * Returns:
+     *   None
+     *
+     * Errors:
+     *   Error() if the file could not be read or is not a trace.
+     */
+    TraceReplay(const char *File, bool RealTime);
+
+    inline bool     Error(void)     const {return fError;};
+    inline bool     Exhausted(void) const {return fExhausted;};
+    inline uint32_t NRecords(void)  const {return fCall.size();};
+    /*! Records served and calls that did not match the trace. */
+    inline uint32_t Position(void)  const {return fNext;};
+    inline uint32_t Diverged(void)  const {return fDiverged;};
+    /*! Start of the recording, s since the epoch. */
+    inline double   T0(void)        const {return fT0;};
+
+    inline bool    MeterOK(void)  const {return !fError;};
+    inline bool    SourceOK(void) const {return !fError;};
+    inline uint8_t MeterAddress(void)  const {return fMeterAddress;};
+    inline uint8_t SourceAddress(void) const {return fSourceAddress;};
+
+    void    MeterFunction(bool Current);
+    void    MeterRange(uint8_t Range);
+    void    MeterRate(uint8_t Rate);
+    void    MeterTrigger(bool OneShot, double Delay);
+    double  MeterRead(void);
+    int     MeterStatus(void);
+
+    void    SourceOperate(double Limit);
+    void    SourceLimit(double A);
+    void    SourceVoltage(double V);
+    void    SourceProgram(double V, double Base, double Limit,
+			  double Width, double Off);
+    void    SourceExecute(void);
+
+    void    Wait(double s);
+    inline double Now(void)
+	{return fRealTime ? GpibBackend::Now() : fNow;};
+    inline double Elapsed(void)
+	{return fRealTime ? GpibBackend::Elapsed() : fNow;};
+    inline bool   Virtual(void) const {return !fRealTime;};
+
+private:
+    /*!
+     * Description:
+     *   Serve the next record for a call. A command's arguments are
+     *   checked against those recorded.
+     *
+     * Arguments:
+     *   Call   - GpibBackend::Call
+     *   N      - arguments given, 0 for a read
+     *   Values - arguments
+     *
+     * Returns:
+     *   record served, NRecords() if none.
+     *
+     * Errors:
+     *   NONE
+     */
+    uint32_t Serve(uint8_t Call, uint8_t N, const double *Values);
+
+    /*! Note a divergence, logged the first time. */
+    void     Diverge(uint32_t Record, uint8_t Call);
+
+    bool     fError;
+    bool     fRealTime;
+    bool     fExhausted;
+    uint8_t  fMeterAddress;
+    uint8_t  fSourceAddress;
+    double   fT0;
+    double   fNow;      /*! Clock when fast            */
+    std::vector<uint8_t>  fCall;     /*! Per record                */
+    std::vector<float>    fDuration; /*! s                         */
+    std::vector<uint32_t> fFirst;    /*! First value in fValue     */
+    std::vector<uint8_t>  fN;
+    std::vector<double>   fValue;
+    uint32_t fNext;
+    uint32_t fDiverged;
+};
+#endif